@@ -203,15 +203,15 @@ static inline BOOL _IsMacFinder(DZWebServerRequest* request) {
     });
   }
 
-  if ([request hasByteRange]) {
-    return [DZWebServerFileResponse responseWithFile:absolutePath byteRange:request.byteRange];
+  if (request.byteRanges) {
+    return [DZWebServerFileResponse responseWithFile:absolutePath byteRanges:request.byteRanges isAttachment:NO];
   }
 
   return [DZWebServerFileResponse responseWithFile:absolutePath];
 }
 
 - (DZWebServerResponse*)performPUT:(DZWebServerFileRequest*)request {
-  if ([request hasByteRange]) {
+  if (request.byteRanges) {
     return [DZWebServerErrorResponse responseWithClientError:kDZWebServerHTTPStatusCode_BadRequest message:@"Range uploads not supported"];
   }
 
@@ -236,9 +236,8 @@ static inline BOOL _IsMacFinder(DZWebServerRequest* request) {
     return [DZWebServerErrorResponse responseWithClientError:kDZWebServerHTTPStatusCode_Forbidden message:@"Uploading file to \"%@\" is not permitted", relativePath];
   }
 
-  [[NSFileManager defaultManager] removeItemAtPath:absolutePath error:NULL];
   NSError* error = nil;
-  if (![[NSFileManager defaultManager] moveItemAtPath:request.temporaryPath toPath:absolutePath error:&error]) {
+  if (![request moveTemporaryFileToPath:absolutePath error:&error]) {  // Replaces any existing file atomically
     return [DZWebServerErrorResponse responseWithServerError:kDZWebServerHTTPStatusCode_InternalServerError underlyingError:error message:@"Failed moving uploaded file to \"%@\"", relativePath];
   }
 
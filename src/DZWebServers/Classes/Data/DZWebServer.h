@@ -101,6 +101,45 @@ typedef void (^DZWebServerCompletionBlock)(DZWebServerResponse* _Nullable respon
  */
 typedef void (^DZWebServerAsyncProcessBlock)(__kindof DZWebServerRequest* request, DZWebServerCompletionBlock completionBlock);
 
+/**
+ *  @brief Block used to cheaply describe the current version of the resource a
+ *  request targets before the handler's process block runs.
+ *
+ *  The returned response is only used for its validators: @c eTag,
+ *  @c lastModifiedDate and @c cacheControlMaxAge. It is evaluated against the
+ *  request's conditional headers (@c If-None-Match, @c If-Modified-Since,
+ *  @c If-Match, @c If-Unmodified-Since) exactly like a final response would be.
+ *  When a precondition applies, the connection replies with a 304 Not Modified or
+ *  412 Precondition Failed response directly and the process block is never called.
+ *
+ *  @param request The fully received request object.
+ *
+ *  @return A response with validators describing the resource, typically
+ *          @c [DZWebServerResponse response] with @c eTag and / or
+ *          @c lastModifiedDate set, or @c nil to always call the process block.
+ *
+ *  @see -addHandlerWithMatchBlock:validatorBlock:asyncProcessBlock:
+ */
+typedef DZWebServerResponse* _Nullable (^DZWebServerValidatorBlock)(__kindof DZWebServerRequest* request);
+
+/**
+ *  @brief Block used to decide whether a request body should be received at all.
+ *
+ *  Called once the request headers have been received and before any of the
+ *  body is read, including before replying @c 100 Continue to a client that
+ *  sent an @c Expect: 100-continue header. Returning a response sends it as the
+ *  final response and closes the connection without reading the body, so
+ *  rejected uploads don't consume bandwidth or disk space.
+ *
+ *  @param request The request object, whose body has not been received yet.
+ *
+ *  @return A response rejecting the body (typically a 401, 403, 413 or 417
+ *          @c DZWebServerErrorResponse), or @c nil to receive the body.
+ *
+ *  @see -addHandlerWithMatchBlock:bodyAcceptanceBlock:validatorBlock:asyncProcessBlock:
+ */
+typedef DZWebServerResponse* _Nullable (^DZWebServerBodyAcceptanceBlock)(__kindof DZWebServerRequest* request);
+
 /**
  *  @brief Block used to override the built-in logger at runtime.
  *
@@ -342,6 +381,351 @@ extern NSString* const DZWebServerOption_ConnectedStateCoalescingInterval;
  */
 extern NSString* const DZWebServerOption_DispatchQueuePriority;
 
+/**
+ *  @brief Option key specifying the total size in bytes of the in-memory file
+ *         content cache (@c NSNumber / @c NSUInteger).
+ *
+ *  When non-zero, the directory handlers added with
+ *  @c -addGETHandlerForBasePath:directoryPath:indexFilename:cacheAge:allowRangeRequests:
+ *  keep the contents of small files in memory, together with their MIME type,
+ *  ETag and last modification date, and serve subsequent requests directly
+ *  from memory. Entries are evicted in least-recently-used order once the total
+ *  size of the cached contents exceeds this value.
+ *
+ *  Each cache hit is validated with a single @c lstat() call: an entry is
+ *  discarded as soon as the device, inode, size or modification time of the
+ *  file on disk changes.
+ *
+ *  The default value is @c 0 (caching disabled).
+ *
+ *  @see DZWebServerOption_MaxFileCacheEntrySize
+ */
+extern NSString* const DZWebServerOption_MaxFileCacheSize;
+
+/**
+ *  @brief Option key specifying the largest file in bytes eligible for the
+ *         in-memory file content cache (@c NSNumber / @c NSUInteger).
+ *
+ *  Files larger than this value are always streamed from disk.
+ *
+ *  The default value is @c 65536 (64 KiB).
+ *
+ *  @note This option has no effect if @c DZWebServerOption_MaxFileCacheSize
+ *        is @c 0.
+ *
+ *  @see DZWebServerOption_MaxFileCacheSize
+ */
+extern NSString* const DZWebServerOption_MaxFileCacheEntrySize;
+
+/**
+ *  @brief Option key to serve precompressed sibling files from directory
+ *         handlers (@c NSNumber / @c BOOL).
+ *
+ *  When enabled, the directory handlers added with
+ *  @c -addGETHandlerForBasePath:directoryPath:indexFilename:cacheAge:allowRangeRequests:
+ *  look for @c file.br, @c file.zst and @c file.gz next to a requested
+ *  @c file and serve the one best matching the request's @c Accept-Encoding
+ *  header, with the corresponding @c Content-Encoding header, a
+ *  @c Vary: @c Accept-Encoding header and the exact @c Content-Length of the
+ *  precompressed file. Byte ranges apply to the precompressed bytes. Variants
+ *  older than the original file are ignored.
+ *
+ *  This avoids compressing static assets at runtime entirely when they are
+ *  precompressed as part of the build.
+ *
+ *  The default value is @c NO.
+ *
+ *  @see DZWebServerFileResponse
+ */
+extern NSString* const DZWebServerOption_ServePrecompressedFiles;
+
+/**
+ *  @brief Option key specifying the content codings used for automatic
+ *         response encoding, in server preference order
+ *         (@c NSArray of @c NSString).
+ *
+ *  Responses with @c automaticContentEncodingEnabled set are encoded with the
+ *  coding from this list that the client weighs highest in its
+ *  @c Accept-Encoding header. When several codings have the same quality
+ *  value, the one appearing first in this list is used. Codings without a
+ *  registered encoder are ignored.
+ *
+ *  The default value is the result of
+ *  @c +[DZWebServerResponse registeredContentEncodings], i.e. @c @[@"gzip"] in
+ *  the default build, or @c @[@"br", @"zstd", @"gzip"] when the application
+ *  links libbrotlienc and libzstd and builds DZWebServer with
+ *  @c __DZWEBSERVER_ENABLE_BROTLI__ and @c __DZWEBSERVER_ENABLE_ZSTD__.
+ *
+ *  @see DZWebServerResponse.automaticContentEncodingEnabled
+ */
+extern NSString* const DZWebServerOption_ContentEncodings;
+
+/**
+ *  @brief Option key specifying the gzip compression level
+ *         (@c NSNumber / @c NSInteger).
+ *
+ *  Ranges from @c 1 (fastest) to @c 9 (smallest output).
+ *
+ *  The default value is @c -1 (@c Z_DEFAULT_COMPRESSION, equivalent to @c 6).
+ */
+extern NSString* const DZWebServerOption_GZipCompressionLevel;
+
+/**
+ *  @brief Option key specifying the base two logarithm of the gzip window size
+ *         (@c NSNumber / @c NSInteger).
+ *
+ *  Ranges from @c 9 to @c 15. Smaller windows use less memory per response at
+ *  the expense of compression ratio.
+ *
+ *  The default value is @c 15.
+ */
+extern NSString* const DZWebServerOption_GZipWindowBits;
+
+/**
+ *  @brief Option key specifying the smallest response body in bytes compressed
+ *         with the parallel gzip encoder (@c NSNumber / @c NSUInteger).
+ *
+ *  Responses of known length at least this large are split into independent
+ *  blocks compressed concurrently on multiple cores, each primed with the end
+ *  of the previous block as dictionary, and emitted in order as a single valid
+ *  gzip stream. Output is slightly larger than with the serial encoder.
+ *  Responses of unknown length always use the serial encoder.
+ *
+ *  The default value is @c 0 (parallel compression disabled).
+ *
+ *  @see DZWebServerOption_ParallelGZipBlockSize
+ *  @see DZWebServerOption_ParallelGZipMaxBlocksInFlight
+ */
+extern NSString* const DZWebServerOption_ParallelGZipMinimumSize;
+
+/**
+ *  @brief Option key specifying the uncompressed size in bytes of each block
+ *         compressed by the parallel gzip encoder (@c NSNumber / @c NSUInteger).
+ *
+ *  The default value is @c 131072 (128 KiB).
+ */
+extern NSString* const DZWebServerOption_ParallelGZipBlockSize;
+
+/**
+ *  @brief Option key specifying how many blocks the parallel gzip encoder
+ *         reads ahead and compresses concurrently per response
+ *         (@c NSNumber / @c NSUInteger).
+ *
+ *  This bounds the memory used by a response to about this many blocks of
+ *  input and compressed output.
+ *
+ *  The default value is twice the number of active processors.
+ */
+extern NSString* const DZWebServerOption_ParallelGZipMaxBlocksInFlight;
+
+/**
+ *  @brief Option key specifying the brotli compression quality
+ *         (@c NSNumber / @c NSInteger).
+ *
+ *  Ranges from @c 0 (fastest) to @c 11 (smallest output). Qualities above
+ *  @c 6 are generally too slow for compressing dynamic responses on the fly.
+ *
+ *  The default value is @c 5.
+ *
+ *  @note This option has no effect unless DZWebServer is built with
+ *        @c __DZWEBSERVER_ENABLE_BROTLI__.
+ */
+extern NSString* const DZWebServerOption_BrotliCompressionQuality;
+
+/**
+ *  @brief Option key specifying the base two logarithm of the brotli window
+ *         size (@c NSNumber / @c NSInteger).
+ *
+ *  Ranges from @c 10 to @c 24.
+ *
+ *  The default value is @c 22.
+ *
+ *  @note This option has no effect unless DZWebServer is built with
+ *        @c __DZWEBSERVER_ENABLE_BROTLI__.
+ */
+extern NSString* const DZWebServerOption_BrotliWindowBits;
+
+/**
+ *  @brief Option key specifying the zstd compression level
+ *         (@c NSNumber / @c NSInteger).
+ *
+ *  Negative levels trade compression ratio for speed, and levels above @c 19
+ *  should not be used for on the fly compression.
+ *
+ *  The default value is @c 3.
+ *
+ *  @note This option has no effect unless DZWebServer is built with
+ *        @c __DZWEBSERVER_ENABLE_ZSTD__.
+ */
+extern NSString* const DZWebServerOption_ZstdCompressionLevel;
+
+/**
+ *  @brief Option key specifying the base two logarithm of the zstd window size
+ *         (@c NSNumber / @c NSInteger).
+ *
+ *  Ranges from @c 10 to @c 31. Clients are only required to support windows
+ *  of up to 8 MiB (@c 23).
+ *
+ *  The default value is @c 0 (derived from the compression level).
+ *
+ *  @note This option has no effect unless DZWebServer is built with
+ *        @c __DZWEBSERVER_ENABLE_ZSTD__.
+ */
+extern NSString* const DZWebServerOption_ZstdWindowLog;
+
+/**
+ *  @brief Option key specifying the smallest response body in bytes eligible
+ *         for automatic content encoding (@c NSNumber / @c NSUInteger).
+ *
+ *  Responses whose @c contentLength is known and below this value are sent
+ *  uncompressed with their @c Content-Length header, since compressing them
+ *  costs CPU for little or no size reduction. Responses of unknown length are
+ *  always eligible.
+ *
+ *  The default value is @c 1024.
+ *
+ *  @see DZWebServer.compressionSkippedForSizeCount
+ */
+extern NSString* const DZWebServerOption_CompressionMinimumSize;
+
+/**
+ *  @brief Option key specifying the MIME types eligible for automatic content
+ *         encoding (@c NSArray of @c NSString).
+ *
+ *  Entries are matched case-insensitively against the beginning of the
+ *  response content type without its parameters, so @c @"text/" matches all
+ *  text types.
+ *
+ *  The default value is @c nil, which allows text types, JSON, XML (including
+ *  @c +json and @c +xml types), JavaScript, WebAssembly and uncompressed font
+ *  and icon formats, and excludes already compressed formats such as images,
+ *  audio, video and archives.
+ *
+ *  @see DZWebServer.compressionSkippedForContentTypeCount
+ */
+extern NSString* const DZWebServerOption_CompressibleContentTypes;
+
+/**
+ *  @brief Option key specifying the system load above which automatic content
+ *         encoding uses the fastest compression level (@c NSNumber / @c double).
+ *
+ *  The value is compared to the one-minute load average divided by the number
+ *  of active processors, sampled at most once per second. While above the
+ *  threshold, gzip, brotli and zstd encoders run at level @c 1 regardless of
+ *  their configured level, trading compression ratio for CPU time.
+ *
+ *  The default value is @c 0.8. Pass @c 0 to disable.
+ *
+ *  @see DZWebServer.reducedLevelCompressedResponseCount
+ */
+extern NSString* const DZWebServerOption_CompressionLoadThreshold;
+
+/**
+ *  @brief Option key specifying the total size in bytes of the in-memory cache
+ *         of encoded response bodies (@c NSNumber / @c NSUInteger).
+ *
+ *  When non-zero, automatically encoded @c DZWebServerDataResponse and
+ *  @c DZWebServerFileResponse bodies with an @c ETag are compressed once per
+ *  content encoding and served from memory afterwards, with a known
+ *  @c Content-Length header instead of chunked transfer encoding. Concurrent
+ *  first requests for the same representation wait for a single compression
+ *  pass. Entries are evicted in least-recently-used order once the total size
+ *  of the cached bodies exceeds this value.
+ *
+ *  The default value is @c 0 (caching disabled).
+ *
+ *  @see DZWebServerOption_MaxEncodedContentCacheEntrySize
+ */
+extern NSString* const DZWebServerOption_MaxEncodedContentCacheSize;
+
+/**
+ *  @brief Option key specifying the largest uncompressed response body in
+ *         bytes eligible for the encoded response body cache
+ *         (@c NSNumber / @c NSUInteger).
+ *
+ *  Larger bodies are always encoded on the fly while streaming.
+ *
+ *  The default value is @c 1048576 (1 MiB).
+ *
+ *  @note This option has no effect if
+ *        @c DZWebServerOption_MaxEncodedContentCacheSize is @c 0.
+ */
+extern NSString* const DZWebServerOption_MaxEncodedContentCacheEntrySize;
+
+/**
+ *  @brief Option key specifying the largest request body in bytes accepted
+ *         after removing its content codings (@c NSNumber / @c NSUInteger).
+ *
+ *  Request bodies sent with a @c Content-Encoding header are decoded as they
+ *  are received. The decoded size is checked after each decoding step, so a
+ *  small compressed body expanding to a huge one ("zip bomb") is rejected with
+ *  a @c 413 status without ever being held in memory.
+ *
+ *  The default value is @c 0 (no limit).
+ *
+ *  @see +[DZWebServerRequest registerContentEncoding:withDecoderBlock:]
+ */
+extern NSString* const DZWebServerOption_MaxDecodedBodySize;
+
+/**
+ *  @brief Option key specifying the largest request body in bytes the server
+ *         accepts to receive (@c NSNumber / @c NSUInteger).
+ *
+ *  Requests declaring a larger @c Content-Length are answered with a @c 413
+ *  status as soon as their headers are received, without reading the body or
+ *  replying @c 100 Continue.
+ *
+ *  The default value is @c 0 (no limit).
+ */
+extern NSString* const DZWebServerOption_MaxRequestBodySize;
+
+/**
+ *  @brief Option key specifying how many request body bytes the server may hold
+ *         in memory across all connections (@c NSNumber / @c NSUInteger).
+ *
+ *  Bodies received by @c DZWebServerDataRequest and its subclasses, and the
+ *  in-memory part of @c DZWebServerHybridRequest bodies, are buffered in memory.
+ *  Their bytes are reserved against this budget after any content decoding, as
+ *  they are appended, and released when the request is deallocated or a hybrid
+ *  body moves to disk. A request whose body would exceed the budget is answered
+ *  with a @c 503 status, so a burst of concurrent uploads or a highly
+ *  compressed body cannot exhaust memory. Requests streaming their body to disk
+ *  are not counted.
+ *
+ *  The default value is @c 0 (no limit).
+ */
+extern NSString* const DZWebServerOption_MaxBufferedRequestBodySize;
+
+/**
+ *  @brief Option key to automatically give in-memory responses a strong ETag
+ *         (@c NSNumber / @c BOOL).
+ *
+ *  When enabled, a successful @c DZWebServerDataResponse without an @c eTag
+ *  gets one computed from a 64-bit XXH64 hash of its body before conditional
+ *  headers are evaluated. Unchanged JSON or HTML results can then be answered
+ *  with a 304 Not Modified, and their encoded bodies can be shared through
+ *  @c DZWebServerOption_MaxEncodedContentCacheSize.
+ *
+ *  Responses that already have an @c eTag are left untouched.
+ *
+ *  The default value is @c NO.
+ */
+extern NSString* const DZWebServerOption_AutomaticallyComputeETags;
+
+/**
+ *  @brief Option key to report request phase durations in a @c Server-Timing
+ *         header (@c NSNumber / @c BOOL).
+ *
+ *  When enabled, responses include a @c Server-Timing header with the time
+ *  spent receiving and parsing the request (@c parse) and in the handler
+ *  (@c handler), in milliseconds. Responses using chunked transfer encoding
+ *  also send a @c Server-Timing trailer with the time spent streaming the body
+ *  (@c stream).
+ *
+ *  The default value is @c NO.
+ */
+extern NSString* const DZWebServerOption_AutomaticallySendServerTiming;
+
 #if TARGET_OS_IPHONE
 
 /**
@@ -621,6 +1005,59 @@ extern NSString* const DZWebServerAuthenticationMethod_DigestAccess;
  */
 - (void)addHandlerWithMatchBlock:(DZWebServerMatchBlock)matchBlock asyncProcessBlock:(DZWebServerAsyncProcessBlock)processBlock;
 
+/**
+ *  @brief Adds a handler with custom match logic, a validator stage and
+ *  asynchronous response generation.
+ *
+ *  Works like @c -addHandlerWithMatchBlock:asyncProcessBlock: except that the
+ *  validator block is called first for each matched request. When the validators
+ *  it returns satisfy the request's conditional headers, the connection replies
+ *  with a 304 (or 412) response without calling the process block, which avoids
+ *  building responses that would be discarded on revalidation.
+ *
+ *  @param matchBlock     A block that inspects the incoming request metadata and
+ *                        returns a @c DZWebServerRequest instance if this handler
+ *                        should process it, or @c nil to pass.
+ *  @param validatorBlock A block that cheaply returns the validators of the
+ *                        requested resource, or @c nil to skip the validator stage.
+ *  @param processBlock   A block that receives the fully loaded request and must
+ *                        call the provided completion block with a response.
+ *
+ *  @warning Adding handlers while the server is running is not allowed.
+ *
+ *  @see DZWebServerValidatorBlock
+ */
+- (void)addHandlerWithMatchBlock:(DZWebServerMatchBlock)matchBlock validatorBlock:(nullable DZWebServerValidatorBlock)validatorBlock asyncProcessBlock:(DZWebServerAsyncProcessBlock)processBlock;
+
+/**
+ *  @brief Adds a handler with custom match logic, a body acceptance stage, a
+ *  validator stage and asynchronous response generation.
+ *
+ *  Works like @c -addHandlerWithMatchBlock:validatorBlock:asyncProcessBlock:
+ *  except that, for requests with a body, the body acceptance block is called
+ *  before the body is received. It can reject the body, for instance based on
+ *  its declared @c Content-Length or @c Content-Type, and the connection then
+ *  replies immediately without reading it.
+ *
+ *  @param matchBlock          A block that inspects the incoming request metadata and
+ *                             returns a @c DZWebServerRequest instance if this handler
+ *                             should process it, or @c nil to pass.
+ *  @param bodyAcceptanceBlock A block that returns a response rejecting the request
+ *                             body, or @c nil to always receive it.
+ *  @param validatorBlock      A block that cheaply returns the validators of the
+ *                             requested resource, or @c nil to skip the validator stage.
+ *  @param processBlock        A block that receives the fully loaded request and must
+ *                             call the provided completion block with a response.
+ *
+ *  @warning Adding handlers while the server is running is not allowed.
+ *
+ *  @see DZWebServerBodyAcceptanceBlock
+ */
+- (void)addHandlerWithMatchBlock:(DZWebServerMatchBlock)matchBlock
+             bodyAcceptanceBlock:(nullable DZWebServerBodyAcceptanceBlock)bodyAcceptanceBlock
+                  validatorBlock:(nullable DZWebServerValidatorBlock)validatorBlock
+               asyncProcessBlock:(DZWebServerAsyncProcessBlock)processBlock;
+
 /**
  *  @brief Removes all handlers previously added to the server.
  *
@@ -720,6 +1157,49 @@ extern NSString* const DZWebServerAuthenticationMethod_DigestAccess;
  */
 @property(nonatomic, readonly, nullable) NSURL* publicServerURL;
 
+/**
+ *  @brief The number of responses compressed through automatic content encoding.
+ *
+ *  Includes the responses counted in @c reducedLevelCompressedResponseCount.
+ *  Counters are cumulative over the lifetime of the server and safe to read
+ *  from any thread.
+ *
+ *  @see DZWebServerResponse.automaticContentEncodingEnabled
+ */
+@property(nonatomic, readonly) NSUInteger compressedResponseCount;
+
+/**
+ *  @brief The number of responses compressed at the fastest level because the
+ *         system was under heavy load.
+ *
+ *  @see DZWebServerOption_CompressionLoadThreshold
+ */
+@property(nonatomic, readonly) NSUInteger reducedLevelCompressedResponseCount;
+
+/**
+ *  @brief The number of responses sent uncompressed because their body was
+ *         smaller than the minimum compression size.
+ *
+ *  @see DZWebServerOption_CompressionMinimumSize
+ */
+@property(nonatomic, readonly) NSUInteger compressionSkippedForSizeCount;
+
+/**
+ *  @brief The number of responses sent uncompressed because their content type
+ *         is not compressible (e.g., images or archives).
+ *
+ *  @see DZWebServerOption_CompressibleContentTypes
+ */
+@property(nonatomic, readonly) NSUInteger compressionSkippedForContentTypeCount;
+
+/**
+ *  @brief The number of request body bytes currently held in memory and counted
+ *         against @c DZWebServerOption_MaxBufferedRequestBodySize.
+ *
+ *  Always @c 0 when no budget is configured. Safe to read from any thread.
+ */
+@property(nonatomic, readonly) NSUInteger bufferedRequestBodySize;
+
 /**
  *  @brief Starts the server with default settings.
  *
@@ -931,6 +1411,10 @@ extern NSString* const DZWebServerAuthenticationMethod_DigestAccess;
  *  the provided static data. The response includes a @c Cache-Control header
  *  with the specified max-age.
  *
+ *  When a content type is provided, the response headers and a strong @c ETag
+ *  are computed once when the handler is added, and each response is sent with
+ *  a single write unless it needs to be modified (for instance to compress it).
+ *
  *  @param path        The URL path to match (must start with @c @@"/").
  *  @param staticData  The data to serve as the response body.
  *  @param contentType The MIME type for the @c Content-Type header, or @c nil.
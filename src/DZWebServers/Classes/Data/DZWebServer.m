@@ -38,6 +38,8 @@
 #endif
 #endif
 #import <netinet/in.h>
+#import <sys/stat.h>
+#import <stdatomic.h>
 #import <dns_sd.h>
 
 #import "DZWebServerPrivate.h"
@@ -49,6 +51,7 @@
 #endif
 
 #define kBonjourResolutionTimeout 5.0
+#define kNegativeLookupCacheCountLimit 1024
 
 NSString* const DZWebServerOption_Port = @"Port";
 NSString* const DZWebServerOption_BonjourName = @"BonjourName";
@@ -65,6 +68,29 @@ NSString* const DZWebServerOption_ConnectionClass = @"ConnectionClass";
 NSString* const DZWebServerOption_AutomaticallyMapHEADToGET = @"AutomaticallyMapHEADToGET";
 NSString* const DZWebServerOption_ConnectedStateCoalescingInterval = @"ConnectedStateCoalescingInterval";
 NSString* const DZWebServerOption_DispatchQueuePriority = @"DispatchQueuePriority";
+NSString* const DZWebServerOption_MaxFileCacheSize = @"MaxFileCacheSize";
+NSString* const DZWebServerOption_MaxFileCacheEntrySize = @"MaxFileCacheEntrySize";
+NSString* const DZWebServerOption_ServePrecompressedFiles = @"ServePrecompressedFiles";
+NSString* const DZWebServerOption_ContentEncodings = @"ContentEncodings";
+NSString* const DZWebServerOption_GZipCompressionLevel = @"GZipCompressionLevel";
+NSString* const DZWebServerOption_GZipWindowBits = @"GZipWindowBits";
+NSString* const DZWebServerOption_ParallelGZipMinimumSize = @"ParallelGZipMinimumSize";
+NSString* const DZWebServerOption_ParallelGZipBlockSize = @"ParallelGZipBlockSize";
+NSString* const DZWebServerOption_ParallelGZipMaxBlocksInFlight = @"ParallelGZipMaxBlocksInFlight";
+NSString* const DZWebServerOption_BrotliCompressionQuality = @"BrotliCompressionQuality";
+NSString* const DZWebServerOption_BrotliWindowBits = @"BrotliWindowBits";
+NSString* const DZWebServerOption_ZstdCompressionLevel = @"ZstdCompressionLevel";
+NSString* const DZWebServerOption_ZstdWindowLog = @"ZstdWindowLog";
+NSString* const DZWebServerOption_CompressionMinimumSize = @"CompressionMinimumSize";
+NSString* const DZWebServerOption_CompressibleContentTypes = @"CompressibleContentTypes";
+NSString* const DZWebServerOption_CompressionLoadThreshold = @"CompressionLoadThreshold";
+NSString* const DZWebServerOption_MaxEncodedContentCacheSize = @"MaxEncodedContentCacheSize";
+NSString* const DZWebServerOption_MaxEncodedContentCacheEntrySize = @"MaxEncodedContentCacheEntrySize";
+NSString* const DZWebServerOption_MaxDecodedBodySize = @"MaxDecodedBodySize";
+NSString* const DZWebServerOption_MaxRequestBodySize = @"MaxRequestBodySize";
+NSString* const DZWebServerOption_MaxBufferedRequestBodySize = @"MaxBufferedRequestBodySize";
+NSString* const DZWebServerOption_AutomaticallyComputeETags = @"AutomaticallyComputeETags";
+NSString* const DZWebServerOption_AutomaticallySendServerTiming = @"AutomaticallySendServerTiming";
 #if TARGET_OS_IPHONE
 NSString* const DZWebServerOption_AutomaticallySuspendInBackground = @"AutomaticallySuspendInBackground";
 #endif
@@ -80,6 +106,8 @@ DZWebServerLoggingLevel DZWebServerLogLevel = kDZWebServerLoggingLevel_Info;
 #endif
 #endif
 
+static NSString* _digestAuthenticationNonce = nil;
+
 #if !TARGET_OS_IPHONE
 static BOOL _run;
 #endif
@@ -135,9 +163,11 @@ static void _ExecuteMainThreadRunLoopSources(void) {
 
 @implementation DZWebServerHandler
 
-- (instancetype)initWithMatchBlock:(DZWebServerMatchBlock _Nonnull)matchBlock asyncProcessBlock:(DZWebServerAsyncProcessBlock _Nonnull)processBlock {
+- (instancetype)initWithMatchBlock:(DZWebServerMatchBlock _Nonnull)matchBlock bodyAcceptanceBlock:(DZWebServerBodyAcceptanceBlock _Nullable)bodyAcceptanceBlock validatorBlock:(DZWebServerValidatorBlock _Nullable)validatorBlock asyncProcessBlock:(DZWebServerAsyncProcessBlock _Nonnull)processBlock {
   if ((self = [super init])) {
     _matchBlock = [matchBlock copy];
+    _bodyAcceptanceBlock = [bodyAcceptanceBlock copy];
+    _validatorBlock = [validatorBlock copy];
     _asyncProcessBlock = [processBlock copy];
   }
   return self;
@@ -175,6 +205,11 @@ static void _ExecuteMainThreadRunLoopSources(void) {
 #ifdef __DZWEBSERVER_ENABLE_TESTING__
   BOOL _recording;
 #endif
+  double _compressionLoadThreshold;
+  _Atomic(int64_t) _loadSampleTime;
+  atomic_bool _heavyLoad;
+  _Atomic(NSUInteger) _compressionDecisionCounts[4];
+  _Atomic(NSUInteger) _bufferedRequestBodySize;
 }
 
 + (void)initialize {
@@ -337,8 +372,16 @@ static void _ExecuteMainThreadRunLoopSources(void) {
 }
 
 - (void)addHandlerWithMatchBlock:(DZWebServerMatchBlock)matchBlock asyncProcessBlock:(DZWebServerAsyncProcessBlock)processBlock {
+  [self addHandlerWithMatchBlock:matchBlock validatorBlock:nil asyncProcessBlock:processBlock];
+}
+
+- (void)addHandlerWithMatchBlock:(DZWebServerMatchBlock)matchBlock validatorBlock:(DZWebServerValidatorBlock)validatorBlock asyncProcessBlock:(DZWebServerAsyncProcessBlock)processBlock {
+  [self addHandlerWithMatchBlock:matchBlock bodyAcceptanceBlock:nil validatorBlock:validatorBlock asyncProcessBlock:processBlock];
+}
+
+- (void)addHandlerWithMatchBlock:(DZWebServerMatchBlock)matchBlock bodyAcceptanceBlock:(DZWebServerBodyAcceptanceBlock)bodyAcceptanceBlock validatorBlock:(DZWebServerValidatorBlock)validatorBlock asyncProcessBlock:(DZWebServerAsyncProcessBlock)processBlock {
   DWS_DCHECK(_options == nil);
-  DZWebServerHandler* handler = [[DZWebServerHandler alloc] initWithMatchBlock:matchBlock asyncProcessBlock:processBlock];
+  DZWebServerHandler* handler = [[DZWebServerHandler alloc] initWithMatchBlock:matchBlock bodyAcceptanceBlock:bodyAcceptanceBlock validatorBlock:validatorBlock asyncProcessBlock:processBlock];
   [_handlers insertObject:handler atIndex:0];
 }
 
@@ -556,6 +599,7 @@ static inline NSString* _EncodeBase64(NSString* string) {
     [accounts enumerateKeysAndObjectsUsingBlock:^(NSString* username, NSString* password, BOOL* stop) {
       [self->_authenticationBasicAccounts setObject:_EncodeBase64([NSString stringWithFormat:@"%@:%@", username, password]) forKey:username];
     }];
+    _authenticationChallenge = [NSString stringWithFormat:@"Basic realm=\"%@\"", _authenticationRealm];
   } else if ([authenticationMethod isEqualToString:DZWebServerAuthenticationMethod_DigestAccess]) {
     _authenticationRealm = [(NSString*)_GetOption(_options, DZWebServerOption_AuthenticationRealm, _serverName) copy];
     _authenticationDigestAccounts = [[NSMutableDictionary alloc] init];
@@ -563,11 +607,55 @@ static inline NSString* _EncodeBase64(NSString* string) {
     [accounts enumerateKeysAndObjectsUsingBlock:^(NSString* username, NSString* password, BOOL* stop) {
       [self->_authenticationDigestAccounts setObject:DZWebServerComputeMD5Digest(@"%@:%@:%@", username, self->_authenticationRealm, password) forKey:username];
     }];
+    if (_digestAuthenticationNonce == nil) {
+      CFUUIDRef uuid = CFUUIDCreate(kCFAllocatorDefault);
+      _digestAuthenticationNonce = DZWebServerComputeMD5Digest(@"%@", CFBridgingRelease(CFUUIDCreateString(kCFAllocatorDefault, uuid)));
+      CFRelease(uuid);
+    }
+    _authenticationDigestNonce = _digestAuthenticationNonce;
+    _authenticationChallenge = [NSString stringWithFormat:@"Digest realm=\"%@\", nonce=\"%@\"", _authenticationRealm, _authenticationDigestNonce];  // TODO: Support Quality of Protection ("qop")
+    _staleAuthenticationChallenge = [_authenticationChallenge stringByAppendingString:@", stale=TRUE"];
   }
   _connectionClass = _GetOption(_options, DZWebServerOption_ConnectionClass, [DZWebServerConnection class]);
   _shouldAutomaticallyMapHEADToGET = [(NSNumber*)_GetOption(_options, DZWebServerOption_AutomaticallyMapHEADToGET, @YES) boolValue];
   _disconnectDelay = [(NSNumber*)_GetOption(_options, DZWebServerOption_ConnectedStateCoalescingInterval, @1.0) doubleValue];
   _dispatchQueuePriority = [(NSNumber*)_GetOption(_options, DZWebServerOption_DispatchQueuePriority, @(QOS_CLASS_DEFAULT)) longValue];
+  NSUInteger maxFileCacheSize = [(NSNumber*)_GetOption(_options, DZWebServerOption_MaxFileCacheSize, @0) unsignedIntegerValue];
+  if (maxFileCacheSize > 0) {
+    NSUInteger maxFileCacheEntrySize = [(NSNumber*)_GetOption(_options, DZWebServerOption_MaxFileCacheEntrySize, @(64 * 1024)) unsignedIntegerValue];
+    _fileCache = [[DZWebServerFileCache alloc] initWithMaximumSize:maxFileCacheSize maximumFileSize:maxFileCacheEntrySize];
+  }
+  _servesPrecompressedFiles = [(NSNumber*)_GetOption(_options, DZWebServerOption_ServePrecompressedFiles, @NO) boolValue];
+  NSArray<NSString*>* registeredEncodings = [DZWebServerResponse registeredContentEncodings];
+  NSMutableArray<NSString*>* contentEncodings = [[NSMutableArray alloc] init];
+  for (NSString* encoding in (NSArray*)_GetOption(_options, DZWebServerOption_ContentEncodings, registeredEncodings)) {
+    if ([registeredEncodings containsObject:[encoding lowercaseString]]) {
+      [contentEncodings addObject:[encoding lowercaseString]];
+    } else {
+      DWS_LOG_WARNING(@"Ignoring unsupported content encoding '%@'", encoding);
+    }
+  }
+  _contentEncodings = contentEncodings;
+  _compressionMinimumSize = [(NSNumber*)_GetOption(_options, DZWebServerOption_CompressionMinimumSize, @1024) unsignedIntegerValue];
+  _compressibleContentTypes = [_GetOption(_options, DZWebServerOption_CompressibleContentTypes, nil) copy];
+  _compressionLoadThreshold = [(NSNumber*)_GetOption(_options, DZWebServerOption_CompressionLoadThreshold, @0.8) doubleValue];
+  NSMutableDictionary<NSString*, id>* reducedOptions = [[NSMutableDictionary alloc] initWithDictionary:_options];
+  [reducedOptions setObject:@1 forKey:DZWebServerOption_GZipCompressionLevel];
+  [reducedOptions setObject:@1 forKey:DZWebServerOption_BrotliCompressionQuality];
+  [reducedOptions setObject:@1 forKey:DZWebServerOption_ZstdCompressionLevel];
+  _reducedContentEncodingOptions = reducedOptions;
+  atomic_store(&_loadSampleTime, 0);
+  atomic_store(&_heavyLoad, false);
+  NSUInteger maxEncodedContentCacheSize = [(NSNumber*)_GetOption(_options, DZWebServerOption_MaxEncodedContentCacheSize, @0) unsignedIntegerValue];
+  if (maxEncodedContentCacheSize > 0) {
+    _encodedContentCache = [[DZWebServerEncodedContentCache alloc] initWithMaximumSize:maxEncodedContentCacheSize];
+    _encodedContentCacheMaximumEntrySize = [(NSNumber*)_GetOption(_options, DZWebServerOption_MaxEncodedContentCacheEntrySize, @(1024 * 1024)) unsignedIntegerValue];
+  }
+  _maximumDecodedBodySize = [(NSNumber*)_GetOption(_options, DZWebServerOption_MaxDecodedBodySize, @0) unsignedIntegerValue];
+  _maximumRequestBodySize = [(NSNumber*)_GetOption(_options, DZWebServerOption_MaxRequestBodySize, @0) unsignedIntegerValue];
+  _maximumBufferedRequestBodySize = [(NSNumber*)_GetOption(_options, DZWebServerOption_MaxBufferedRequestBodySize, @0) unsignedIntegerValue];
+  _shouldAutomaticallyComputeETags = [(NSNumber*)_GetOption(_options, DZWebServerOption_AutomaticallyComputeETags, @NO) boolValue];
+  _shouldAutomaticallySendServerTiming = [(NSNumber*)_GetOption(_options, DZWebServerOption_AutomaticallySendServerTiming, @NO) boolValue];
 
   _source4 = [self _createDispatchSourceWithListeningSocket:listeningSocket4 isIPv6:NO];
   _source6 = [self _createDispatchSourceWithListeningSocket:listeningSocket6 isIPv6:YES];
@@ -708,6 +796,21 @@ static inline NSString* _EncodeBase64(NSString* string) {
   _authenticationRealm = nil;
   _authenticationBasicAccounts = nil;
   _authenticationDigestAccounts = nil;
+  _authenticationDigestNonce = nil;
+  _authenticationChallenge = nil;
+  _staleAuthenticationChallenge = nil;
+  _fileCache = nil;
+  _servesPrecompressedFiles = NO;
+  _contentEncodings = nil;
+  _compressibleContentTypes = nil;
+  _reducedContentEncodingOptions = nil;
+  _encodedContentCache = nil;
+  _encodedContentCacheMaximumEntrySize = 0;
+  _maximumDecodedBodySize = 0;
+  _maximumRequestBodySize = 0;
+  _maximumBufferedRequestBodySize = 0;
+  _shouldAutomaticallyComputeETags = NO;
+  _shouldAutomaticallySendServerTiming = NO;
 
   dispatch_async(dispatch_get_main_queue(), ^{
     if (self->_disconnectTimer) {
@@ -793,6 +896,62 @@ static inline NSString* _EncodeBase64(NSString* string) {
   }
 }
 
+// Called from connections on arbitrary threads
+- (BOOL)shouldReduceCompressionLevel {
+  if (_compressionLoadThreshold <= 0.0) {
+    return NO;
+  }
+  int64_t now = (int64_t)CFAbsoluteTimeGetCurrent();
+  int64_t sampleTime = atomic_load_explicit(&_loadSampleTime, memory_order_relaxed);
+  if ((now != sampleTime) && atomic_compare_exchange_strong(&_loadSampleTime, &sampleTime, now)) {  // Sample load average at most once per second
+    double load;
+    if (getloadavg(&load, 1) == 1) {
+      double loadPerCPU = load / (double)MAX([[NSProcessInfo processInfo] activeProcessorCount], (NSUInteger)1);
+      atomic_store_explicit(&_heavyLoad, loadPerCPU >= _compressionLoadThreshold, memory_order_relaxed);
+    }
+  }
+  return atomic_load_explicit(&_heavyLoad, memory_order_relaxed);
+}
+
+- (void)recordCompressionDecision:(DZWebServerCompressionDecision)decision {
+  atomic_fetch_add_explicit(&_compressionDecisionCounts[decision], 1, memory_order_relaxed);
+}
+
+- (BOOL)reserveBufferedRequestBodySize:(NSUInteger)size {
+  NSUInteger bufferedSize = atomic_load_explicit(&_bufferedRequestBodySize, memory_order_relaxed);
+  do {
+    if (bufferedSize + size > _maximumBufferedRequestBodySize) {
+      return NO;
+    }
+  } while (!atomic_compare_exchange_weak_explicit(&_bufferedRequestBodySize, &bufferedSize, bufferedSize + size, memory_order_relaxed, memory_order_relaxed));
+  return YES;
+}
+
+- (void)releaseBufferedRequestBodySize:(NSUInteger)size {
+  DWS_DCHECK(atomic_load_explicit(&_bufferedRequestBodySize, memory_order_relaxed) >= size);
+  atomic_fetch_sub_explicit(&_bufferedRequestBodySize, size, memory_order_relaxed);
+}
+
+- (NSUInteger)bufferedRequestBodySize {
+  return atomic_load_explicit(&_bufferedRequestBodySize, memory_order_relaxed);
+}
+
+- (NSUInteger)compressedResponseCount {
+  return atomic_load_explicit(&_compressionDecisionCounts[kDZWebServerCompressionDecision_Compressed], memory_order_relaxed) + atomic_load_explicit(&_compressionDecisionCounts[kDZWebServerCompressionDecision_CompressedAtReducedLevel], memory_order_relaxed);
+}
+
+- (NSUInteger)reducedLevelCompressedResponseCount {
+  return atomic_load_explicit(&_compressionDecisionCounts[kDZWebServerCompressionDecision_CompressedAtReducedLevel], memory_order_relaxed);
+}
+
+- (NSUInteger)compressionSkippedForSizeCount {
+  return atomic_load_explicit(&_compressionDecisionCounts[kDZWebServerCompressionDecision_SkippedForSize], memory_order_relaxed);
+}
+
+- (NSUInteger)compressionSkippedForContentTypeCount {
+  return atomic_load_explicit(&_compressionDecisionCounts[kDZWebServerCompressionDecision_SkippedForContentType], memory_order_relaxed);
+}
+
 @end
 
 @implementation DZWebServer (Extensions)
@@ -981,6 +1140,16 @@ static inline NSString* _EncodeBase64(NSString* string) {
 @implementation DZWebServer (GETHandlers)
 
 - (void)addGETHandlerForPath:(NSString*)path staticData:(NSData*)staticData contentType:(NSString*)contentType cacheAge:(NSUInteger)cacheAge {
+  if (contentType) {
+    DZWebServerPrebuiltResponse* prebuiltResponse = [[DZWebServerPrebuiltResponse alloc] initWithData:staticData contentType:contentType cacheAge:cacheAge];  // Headers and ETag are computed once for all requests
+    [self addHandlerForMethod:@"GET"
+                         path:path
+                 requestClass:[DZWebServerRequest class]
+                 processBlock:^DZWebServerResponse*(DZWebServerRequest* request) {
+                   return [[DZWebServerPrebuiltResponse alloc] initWithPrebuiltResponse:prebuiltResponse];
+                 }];
+    return;
+  }
   [self addHandlerForMethod:@"GET"
                        path:path
                requestClass:[DZWebServerRequest class]
@@ -992,20 +1161,36 @@ static inline NSString* _EncodeBase64(NSString* string) {
 }
 
 - (void)addGETHandlerForPath:(NSString*)path filePath:(NSString*)filePath isAttachment:(BOOL)isAttachment cacheAge:(NSUInteger)cacheAge allowRangeRequests:(BOOL)allowRangeRequests {
-  [self addHandlerForMethod:@"GET"
-                       path:path
-               requestClass:[DZWebServerRequest class]
-               processBlock:^DZWebServerResponse*(DZWebServerRequest* request) {
-                 DZWebServerResponse* response = nil;
-                 if (allowRangeRequests) {
-                   response = [DZWebServerFileResponse responseWithFile:filePath byteRange:request.byteRange isAttachment:isAttachment];
-                   [response setValue:@"bytes" forAdditionalHeader:@"Accept-Ranges"];
-                 } else {
-                   response = [DZWebServerFileResponse responseWithFile:filePath isAttachment:isAttachment];
-                 }
-                 response.cacheControlMaxAge = cacheAge;
-                 return response;
-               }];
+  if (![path hasPrefix:@"/"]) {
+    DWS_DNOT_REACHED();
+    return;
+  }
+  [self
+      addHandlerWithMatchBlock:^DZWebServerRequest*(NSString* requestMethod, NSURL* requestURL, NSDictionary<NSString*, NSString*>* requestHeaders, NSString* urlPath, NSDictionary<NSString*, NSString*>* urlQuery) {
+        if (![requestMethod isEqualToString:@"GET"]) {
+          return nil;
+        }
+        if ([urlPath caseInsensitiveCompare:path] != NSOrderedSame) {
+          return nil;
+        }
+        return [[DZWebServerRequest alloc] initWithMethod:requestMethod url:requestURL headers:requestHeaders path:urlPath query:urlQuery];
+      }
+      validatorBlock:^DZWebServerResponse*(DZWebServerRequest* request) {
+        DZWebServerResponse* response = [DZWebServerFileResponse validatorResponseForFile:filePath];
+        response.cacheControlMaxAge = cacheAge;
+        return response;
+      }
+      asyncProcessBlock:^(DZWebServerRequest* request, DZWebServerCompletionBlock completionBlock) {
+        DZWebServerResponse* response = nil;
+        if (allowRangeRequests) {
+          response = [DZWebServerFileResponse responseWithFile:filePath byteRanges:request.byteRanges isAttachment:isAttachment];
+          [response setValue:@"bytes" forAdditionalHeader:@"Accept-Ranges"];
+        } else {
+          response = [DZWebServerFileResponse responseWithFile:filePath isAttachment:isAttachment];
+        }
+        response.cacheControlMaxAge = cacheAge;
+        completionBlock(response);
+      }];
 }
 
 - (DZWebServerResponse*)_responseWithContentsOfDirectory:(NSString*)path {
@@ -1038,9 +1223,17 @@ static inline NSString* _EncodeBase64(NSString* string) {
   return [DZWebServerDataResponse responseWithHTML:html];
 }
 
+- (DZWebServerResponse*)_responseWithFileCacheEntry:(DZWebServerFileCacheEntry*)entry {
+  DZWebServerResponse* response = [DZWebServerDataResponse responseWithData:entry.data contentType:entry.contentType];
+  response.lastModifiedDate = entry.lastModifiedDate;
+  response.eTag = entry.eTag;
+  return response;
+}
+
 - (void)addGETHandlerForBasePath:(NSString*)basePath directoryPath:(NSString*)directoryPath indexFilename:(NSString*)indexFilename cacheAge:(NSUInteger)cacheAge allowRangeRequests:(BOOL)allowRangeRequests {
   if ([basePath hasPrefix:@"/"] && [basePath hasSuffix:@"/"]) {
     DZWebServer* __unsafe_unretained server = self;
+    DZWebServerNegativeLookupCache* negativeLookupCache = [[DZWebServerNegativeLookupCache alloc] initWithCountLimit:kNegativeLookupCacheCountLimit];
     [self
         addHandlerWithMatchBlock:^DZWebServerRequest*(NSString* requestMethod, NSURL* requestURL, NSDictionary<NSString*, NSString*>* requestHeaders, NSString* urlPath, NSDictionary<NSString*, NSString*>* urlQuery) {
           if (![requestMethod isEqualToString:@"GET"]) {
@@ -1052,25 +1245,53 @@ static inline NSString* _EncodeBase64(NSString* string) {
           return [[DZWebServerRequest alloc] initWithMethod:requestMethod url:requestURL headers:requestHeaders path:urlPath query:urlQuery];
         }
         processBlock:^DZWebServerResponse*(DZWebServerRequest* request) {
+          NSString* relativePath = [request.path substringFromIndex:basePath.length];
+          if ([negativeLookupCache containsKey:relativePath]) {
+            return [DZWebServerResponse responseWithStatusCode:kDZWebServerHTTPStatusCode_NotFound];
+          }
           DZWebServerResponse* response = nil;
-          NSString* filePath = [directoryPath stringByAppendingPathComponent:DZWebServerNormalizePath([request.path substringFromIndex:basePath.length])];
-          NSString* fileType = [[[NSFileManager defaultManager] attributesOfItemAtPath:filePath error:NULL] fileType];
-          if (fileType) {
-            if ([fileType isEqualToString:NSFileTypeDirectory]) {
+          NSString* filePath = [directoryPath stringByAppendingPathComponent:DZWebServerNormalizePath(relativePath)];
+          DZWebServerFileCache* fileCache = server.fileCache;
+          DZWebServerCachedFile* file = [[DZWebServerFileDescriptorCache sharedCache] fileForPath:filePath];
+          if (file == nil) {
+            [negativeLookupCache addKey:relativePath forMissingPath:filePath rootDirectory:directoryPath];
+          } else {
+            if (S_ISDIR(file.info->st_mode)) {
               if (indexFilename) {
                 NSString* indexPath = [filePath stringByAppendingPathComponent:indexFilename];
-                NSString* indexType = [[[NSFileManager defaultManager] attributesOfItemAtPath:indexPath error:NULL] fileType];
-                if ([indexType isEqualToString:NSFileTypeRegular]) {
-                  return [DZWebServerFileResponse responseWithFile:indexPath];
+                DZWebServerCachedFile* indexFile = [[DZWebServerFileDescriptorCache sharedCache] fileForPath:indexPath];
+                if (indexFile && S_ISREG(indexFile.info->st_mode)) {
+                  NSString* encoding = nil;
+                  DZWebServerCachedFile* encodedFile = server.servesPrecompressedFiles ? [DZWebServerFileResponse precompressedFileForFile:indexFile request:request contentEncoding:&encoding] : nil;
+                  DZWebServerFileCacheEntry* entry = (encodedFile || request.headRequest) ? nil : [fileCache entryForFile:indexFile];
+                  DZWebServerResponse* indexResponse;
+                  if (entry) {
+                    indexResponse = [server _responseWithFileCacheEntry:entry];
+                  } else {
+                    indexResponse = [[DZWebServerFileResponse alloc] initWithCachedFile:indexFile precompressedFile:encodedFile contentEncoding:encoding byteRanges:nil isAttachment:NO mimeTypeOverrides:nil];
+                  }
+                  if (server.servesPrecompressedFiles) {
+                    [indexResponse setValue:@"Accept-Encoding" forAdditionalHeader:@"Vary"];
+                  }
+                  return indexResponse;
                 }
               }
-              response = [server _responseWithContentsOfDirectory:filePath];
-            } else if ([fileType isEqualToString:NSFileTypeRegular]) {
+              response = [server _responseWithContentsOfDirectory:filePath];  // Also listed for HEAD so Content-Length matches GET
+            } else if (S_ISREG(file.info->st_mode)) {
+              NSArray<NSValue*>* byteRanges = allowRangeRequests ? request.byteRanges : nil;
+              NSString* encoding = nil;
+              DZWebServerCachedFile* encodedFile = server.servesPrecompressedFiles ? [DZWebServerFileResponse precompressedFileForFile:file request:request contentEncoding:&encoding] : nil;
+              DZWebServerFileCacheEntry* entry = (encodedFile || byteRanges || request.headRequest) ? nil : [fileCache entryForFile:file];  // A file response for HEAD only needs the stat
+              if (entry) {
+                response = [server _responseWithFileCacheEntry:entry];
+              } else {
+                response = [[DZWebServerFileResponse alloc] initWithCachedFile:file precompressedFile:encodedFile contentEncoding:encoding byteRanges:byteRanges isAttachment:NO mimeTypeOverrides:nil];
+              }
               if (allowRangeRequests) {
-                response = [DZWebServerFileResponse responseWithFile:filePath byteRange:request.byteRange];
                 [response setValue:@"bytes" forAdditionalHeader:@"Accept-Ranges"];
-              } else {
-                response = [DZWebServerFileResponse responseWithFile:filePath];
+              }
+              if (server.servesPrecompressedFiles) {
+                [response setValue:@"Accept-Encoding" forAdditionalHeader:@"Vary"];
               }
             }
           }
@@ -156,6 +156,10 @@ NS_ASSUME_NONNULL_BEGIN
  *  If the request is invalid or processing fails, @c -abortRequest:withStatusCode:
  *  is called instead of steps 4-6.
  *
+ *  When the matched handler has a validator block, @c -overrideResponse:forRequest:
+ *  is also called with the validators it returns between steps 4 and 5; if that
+ *  produces a different response (e.g. a 304), step 5 is skipped.
+ *
  *  @warning These methods can be called on any GCD thread. Always call @c super
  *  when overriding them.
  *
@@ -245,8 +249,12 @@ NS_ASSUME_NONNULL_BEGIN
  *  appropriate @c WWW-Authenticate challenge header on failure. When
  *  authentication is not configured, the default implementation returns @c nil.
  *
+ *  For requests with an @c Expect: 100-continue header, this method is also
+ *  called before replying @c 100 Continue, when only the headers have been
+ *  read, so unauthorized uploads are rejected without receiving their body.
+ *
  *  @param request The fully parsed HTTP request (headers and body have been
- *                 read).
+ *                 read, except for the early call described above).
  *
  *  @return A @c DZWebServerResponse to send immediately (bypassing handler
  *          processing), or @c nil to continue to @c -processRequest:completion:.
@@ -288,16 +296,24 @@ NS_ASSUME_NONNULL_BEGIN
  *  You may modify properties of @p response and return it, or return an
  *  entirely new @c DZWebServerResponse instance.
  *
- *  The default implementation implements conditional-GET logic per RFC 2616
- *  sections 14.25 and 14.26. For 2xx responses, it compares the response's
- *  @c eTag and @c lastModifiedDate against the request's @c If-None-Match and
- *  @c If-Modified-Since headers. When the resource has not changed:
- *  - For @c GET and @c HEAD requests: returns a 304 Not Modified response.
- *  - For other methods: returns a 412 Precondition Failed response.
+ *  The default implementation evaluates conditional requests per RFC 7232
+ *  section 6 for 2xx, 206 and 416 responses, comparing the response's @c eTag
+ *  and @c lastModifiedDate against the request's precondition headers:
+ *  - @c If-Match (strong comparison, ETag list or @c *) or, when absent,
+ *    @c If-Unmodified-Since: returns a 412 Precondition Failed response when
+ *    the precondition fails.
+ *  - @c If-None-Match (weak comparison, ETag list or @c *) or, when absent and
+ *    only for @c GET and @c HEAD, @c If-Modified-Since: when the resource has
+ *    not changed, returns a 304 Not Modified response for @c GET and @c HEAD
+ *    requests and a 412 Precondition Failed response for other methods.
  *
  *  The replacement response preserves @c cacheControlMaxAge, @c lastModifiedDate,
  *  and @c eTag from the original response.
  *
+ *  When the request has an @c If-Range header (ETag or HTTP date) that no longer
+ *  matches the resource, a @c DZWebServerFileResponse built from its byte ranges
+ *  is turned back into a 200 response for the full file.
+ *
  *  @param response The response produced by the handler or preflight step.
  *  @param request  The original HTTP request.
  *
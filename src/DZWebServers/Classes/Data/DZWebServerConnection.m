@@ -30,7 +30,9 @@
 #endif
 
 #import <TargetConditionals.h>
+#import <CommonCrypto/CommonDigest.h>
 #import <netdb.h>
+#import <os/lock.h>
 #ifdef __DZWEBSERVER_ENABLE_TESTING__
 #import <libkern/OSAtomic.h>
 #endif
@@ -39,6 +41,8 @@
 
 #define kHeadersReadCapacity (1 * 1024)
 #define kBodyReadCapacity (256 * 1024)
+#define kLingeringCloseMaximumLength (1024 * 1024)
+#define kLingeringCloseTimeout 2.0
 
 typedef void (^ReadDataCompletionBlock)(BOOL success);
 typedef void (^ReadHeadersCompletionBlock)(NSData* extraData);
@@ -52,7 +56,6 @@ static NSData* _CRLFData = nil;
 static NSData* _CRLFCRLFData = nil;
 static NSData* _continueData = nil;
 static NSData* _lastChunkData = nil;
-static NSString* _digestAuthenticationNonce = nil;
 #ifdef __DZWEBSERVER_ENABLE_TESTING__
 static int32_t _connectionCounter = 0;
 #endif
@@ -64,10 +67,17 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)readHeaders:(NSMutableData*)headersData withCompletionBlock:(ReadHeadersCompletionBlock)block;
 - (void)readBodyWithRemainingLength:(NSUInteger)length completionBlock:(ReadBodyCompletionBlock)block;
 - (void)readNextBodyChunk:(NSMutableData*)chunkData completionBlock:(ReadBodyCompletionBlock)block;
+- (void)pullBodyWithCompletionBlock:(DZWebServerBodyPullCompletionBlock)block;
+- (void)pullNextBodyChunk:(NSMutableData*)chunkData completionBlock:(DZWebServerBodyPullCompletionBlock)block;
+- (NSUInteger)maximumRequestBodySize;
+- (BOOL)writeRequestBodyData:(NSData*)data error:(NSError**)error;
+- (void)didFailWritingRequestBodyWithError:(NSError*)error;
+- (void)lingerIfNeeded;
 @end
 
 @interface DZWebServerConnection (Write)
 - (void)writeData:(NSData*)data withCompletionBlock:(WriteDataCompletionBlock)block;
+- (void)writeDataSegments:(NSArray<NSData*>*)segments withCompletionBlock:(WriteDataCompletionBlock)block;
 - (void)writeHeadersWithCompletionBlock:(WriteHeadersCompletionBlock)block;
 - (void)writeBodyWithCompletionBlock:(WriteBodyCompletionBlock)block;
 @end
@@ -83,7 +93,21 @@ NS_ASSUME_NONNULL_END
   DZWebServerHandler* _handler;
   CFHTTPMessageRef _responseMessage;
   DZWebServerResponse* _response;
+  os_unfair_lock _responseLock;
+  BOOL _responseStarted;  // Protected by _responseLock as handlers can send informational responses from any thread
   NSInteger _statusCode;
+  NSInteger _requestBodyErrorStatusCode;
+  NSUInteger _receivedBodyLength;
+  NSUInteger _remainingBodyLength;
+  BOOL _lingersOnClose;  // Set while a request body has been announced but not read
+
+  CFAbsoluteTime _requestStartTime;
+  CFAbsoluteTime _processingStartTime;
+  CFAbsoluteTime _responseStartTime;
+  CFAbsoluteTime _bodyStartTime;
+  NSArray<NSString*>* _trailers;
+  BOOL _computesContentDigest;
+  CC_SHA256_CTX _contentDigestContext;
 
   BOOL _opened;
 #ifdef __DZWEBSERVER_ENABLE_TESTING__
@@ -113,11 +137,6 @@ NS_ASSUME_NONNULL_END
   if (_lastChunkData == nil) {
     _lastChunkData = [[NSData alloc] initWithBytes:"0\r\n\r\n" length:5];
   }
-  if (_digestAuthenticationNonce == nil) {
-    CFUUIDRef uuid = CFUUIDCreate(kCFAllocatorDefault);
-    _digestAuthenticationNonce = DZWebServerComputeMD5Digest(@"%@", CFBridgingRelease(CFUUIDCreateString(kCFAllocatorDefault, uuid)));
-    CFRelease(uuid);
-  }
 }
 
 - (BOOL)isUsingIPv6 {
@@ -130,16 +149,37 @@ NS_ASSUME_NONNULL_END
   _responseMessage = CFHTTPMessageCreateResponse(kCFAllocatorDefault, statusCode, NULL, kCFHTTPVersion1_1);
   CFHTTPMessageSetHeaderFieldValue(_responseMessage, CFSTR("Connection"), CFSTR("Close"));
   CFHTTPMessageSetHeaderFieldValue(_responseMessage, CFSTR("Server"), (__bridge CFStringRef)_server.serverName);
-  CFHTTPMessageSetHeaderFieldValue(_responseMessage, CFSTR("Date"), (__bridge CFStringRef)DZWebServerFormatRFC822([NSDate date]));
+  CFHTTPMessageSetHeaderFieldValue(_responseMessage, CFSTR("Date"), (__bridge CFStringRef)DZWebServerFormatCurrentRFC822());
+}
+
+// Returns the 304 or 412 response to send instead of calling the handler if its validators satisfy the request preconditions
+- (DZWebServerResponse*)_validateRequestWithHandler {
+  DZWebServerResponse* validatorResponse = _handler.validatorBlock ? _handler.validatorBlock(_request) : nil;
+  if (validatorResponse == nil) {
+    return nil;
+  }
+  DZWebServerResponse* response = [self overrideResponse:validatorResponse forRequest:_request];
+  if (response == validatorResponse) {
+    return nil;
+  }
+  DWS_LOG_DEBUG(@"Connection on socket %i answered request \"%@ %@\" from handler validators with status code %i", _socket, _virtualHEAD ? @"HEAD" : _request.method, _request.path, (int)response.statusCode);
+  return response;
 }
 
 - (void)_startProcessingRequest {
   DWS_DCHECK(_responseMessage == NULL);
+  _processingStartTime = CFAbsoluteTimeGetCurrent();
 
   DZWebServerResponse* preflightResponse = [self preflightRequest:_request];
+  if (preflightResponse == nil) {
+    preflightResponse = [self _validateRequestWithHandler];
+  }
   if (preflightResponse) {
     [self _finishProcessingRequest:preflightResponse];
   } else {
+    _request.informationalResponseBlock = ^BOOL(NSInteger statusCode, NSDictionary<NSString*, NSString*>* headers) {
+      return [self _writeInformationalResponseWithStatusCode:statusCode headers:headers];
+    };
     [self processRequest:_request
               completion:^(DZWebServerResponse* processResponse) {
                 [self _finishProcessingRequest:processResponse];
@@ -147,18 +187,165 @@ NS_ASSUME_NONNULL_END
   }
 }
 
+static inline BOOL _IsCompressibleContentType(NSString* contentType, NSArray<NSString*>* allowedTypes) {
+  if (allowedTypes == nil) {
+    return DZWebServerIsCompressibleContentType(contentType);
+  }
+  for (NSString* type in allowedTypes) {
+    if ([contentType rangeOfString:type options:(NSAnchoredSearch | NSCaseInsensitiveSearch)].location != NSNotFound) {
+      return YES;
+    }
+  }
+  return NO;
+}
+
+// Returns YES if an encoding was selected
+- (BOOL)_negotiateContentEncodingForResponse:(DZWebServerResponse*)response {
+  if (response.contentEncoding || [response.additionalHeaders objectForKey:@"Content-Encoding"] || (response.statusCode == kDZWebServerHTTPStatusCode_PartialContent)) {
+    return NO;  // Don't encode content twice and don't change the representation byte ranges refer to
+  }
+  if ((response.contentLength != NSUIntegerMax) && (response.contentLength < _server.compressionMinimumSize)) {
+    [_server recordCompressionDecision:kDZWebServerCompressionDecision_SkippedForSize];
+    return NO;
+  }
+  if (!_IsCompressibleContentType(response.contentType, _server.compressibleContentTypes)) {
+    [_server recordCompressionDecision:kDZWebServerCompressionDecision_SkippedForContentType];
+    return NO;
+  }
+  NSString* vary = [response.additionalHeaders objectForKey:@"Vary"];
+  if (vary == nil) {
+    [response setValue:@"Accept-Encoding" forAdditionalHeader:@"Vary"];
+  } else if ([vary rangeOfString:@"Accept-Encoding" options:NSCaseInsensitiveSearch].location == NSNotFound) {
+    [response setValue:[vary stringByAppendingString:@", Accept-Encoding"] forAdditionalHeader:@"Vary"];
+  }
+  response.contentEncoding = [_request preferredContentEncodingFromEncodings:_server.contentEncodings];
+  return (response.contentEncoding != nil);
+}
+
+// Only complete bodies of responses with a stable identity can be shared across connections
+- (NSData*)_cachedEncodedBodyForResponse:(DZWebServerResponse*)response options:(NSDictionary<NSString*, id>*)options {
+  DZWebServerEncodedContentCache* cache = _server.encodedContentCache;
+  if ((cache == nil) || _request.headRequest || (response.eTag == nil) || (response.statusCode != kDZWebServerHTTPStatusCode_OK)) {
+    return nil;
+  }
+  if (![response isKindOfClass:[DZWebServerDataResponse class]] && ![response isKindOfClass:[DZWebServerFileResponse class]]) {
+    return nil;
+  }
+  if ((response.contentLength == NSUIntegerMax) || (response.contentLength > _server.encodedContentCacheMaximumEntrySize)) {
+    return nil;
+  }
+  NSString* encoding = (NSString*)response.contentEncoding;
+  NSString* identity = [response isKindOfClass:[DZWebServerFileResponse class]] ? [(DZWebServerFileResponse*)response path] : _request.URL.absoluteString;  // ETags are only unique per resource, which includes the query
+  NSString* levels = [NSString stringWithFormat:@"%@/%@/%@", options[DZWebServerOption_GZipCompressionLevel], options[DZWebServerOption_BrotliCompressionQuality], options[DZWebServerOption_ZstdCompressionLevel]];  // Bodies encoded at the reduced level under load must not outlive it
+  NSString* key = [NSString stringWithFormat:@"%@|%@|%f|%@|%lu|%@", identity, encoding, response.lastModifiedDate.timeIntervalSinceReferenceDate, levels, (unsigned long)response.contentLength, response.eTag];
+  return [cache dataForKey:key
+                  producer:^NSData* {
+                    return [response encodedBodyWithContentEncoding:encoding options:options];
+                  }];
+}
+
+// Authentication only runs early for clients waiting for a "100 Continue" as it runs again once the body is received
+- (DZWebServerResponse*)_rejectionResponseForRequestBodyWithPreflight:(BOOL)preflight {
+  DZWebServerResponse* response = preflight ? [self preflightRequest:_request] : nil;
+  if ((response == nil) && _handler.bodyAcceptanceBlock) {
+    response = _handler.bodyAcceptanceBlock(_request);
+  }
+  return response;
+}
+
+// Informational responses are refused from then on
+- (void)_markResponseStarted {
+  os_unfair_lock_lock(&_responseLock);
+  _responseStarted = YES;
+  os_unfair_lock_unlock(&_responseLock);
+}
+
+// RFC 7231 forbids sending informational responses to HTTP/1.0 clients
+- (BOOL)_writeInformationalResponseWithStatusCode:(NSInteger)statusCode headers:(NSDictionary<NSString*, NSString*>*)headers {
+  if ((statusCode <= kDZWebServerHTTPStatusCode_SwitchingProtocols) || (statusCode >= 200)) {
+    return NO;
+  }
+  NSString* version = CFBridgingRelease(CFHTTPMessageCopyVersion(_requestMessage));
+  if (![version isEqualToString:(__bridge NSString*)kCFHTTPVersion1_1]) {
+    return NO;
+  }
+  CFHTTPMessageRef message = CFHTTPMessageCreateResponse(kCFAllocatorDefault, statusCode, NULL, kCFHTTPVersion1_1);
+  [headers enumerateKeysAndObjectsUsingBlock:^(NSString* key, NSString* value, BOOL* stop) {
+    CFHTTPMessageSetHeaderFieldValue(message, (__bridge CFStringRef)key, (__bridge CFStringRef)value);
+  }];
+  NSData* data = CFBridgingRelease(CFHTTPMessageCopySerializedMessage(message));
+  CFRelease(message);
+
+  // Writes to the socket are performed in submission order so holding the lock while submitting keeps this ahead of the final response
+  os_unfair_lock_lock(&_responseLock);
+  BOOL started = _responseStarted;
+  if (!started) {
+    DWS_LOG_DEBUG(@"Connection on socket %i sending informational response %i", _socket, (int)statusCode);
+    [self writeData:data withCompletionBlock:^(BOOL success){
+        // Nothing more to do
+    }];
+  }
+  os_unfair_lock_unlock(&_responseLock);
+  return !started;
+}
+
+// Sends the headers serialized when the response was created followed by the body in a single write
+- (void)_writePrebuiltResponse:(DZWebServerPrebuiltResponse*)response {
+  _response = response;
+  _statusCode = response.statusCode;
+  NSMutableString* headers = [NSMutableString string];
+  if (_server.serverName) {
+    [headers appendFormat:@"Server: %@\r\n", _server.serverName];
+  }
+  [headers appendFormat:@"Date: %@\r\n\r\n", DZWebServerFormatCurrentRFC822()];
+  NSData* headersData = (NSData*)[headers dataUsingEncoding:NSUTF8StringEncoding];
+  NSArray<NSData*>* segments = _request.headRequest ? @[ response.headerData, headersData ] : @[ response.headerData, headersData, response.body ];
+  [self writeDataSegments:segments withCompletionBlock:^(BOOL success){
+      // Nothing more to do
+  }];
+}
+
 // http://www.w3.org/Protocols/rfc2616/rfc2616-sec10.html
 - (void)_finishProcessingRequest:(DZWebServerResponse*)response {
   DWS_DCHECK(_responseMessage == NULL);
+  [self _markResponseStarted];
+  _request.informationalResponseBlock = nil;  // Also breaks the retain cycle with the connection
+  _responseStartTime = CFAbsoluteTimeGetCurrent();
   BOOL hasBody = NO;
 
+  if (response && _server.shouldAutomaticallyComputeETags && (response.eTag == nil) && (response.statusCode == kDZWebServerHTTPStatusCode_OK) && [response isKindOfClass:[DZWebServerDataResponse class]]) {
+    [(DZWebServerDataResponse*)response computeETag];
+  }
   if (response) {
     response = [self overrideResponse:response forRequest:_request];
   }
+  if (response.metadataOnly && !_request.headRequest) {
+    DWS_LOG_ERROR(@"Metadata-only response returned for \"%@ %@\" on socket %i", _request.method, _request.path, _socket);
+    response = nil;
+  }
+  if ([response isKindOfClass:[DZWebServerPrebuiltResponse class]] && [(DZWebServerPrebuiltResponse*)response isPristine] && !_server.shouldAutomaticallySendServerTiming) {
+    [self _writePrebuiltResponse:(DZWebServerPrebuiltResponse*)response];
+    return;
+  }
   if (response) {
-    if ([response hasBody]) {
-      [response prepareForReading];
-      hasBody = !_virtualHEAD;
+    if ([response hasBody] && !response.metadataOnly) {  // Metadata-only responses describe a body that is never read nor encoded
+      NSDictionary<NSString*, id>* encodingOptions = _server.options;
+      NSData* encodedBody = nil;
+      if (response.automaticContentEncodingEnabled && [self _negotiateContentEncodingForResponse:response]) {
+        if ([_server shouldReduceCompressionLevel]) {
+          encodingOptions = _server.reducedContentEncodingOptions;
+          [_server recordCompressionDecision:kDZWebServerCompressionDecision_CompressedAtReducedLevel];
+        } else {
+          [_server recordCompressionDecision:kDZWebServerCompressionDecision_Compressed];
+        }
+        encodedBody = [self _cachedEncodedBodyForResponse:response options:encodingOptions];
+      }
+      if (encodedBody) {
+        [response prepareForReadingWithEncodedBody:encodedBody contentEncoding:(NSString*)response.contentEncoding];
+      } else {
+        [response prepareForReadingWithContentEncodingOptions:encodingOptions];
+      }
+      hasBody = !_request.headRequest;
     }
     NSError* error = nil;
     if (hasBody && ![response performOpen:&error]) {
@@ -195,16 +382,41 @@ NS_ASSUME_NONNULL_END
     [_response.additionalHeaders enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL* stop) {
       CFHTTPMessageSetHeaderFieldValue(self->_responseMessage, (__bridge CFStringRef)key, (__bridge CFStringRef)obj);
     }];
+    if (_server.shouldAutomaticallySendServerTiming) {
+      NSString* serverTiming = [NSString stringWithFormat:@"parse;dur=%.3f, handler;dur=%.3f", (_processingStartTime - _requestStartTime) * 1000.0, (_responseStartTime - _processingStartTime) * 1000.0];
+      CFHTTPMessageSetHeaderFieldValue(_responseMessage, CFSTR("Server-Timing"), (__bridge CFStringRef)serverTiming);
+    }
+    if (hasBody && _response.usesChunkedTransferEncoding) {  // Trailers can only follow a chunked body
+      NSMutableArray<NSString*>* trailers = [NSMutableArray arrayWithArray:_response.declaredTrailers];
+      if (_response.contentDigestTrailerEnabled) {
+        [trailers addObject:@"Digest"];
+        CC_SHA256_Init(&_contentDigestContext);
+        _computesContentDigest = YES;
+      }
+      if (_server.shouldAutomaticallySendServerTiming) {
+        [trailers addObject:@"Server-Timing"];
+      }
+      if (trailers.count) {
+        _trailers = trailers;
+        CFHTTPMessageSetHeaderFieldValue(_responseMessage, CFSTR("Trailer"), (__bridge CFStringRef)[trailers componentsJoinedByString:@", "]);
+      }
+    }
     [self writeHeadersWithCompletionBlock:^(BOOL success) {
       if (success) {
         if (hasBody) {
+          self->_bodyStartTime = CFAbsoluteTimeGetCurrent();
           [self writeBodyWithCompletionBlock:^(BOOL successInner) {
             [self->_response performClose];  // TODO: There's nothing we can do on failure as headers have already been sent
+            self->_request.bodyPullBlock = nil;  // Any unread request body is discarded with the connection
+            [self lingerIfNeeded];
           }];
+          return;
         }
       } else if (hasBody) {
         [self->_response performClose];
       }
+      self->_request.bodyPullBlock = nil;
+      [self lingerIfNeeded];
     }];
   } else {
     [self abortRequest:_request withStatusCode:kDZWebServerHTTPStatusCode_InternalServerError];
@@ -220,12 +432,12 @@ NS_ASSUME_NONNULL_END
   }
 
   if (initialData.length) {
-    if (![_request performWriteData:initialData error:&error]) {
-      DWS_LOG_ERROR(@"Failed writing request body on socket %i: %@", _socket, error);
+    if (![self writeRequestBodyData:initialData error:&error]) {
+      [self didFailWritingRequestBodyWithError:error];
       if (![_request performClose:&error]) {
         DWS_LOG_ERROR(@"Failed closing request body for socket %i: %@", _socket, error);
       }
-      [self abortRequest:_request withStatusCode:kDZWebServerHTTPStatusCode_InternalServerError];
+      [self abortRequest:_request withStatusCode:(_requestBodyErrorStatusCode ? _requestBodyErrorStatusCode : kDZWebServerHTTPStatusCode_InternalServerError)];
       return;
     }
     length -= initialData.length;
@@ -234,6 +446,10 @@ NS_ASSUME_NONNULL_END
   if (length) {
     [self readBodyWithRemainingLength:length
                       completionBlock:^(BOOL success) {
+                        if (!success && self->_requestBodyErrorStatusCode) {
+                          [self abortRequest:self->_request withStatusCode:self->_requestBodyErrorStatusCode];
+                          return;
+                        }
                         NSError* localError = nil;
                         if ([self->_request performClose:&localError]) {
                           [self _startProcessingRequest];
@@ -263,6 +479,10 @@ NS_ASSUME_NONNULL_END
   NSMutableData* chunkData = [[NSMutableData alloc] initWithData:initialData];
   [self readNextBodyChunk:chunkData
           completionBlock:^(BOOL success) {
+            if (!success && self->_requestBodyErrorStatusCode) {
+              [self abortRequest:self->_request withStatusCode:self->_requestBodyErrorStatusCode];
+              return;
+            }
             NSError* localError = nil;
             if ([self->_request performClose:&localError]) {
               [self _startProcessingRequest];
@@ -273,7 +493,50 @@ NS_ASSUME_NONNULL_END
           }];
 }
 
+// The handler of a streamed request runs right away and pulls the body from the socket as it consumes it
+- (void)_streamBodyWithInitialData:(NSData*)initialData {
+  NSError* error = nil;
+  if (![_request performOpen:&error]) {
+    DWS_LOG_ERROR(@"Failed opening request body for socket %i: %@", _socket, error);
+    [self abortRequest:_request withStatusCode:kDZWebServerHTTPStatusCode_InternalServerError];
+    return;
+  }
+
+  if (_request.usesChunkedTransferEncoding) {
+    NSMutableData* chunkData = [[NSMutableData alloc] initWithData:initialData];
+    _request.bodyPullBlock = ^(DZWebServerBodyPullCompletionBlock completionBlock) {
+      [self pullNextBodyChunk:chunkData completionBlock:completionBlock];
+    };
+  } else {
+    if (initialData.length && ![self writeRequestBodyData:initialData error:&error]) {
+      [self didFailWritingRequestBodyWithError:error];
+      if (![_request performClose:&error]) {
+        DWS_LOG_ERROR(@"Failed closing request body for socket %i: %@", _socket, error);
+      }
+      [self abortRequest:_request withStatusCode:(_requestBodyErrorStatusCode ? _requestBodyErrorStatusCode : kDZWebServerHTTPStatusCode_InternalServerError)];
+      return;
+    }
+    _remainingBodyLength = _request.contentLength - initialData.length;
+    _request.bodyPullBlock = ^(DZWebServerBodyPullCompletionBlock completionBlock) {
+      [self pullBodyWithCompletionBlock:completionBlock];
+    };
+  }
+  [self _startProcessingRequest];
+}
+
+- (void)_readBodyWithInitialData:(NSData*)initialData {
+  _lingersOnClose = NO;
+  if ([_request isKindOfClass:[DZWebServerStreamedRequest class]]) {
+    [self _streamBodyWithInitialData:initialData];
+  } else if (_request.usesChunkedTransferEncoding) {
+    [self _readChunkedBodyWithInitialData:initialData];
+  } else {
+    [self _readBodyWithLength:_request.contentLength initialData:initialData];
+  }
+}
+
 - (void)_readRequestHeaders {
+  _requestStartTime = CFAbsoluteTimeGetCurrent();
   _requestMessage = CFHTTPMessageCreateEmpty(kCFAllocatorDefault, true);
   NSMutableData* headersData = [[NSMutableData alloc] initWithCapacity:kHeadersReadCapacity];
   [self readHeaders:headersData
@@ -305,22 +568,35 @@ NS_ASSUME_NONNULL_END
               }
             }
             if (self->_request) {
+              if (self->_virtualHEAD) {
+                self->_request.headRequest = YES;
+              }
               self->_request.localAddressData = self.localAddressData;
               self->_request.remoteAddressData = self.remoteAddressData;
+              self->_request.bodySizeLimit = self.maximumRequestBodySize;
+              if (self->_server.maximumBufferedRequestBodySize) {
+                self->_request.bufferingServer = self->_server;
+              }
               if ([self->_request hasBody]) {
-                [self->_request prepareForWriting];
-                if (self->_request.usesChunkedTransferEncoding || (extraData.length <= self->_request.contentLength)) {
+                self->_lingersOnClose = YES;  // Until the body is read, a response leaves it in the socket
+                if (![self->_request prepareForWritingWithMaximumDecodedBodySize:self->_server.maximumDecodedBodySize]) {
+                  [self abortRequest:self->_request withStatusCode:kDZWebServerHTTPStatusCode_UnsupportedMediaType];
+                } else if (self.maximumRequestBodySize && !self->_request.usesChunkedTransferEncoding && (self->_request.contentLength > self.maximumRequestBodySize)) {
+                  DWS_LOG_WARNING(@"Request body of %lu bytes exceeds maximum size on socket %i", (unsigned long)self->_request.contentLength, self->_socket);
+                  [self abortRequest:self->_request withStatusCode:kDZWebServerHTTPStatusCode_RequestEntityTooLarge];
+                } else if (self->_request.usesChunkedTransferEncoding || (extraData.length <= self->_request.contentLength)) {
                   NSString* expectHeader = [requestHeaders objectForKey:@"Expect"];
-                  if (expectHeader) {
-                    if ([expectHeader caseInsensitiveCompare:@"100-continue"] == NSOrderedSame) {  // TODO: Actually validate request before continuing
+                  BOOL expectsContinue = expectHeader && ([expectHeader caseInsensitiveCompare:@"100-continue"] == NSOrderedSame);
+                  DZWebServerResponse* rejectionResponse = (expectHeader && !expectsContinue) ? nil : [self _rejectionResponseForRequestBodyWithPreflight:expectsContinue];
+                  if (rejectionResponse) {
+                    self->_processingStartTime = CFAbsoluteTimeGetCurrent();
+                    [self _finishProcessingRequest:rejectionResponse];
+                  } else if (expectHeader) {
+                    if (expectsContinue) {
                       [self writeData:_continueData
                           withCompletionBlock:^(BOOL success) {
                             if (success) {
-                              if (self->_request.usesChunkedTransferEncoding) {
-                                [self _readChunkedBodyWithInitialData:extraData];
-                              } else {
-                                [self _readBodyWithLength:self->_request.contentLength initialData:extraData];
-                              }
+                              [self _readBodyWithInitialData:extraData];
                             }
                           }];
                     } else {
@@ -328,11 +604,7 @@ NS_ASSUME_NONNULL_END
                       [self abortRequest:self->_request withStatusCode:kDZWebServerHTTPStatusCode_ExpectationFailed];
                     }
                   } else {
-                    if (self->_request.usesChunkedTransferEncoding) {
-                      [self _readChunkedBodyWithInitialData:extraData];
-                    } else {
-                      [self _readBodyWithLength:self->_request.contentLength initialData:extraData];
-                    }
+                    [self _readBodyWithInitialData:extraData];
                   }
                 } else {
                   DWS_LOG_ERROR(@"Unexpected 'Content-Length' header value on socket %i", self->_socket);
@@ -362,6 +634,7 @@ NS_ASSUME_NONNULL_END
     _localAddressData = localAddress;
     _remoteAddressData = remoteAddress;
     _socket = socket;
+    _responseLock = OS_UNFAIR_LOCK_INIT;
     DWS_LOG_DEBUG(@"Did open connection on socket %i", _socket);
 
     [_server willStartConnection:self];
@@ -412,6 +685,32 @@ NS_ASSUME_NONNULL_END
 
 @implementation DZWebServerConnection (Read)
 
+// A limit set on the request by the handler match block takes precedence over the server-wide one
+- (NSUInteger)maximumRequestBodySize {
+  return _request.maximumBodySize ? _request.maximumBodySize : _server.maximumRequestBodySize;
+}
+
+// Enforces the body size limit on the wire, which also covers chunked bodies
+- (BOOL)writeRequestBodyData:(NSData*)data error:(NSError**)error {
+  NSUInteger maximumSize = self.maximumRequestBodySize;
+  _receivedBodyLength += data.length;
+  if (maximumSize && (_receivedBodyLength > maximumSize)) {
+    if (error) {
+      *error = [NSError errorWithDomain:kDZWebServerErrorDomain code:kDZWebServerHTTPStatusCode_RequestEntityTooLarge userInfo:@{NSLocalizedDescriptionKey : @"Request body exceeds maximum size"}];
+    }
+    return NO;
+  }
+  return [_request performWriteData:data error:error];
+}
+
+// Errors from content decoders and body limits tell apart rejected bodies from other failures
+- (void)didFailWritingRequestBodyWithError:(NSError*)error {
+  DWS_LOG_ERROR(@"Failed writing request body on socket %i: %@", _socket, error);
+  if ([error.domain isEqualToString:kDZWebServerErrorDomain] && ((error.code == kDZWebServerHTTPStatusCode_RequestEntityTooLarge) || (error.code == kDZWebServerHTTPStatusCode_ServiceUnavailable))) {
+    _requestBodyErrorStatusCode = error.code;
+  }
+}
+
 - (void)readData:(NSMutableData*)data withLength:(NSUInteger)length completionBlock:(ReadDataCompletionBlock)block {
   dispatch_read(_socket, length, dispatch_get_global_queue(_server.dispatchQueuePriority, 0), ^(dispatch_data_t buffer, int error) {
     @autoreleasepool {
@@ -479,7 +778,7 @@ NS_ASSUME_NONNULL_END
         if (success) {
           if (bodyData.length <= length) {
             NSError* error = nil;
-            if ([self->_request performWriteData:bodyData error:&error]) {
+            if ([self writeRequestBodyData:bodyData error:&error]) {
               NSUInteger remainingLength = length - bodyData.length;
               if (remainingLength) {
                 [self readBodyWithRemainingLength:remainingLength completionBlock:block];
@@ -487,7 +786,7 @@ NS_ASSUME_NONNULL_END
                 block(YES);
               }
             } else {
-              DWS_LOG_ERROR(@"Failed writing request body on socket %i: %@", self->_socket, error);
+              [self didFailWritingRequestBodyWithError:error];
               block(NO);
             }
           } else {
@@ -510,7 +809,8 @@ static inline NSUInteger _ScanHexNumber(const void* bytes, NSUInteger size) {
   return ((end != NULL) && (*end == 0) && (result >= 0) ? result : NSNotFound);
 }
 
-- (void)readNextBodyChunk:(NSMutableData*)chunkData completionBlock:(ReadBodyCompletionBlock)block {
+// Writes the complete chunks received so far and sets "finished" once the last chunk and its trailers have been received
+- (BOOL)writeBodyChunks:(NSMutableData*)chunkData finished:(BOOL*)finished error:(NSError**)error {
   DWS_DCHECK([_request hasBody] && [_request usesChunkedTransferEncoding]);
 
   while (1) {
@@ -527,32 +827,44 @@ static inline NSUInteger _ScanHexNumber(const void* bytes, NSUInteger size) {
         }
         const char* ptr = (char*)chunkData.bytes + range.location + range.length + length;
         if ((*ptr == '\r') && (*(ptr + 1) == '\n')) {
-          NSError* error = nil;
-          if ([_request performWriteData:[chunkData subdataWithRange:NSMakeRange(range.location + range.length, length)] error:&error]) {
+          if ([self writeRequestBodyData:[chunkData subdataWithRange:NSMakeRange(range.location + range.length, length)] error:error]) {
             [chunkData replaceBytesInRange:NSMakeRange(0, range.location + range.length + length + 2) withBytes:NULL length:0];
           } else {
-            DWS_LOG_ERROR(@"Failed writing request body on socket %i: %@", _socket, error);
-            block(NO);
-            return;
+            [self didFailWritingRequestBodyWithError:*error];
+            return NO;
           }
         } else {
           DWS_LOG_ERROR(@"Missing terminating CRLF sequence for chunk reading request body on socket %i", _socket);
-          block(NO);
-          return;
+          *error = [NSError errorWithDomain:kDZWebServerErrorDomain code:-1 userInfo:@{NSLocalizedDescriptionKey : @"Invalid chunked request body"}];
+          return NO;
         }
       } else {
         NSRange trailerRange = [chunkData rangeOfData:_CRLFCRLFData options:0 range:NSMakeRange(range.location, chunkData.length - range.location)];  // Ignore trailers
         if (trailerRange.location != NSNotFound) {
-          block(YES);
-          return;
+          *finished = YES;
         }
+        break;
       }
     } else {
       DWS_LOG_ERROR(@"Invalid chunk length reading request body on socket %i", _socket);
-      block(NO);
-      return;
+      *error = [NSError errorWithDomain:kDZWebServerErrorDomain code:-1 userInfo:@{NSLocalizedDescriptionKey : @"Invalid chunked request body"}];
+      return NO;
     }
   }
+  return YES;
+}
+
+- (void)readNextBodyChunk:(NSMutableData*)chunkData completionBlock:(ReadBodyCompletionBlock)block {
+  BOOL finished = NO;
+  NSError* error = nil;
+  if (![self writeBodyChunks:chunkData finished:&finished error:&error]) {
+    block(NO);
+    return;
+  }
+  if (finished) {
+    block(YES);
+    return;
+  }
 
   [self readData:chunkData
            withLength:NSUIntegerMax
@@ -565,6 +877,90 @@ static inline NSUInteger _ScanHexNumber(const void* bytes, NSUInteger size) {
       }];
 }
 
+// Closing the request flushes the content decoders into the data handed out by the last pull
+- (void)finishPullingBodyWithError:(NSError*)error completionBlock:(DZWebServerBodyPullCompletionBlock)block {
+  _request.bodyPullBlock = nil;  // Also breaks the retain cycle with the connection
+  if ((error == nil) && ![_request performClose:&error]) {
+    DWS_LOG_ERROR(@"Failed closing request body for socket %i: %@", _socket, error);
+  }
+  block(YES, error);
+}
+
+- (void)pullBodyWithCompletionBlock:(DZWebServerBodyPullCompletionBlock)block {
+  if (_remainingBodyLength == 0) {
+    [self finishPullingBodyWithError:nil completionBlock:block];
+    return;
+  }
+  NSMutableData* bodyData = [[NSMutableData alloc] initWithCapacity:kBodyReadCapacity];
+  [self readData:bodyData
+           withLength:_remainingBodyLength
+      completionBlock:^(BOOL success) {
+        NSError* error = nil;
+        if (!success) {
+          error = [NSError errorWithDomain:kDZWebServerErrorDomain code:-1 userInfo:@{NSLocalizedDescriptionKey : @"Failed reading request body"}];
+        } else if ([self writeRequestBodyData:bodyData error:&error]) {
+          self->_remainingBodyLength -= bodyData.length;
+          if (self->_remainingBodyLength) {
+            block(NO, nil);
+            return;
+          }
+        } else {
+          [self didFailWritingRequestBodyWithError:error];
+        }
+        [self finishPullingBodyWithError:error completionBlock:block];
+      }];
+}
+
+- (void)pullNextBodyChunk:(NSMutableData*)chunkData completionBlock:(DZWebServerBodyPullCompletionBlock)block {
+  NSUInteger receivedLength = _receivedBodyLength;
+  BOOL finished = NO;
+  NSError* error = nil;
+  if (![self writeBodyChunks:chunkData finished:&finished error:&error] || finished) {
+    [self finishPullingBodyWithError:error completionBlock:block];
+    return;
+  }
+  if (_receivedBodyLength > receivedLength) {
+    block(NO, nil);
+    return;
+  }
+
+  [self readData:chunkData
+           withLength:NSUIntegerMax
+      completionBlock:^(BOOL success) {
+        if (success) {
+          [self pullNextBodyChunk:chunkData completionBlock:block];
+        } else {
+          [self finishPullingBodyWithError:[NSError errorWithDomain:kDZWebServerErrorDomain code:-1 userInfo:@{NSLocalizedDescriptionKey : @"Failed reading request body"}] completionBlock:block];
+        }
+      }];
+}
+
+- (void)discardReceivedDataWithRemainingLength:(NSUInteger)length {
+  dispatch_read(_socket, MIN(length, kBodyReadCapacity), dispatch_get_global_queue(_server.dispatchQueuePriority, 0), ^(dispatch_data_t buffer, int error) {
+    size_t size = error ? 0 : dispatch_data_get_size(buffer);
+    if ((size > 0) && (size < length)) {
+      [self discardReceivedDataWithRemainingLength:(length - size)];
+    }
+  });
+}
+
+// Closing a socket with unread data resets the connection, which can discard the response before the client reads it
+- (void)lingerIfNeeded {
+  if (!_lingersOnClose) {
+    return;
+  }
+  _lingersOnClose = NO;
+  shutdown(_socket, SHUT_WR);
+  DZWebServerConnection* __weak weakSelf = self;
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kLingeringCloseTimeout * NSEC_PER_SEC)), dispatch_get_global_queue(_server.dispatchQueuePriority, 0), ^{
+    DZWebServerConnection* strongSelf = weakSelf;
+    if (strongSelf) {
+      shutdown(strongSelf->_socket, SHUT_RD);  // Ends the pending read if the client keeps the connection open
+    }
+  });
+  [self discardReceivedDataWithRemainingLength:kLingeringCloseMaximumLength];
+}
+
 @end
 
 @implementation DZWebServerConnection (Write)
@@ -590,6 +986,39 @@ static inline NSUInteger _ScanHexNumber(const void* bytes, NSUInteger size) {
 #endif
 }
 
+- (void)writeDataSegments:(NSArray<NSData*>*)segments withCompletionBlock:(WriteDataCompletionBlock)block {
+  dispatch_queue_t queue = dispatch_get_global_queue(_server.dispatchQueuePriority, 0);
+  dispatch_data_t buffer = dispatch_data_empty;
+  for (NSData* segment in segments) {
+    dispatch_data_t region = dispatch_data_create(segment.bytes, segment.length, queue, ^{
+      [segment self];  // Keeps ARC from releasing segment too early
+    });
+    dispatch_data_t concatenatedBuffer = dispatch_data_create_concat(buffer, region);
+#if !OS_OBJECT_USE_OBJC_RETAIN_RELEASE
+    dispatch_release(region);
+    dispatch_release(buffer);
+#endif
+    buffer = concatenatedBuffer;
+  }
+  dispatch_write(_socket, buffer, queue, ^(dispatch_data_t remainingData, int error) {
+    @autoreleasepool {
+      if (error == 0) {
+        DWS_DCHECK(remainingData == NULL);
+        for (NSData* segment in segments) {
+          [self didWriteBytes:segment.bytes length:segment.length];
+        }
+        block(YES);
+      } else {
+        DWS_LOG_ERROR(@"Error while writing to socket %i: %s (%i)", self->_socket, strerror(error), error);
+        block(NO);
+      }
+    }
+  });
+#if !OS_OBJECT_USE_OBJC_RETAIN_RELEASE
+  dispatch_release(buffer);
+#endif
+}
+
 - (void)writeHeadersWithCompletionBlock:(WriteHeadersCompletionBlock)block {
   DWS_DCHECK(_responseMessage);
   CFDataRef data = CFHTTPMessageCopySerializedMessage(_responseMessage);
@@ -597,11 +1026,39 @@ static inline NSUInteger _ScanHexNumber(const void* bytes, NSUInteger size) {
   CFRelease(data);
 }
 
+// Ends a chunked body with the trailers declared in the headers whose values are known by now
+- (NSData*)_lastChunkDataWithTrailers {
+  if (_trailers == nil) {
+    return _lastChunkData;
+  }
+  NSMutableString* string = [NSMutableString stringWithString:@"0\r\n"];
+  for (NSString* trailer in _trailers) {
+    NSString* value = nil;
+    if (_computesContentDigest && [trailer isEqualToString:@"Digest"]) {
+      unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+      CC_SHA256_Final(digest, &_contentDigestContext);
+      value = [@"sha-256=" stringByAppendingString:[[NSData dataWithBytes:digest length:CC_SHA256_DIGEST_LENGTH] base64EncodedStringWithOptions:0]];
+    } else if (_server.shouldAutomaticallySendServerTiming && [trailer isEqualToString:@"Server-Timing"]) {
+      value = [NSString stringWithFormat:@"stream;dur=%.3f", (CFAbsoluteTimeGetCurrent() - _bodyStartTime) * 1000.0];
+    } else {
+      value = [_response.trailerValues objectForKey:trailer];
+    }
+    if (value) {
+      [string appendFormat:@"%@: %@\r\n", trailer, value];
+    }
+  }
+  [string appendString:@"\r\n"];
+  return (NSData*)[string dataUsingEncoding:NSUTF8StringEncoding];
+}
+
 - (void)writeBodyWithCompletionBlock:(WriteBodyCompletionBlock)block {
   DWS_DCHECK([_response hasBody]);
   [_response performReadDataWithCompletion:^(NSData* data, NSError* error) {
     if (data) {
       if (data.length) {
+        if (self->_computesContentDigest) {
+          CC_SHA256_Update(&self->_contentDigestContext, data.bytes, (CC_LONG)data.length);
+        }
         if (self->_response.usesChunkedTransferEncoding) {
           const char* hexString = [[NSString stringWithFormat:@"%lx", (unsigned long)data.length] UTF8String];
           size_t hexLength = strlen(hexString);
@@ -632,7 +1089,7 @@ static inline NSUInteger _ScanHexNumber(const void* bytes, NSUInteger size) {
             }];
       } else {
         if (self->_response.usesChunkedTransferEncoding) {
-          [self writeData:_lastChunkData
+          [self writeData:[self _lastChunkDataWithTrailers]
               withCompletionBlock:^(BOOL success) {
                 block(success);
               }];
@@ -720,7 +1177,7 @@ static inline NSUInteger _ScanHexNumber(const void* bytes, NSUInteger size) {
     }
     if (!authenticated) {
       response = [DZWebServerResponse responseWithStatusCode:kDZWebServerHTTPStatusCode_Unauthorized];
-      [response setValue:[NSString stringWithFormat:@"Basic realm=\"%@\"", _server.authenticationRealm] forAdditionalHeader:@"WWW-Authenticate"];
+      [response setValue:(NSString*)_server.authenticationChallenge forAdditionalHeader:@"WWW-Authenticate"];
     }
   } else if (_server.authenticationDigestAccounts) {
     BOOL authenticated = NO;
@@ -730,13 +1187,13 @@ static inline NSUInteger _ScanHexNumber(const void* bytes, NSUInteger size) {
       NSString* realm = DZWebServerExtractHeaderValueParameter(authorizationHeader, @"realm");
       if (realm && [_server.authenticationRealm isEqualToString:realm]) {
         NSString* nonce = DZWebServerExtractHeaderValueParameter(authorizationHeader, @"nonce");
-        if ([nonce isEqualToString:_digestAuthenticationNonce]) {
+        if ([nonce isEqualToString:(NSString*)_server.authenticationDigestNonce]) {
           NSString* username = DZWebServerExtractHeaderValueParameter(authorizationHeader, @"username");
           NSString* uri = DZWebServerExtractHeaderValueParameter(authorizationHeader, @"uri");
           NSString* actualResponse = DZWebServerExtractHeaderValueParameter(authorizationHeader, @"response");
           NSString* ha1 = [_server.authenticationDigestAccounts objectForKey:username];
           NSString* ha2 = DZWebServerComputeMD5Digest(@"%@:%@", request.method, uri);  // We cannot use "request.path" as the query string is required
-          NSString* expectedResponse = DZWebServerComputeMD5Digest(@"%@:%@:%@", ha1, _digestAuthenticationNonce, ha2);
+          NSString* expectedResponse = DZWebServerComputeMD5Digest(@"%@:%@:%@", ha1, _server.authenticationDigestNonce, ha2);
           if ([actualResponse isEqualToString:expectedResponse]) {
             authenticated = YES;
           }
@@ -747,7 +1204,7 @@ static inline NSUInteger _ScanHexNumber(const void* bytes, NSUInteger size) {
     }
     if (!authenticated) {
       response = [DZWebServerResponse responseWithStatusCode:kDZWebServerHTTPStatusCode_Unauthorized];
-      [response setValue:[NSString stringWithFormat:@"Digest realm=\"%@\", nonce=\"%@\"%@", _server.authenticationRealm, _digestAuthenticationNonce, isStaled ? @", stale=TRUE" : @""] forAdditionalHeader:@"WWW-Authenticate"];  // TODO: Support Quality of Protection ("qop")
+      [response setValue:(NSString*)(isStaled ? _server.staleAuthenticationChallenge : _server.authenticationChallenge) forAdditionalHeader:@"WWW-Authenticate"];
     }
   }
   return response;
@@ -758,28 +1215,91 @@ static inline NSUInteger _ScanHexNumber(const void* bytes, NSUInteger size) {
   _handler.asyncProcessBlock(request, [completion copy]);
 }
 
-// http://www.w3.org/Protocols/rfc2616/rfc2616-sec14.html#sec14.25
-// http://www.w3.org/Protocols/rfc2616/rfc2616-sec14.html#sec14.26
-static inline BOOL _CompareResources(NSString* responseETag, NSString* requestETag, NSDate* responseLastModified, NSDate* requestLastModified) {
-  if (requestLastModified && responseLastModified) {
-    if ([responseLastModified compare:requestLastModified] != NSOrderedDescending) {
-      return YES;
-    }
+// Strips the weak indicator and the surrounding quotes so that quoted and unquoted ETags compare equal
+static NSString* _NormalizeETag(NSString* eTag, BOOL* isWeak) {
+  NSString* value = [eTag stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+  *isWeak = [value hasPrefix:@"W/"];
+  if (*isWeak) {
+    value = [value substringFromIndex:2];
   }
-  if (requestETag && responseETag) {  // Per the specs "If-None-Match" must be checked after "If-Modified-Since"
-    if ([requestETag isEqualToString:@"*"]) {
-      return YES;
+  if ((value.length >= 2) && [value hasPrefix:@"\""] && [value hasSuffix:@"\""]) {
+    value = [value substringWithRange:NSMakeRange(1, value.length - 2)];
+  }
+  return value;
+}
+
+// https://www.rfc-editor.org/rfc/rfc7232#section-2.3.2
+static BOOL _ETagListMatchesETag(NSString* list, NSString* responseETag, BOOL strongComparison) {
+  if ([[list stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]] isEqualToString:@"*"]) {
+    return YES;
+  }
+  if (responseETag == nil) {
+    return NO;
+  }
+  BOOL responseIsWeak;
+  NSString* eTag = _NormalizeETag(responseETag, &responseIsWeak);
+  if (strongComparison && responseIsWeak) {
+    return NO;
+  }
+  for (NSString* component in [list componentsSeparatedByString:@","]) {
+    BOOL isWeak;
+    NSString* candidate = _NormalizeETag(component, &isWeak);
+    if (strongComparison && isWeak) {
+      continue;
     }
-    if ([responseETag isEqualToString:requestETag]) {
+    if ([candidate isEqualToString:eTag]) {
       return YES;
     }
   }
   return NO;
 }
 
+// HTTP dates have a one second resolution while file modification dates do not
+static inline NSTimeInterval _HTTPTimeInterval(NSDate* date) {
+  return floor(date.timeIntervalSince1970);
+}
+
+// https://www.rfc-editor.org/rfc/rfc7232#section-6
+static NSInteger _EvaluatePreconditions(DZWebServerRequest* request, DZWebServerResponse* response) {
+  BOOL isGETOrHEAD = [request.method isEqualToString:@"GET"] || [request.method isEqualToString:@"HEAD"];
+  NSDate* lastModified = response.lastModifiedDate;
+  if (request.ifMatch) {
+    if (!_ETagListMatchesETag(request.ifMatch, response.eTag, YES)) {
+      return kDZWebServerHTTPStatusCode_PreconditionFailed;
+    }
+  } else if (request.ifUnmodifiedSince && lastModified) {
+    if (_HTTPTimeInterval(lastModified) > _HTTPTimeInterval(request.ifUnmodifiedSince)) {
+      return kDZWebServerHTTPStatusCode_PreconditionFailed;
+    }
+  }
+  if (request.ifNoneMatch) {  // "If-Modified-Since" is ignored when "If-None-Match" is present
+    if (_ETagListMatchesETag(request.ifNoneMatch, response.eTag, NO)) {
+      return isGETOrHEAD ? kDZWebServerHTTPStatusCode_NotModified : kDZWebServerHTTPStatusCode_PreconditionFailed;
+    }
+  } else if (isGETOrHEAD && request.ifModifiedSince && lastModified) {
+    if (_HTTPTimeInterval(lastModified) <= _HTTPTimeInterval(request.ifModifiedSince)) {
+      return kDZWebServerHTTPStatusCode_NotModified;
+    }
+  }
+  return 0;
+}
+
+// https://www.rfc-editor.org/rfc/rfc7233#section-3.2
+static BOOL _IfRangeMatchesResponse(NSString* ifRange, DZWebServerResponse* response) {
+  NSDate* date = DZWebServerParseRFC822(ifRange);
+  if (date) {
+    return response.lastModifiedDate && (_HTTPTimeInterval(response.lastModifiedDate) == _HTTPTimeInterval(date));
+  }
+  return (response.eTag != nil) && ![ifRange hasPrefix:@"W/"] && _ETagListMatchesETag(ifRange, response.eTag, YES);
+}
+
 - (DZWebServerResponse*)overrideResponse:(DZWebServerResponse*)response forRequest:(DZWebServerRequest*)request {
-  if ((response.statusCode >= 200) && (response.statusCode < 300) && _CompareResources(response.eTag, request.ifNoneMatch, response.lastModifiedDate, request.ifModifiedSince)) {
-    NSInteger code = [request.method isEqualToString:@"HEAD"] || [request.method isEqualToString:@"GET"] ? (NSInteger)kDZWebServerHTTPStatusCode_NotModified : (NSInteger)kDZWebServerHTTPStatusCode_PreconditionFailed;
+  BOOL isRangeResponse = (response.statusCode == kDZWebServerHTTPStatusCode_PartialContent) || (response.statusCode == kDZWebServerHTTPStatusCode_RequestedRangeNotSatisfiable);
+  if (!isRangeResponse && ((response.statusCode < 200) || (response.statusCode >= 300))) {
+    return response;
+  }
+  NSInteger code = _EvaluatePreconditions(request, response);
+  if (code) {
     DZWebServerResponse* newResponse = [DZWebServerResponse responseWithStatusCode:code];
     newResponse.cacheControlMaxAge = response.cacheControlMaxAge;
     newResponse.lastModifiedDate = response.lastModifiedDate;
@@ -787,15 +1307,21 @@ static inline BOOL _CompareResources(NSString* responseETag, NSString* requestET
     DWS_DCHECK(newResponse);
     return newResponse;
   }
+  if (isRangeResponse && request.ifRange && [response isKindOfClass:[DZWebServerFileResponse class]] && !_IfRangeMatchesResponse(request.ifRange, response)) {
+    DWS_LOG_DEBUG(@"Ignoring 'Range' header on socket %i as 'If-Range' validator \"%@\" no longer matches", _socket, request.ifRange);
+    [(DZWebServerFileResponse*)response discardByteRanges];
+  }
   return response;
 }
 
 - (void)abortRequest:(DZWebServerRequest*)request withStatusCode:(NSInteger)statusCode {
   DWS_DCHECK(_responseMessage == NULL);
   DWS_DCHECK((statusCode >= 400) && (statusCode < 600));
+  [self _markResponseStarted];
+  _request.bodyPullBlock = nil;
   [self _initializeResponseHeadersWithStatusCode:statusCode];
-  [self writeHeadersWithCompletionBlock:^(BOOL success){
-      // Nothing more to do
+  [self writeHeadersWithCompletionBlock:^(BOOL success) {
+    [self lingerIfNeeded];
   }];
   DWS_LOG_DEBUG(@"Connection aborted with status code %i on socket %i", (int)statusCode, _socket);
 }
@@ -0,0 +1,546 @@
+/*
+ Copyright (c) 2012-2019, Pierre-Olivier Latour
+ Copyright (c) 2024, Dominic Rodemer
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * The name of Pierre-Olivier Latour may not be used to endorse
+ or promote products derived from this software without specific
+ prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL PIERRE-OLIVIER LATOUR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !__has_feature(objc_arc)
+#error DZWebServer requires ARC
+#endif
+
+#import <sys/stat.h>
+
+#import "DZWebServerPrivate.h"
+
+#define kFileDescriptorCacheCountLimit 64
+#define kFileDescriptorCacheMaximumAge 10.0
+
+static inline BOOL _IsSameFileInfo(const struct stat* info1, const struct stat* info2) {
+  return (info1->st_dev == info2->st_dev) && (info1->st_ino == info2->st_ino) && (info1->st_size == info2->st_size) && (info1->st_mtimespec.tv_sec == info2->st_mtimespec.tv_sec) && (info1->st_mtimespec.tv_nsec == info2->st_mtimespec.tv_nsec);
+}
+
+@interface DZWebServerLRUCacheNode : NSObject {
+ @package
+  id<NSCopying> _key;
+  id _object;
+  NSUInteger _cost;
+  CFAbsoluteTime _accessTime;
+  DZWebServerLRUCacheNode* __unsafe_unretained _previous;  // Nodes are owned by the dictionary
+  DZWebServerLRUCacheNode* __unsafe_unretained _next;
+}
+@end
+
+@implementation DZWebServerLRUCacheNode
+@end
+
+@implementation DZWebServerLRUCache {
+  dispatch_queue_t _syncQueue;
+  NSMutableDictionary<id<NSCopying>, DZWebServerLRUCacheNode*>* _nodes;
+  DZWebServerLRUCacheNode* __unsafe_unretained _head;  // Most recently used
+  DZWebServerLRUCacheNode* __unsafe_unretained _tail;  // Least recently used
+  NSUInteger _totalCost;
+  dispatch_source_t _expirationTimer;  // Only created once a maximum age is set
+  BOOL _expirationTimerArmed;
+}
+
+- (instancetype)initWithCountLimit:(NSUInteger)countLimit totalCostLimit:(NSUInteger)totalCostLimit {
+  if ((self = [super init])) {
+    _countLimit = countLimit;
+    _totalCostLimit = totalCostLimit;
+    _syncQueue = dispatch_queue_create([NSStringFromClass([self class]) UTF8String], DISPATCH_QUEUE_SERIAL);
+    _nodes = [[NSMutableDictionary alloc] init];
+  }
+  return self;
+}
+
+- (void)dealloc {
+  if (_expirationTimer) {
+    dispatch_source_cancel(_expirationTimer);
+#if !OS_OBJECT_USE_OBJC_RETAIN_RELEASE
+    dispatch_release(_expirationTimer);
+#endif
+  }
+#if !OS_OBJECT_USE_OBJC_RETAIN_RELEASE
+  dispatch_release(_syncQueue);
+#endif
+}
+
+- (void)setMaximumAge:(NSTimeInterval)maximumAge {
+  dispatch_sync(_syncQueue, ^{
+    self->_maximumAge = maximumAge;
+    if ((maximumAge > 0.0) && (self->_expirationTimer == NULL)) {
+      self->_expirationTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, self->_syncQueue);
+      __weak DZWebServerLRUCache* weakSelf = self;  // The timer must not keep the cache alive
+      dispatch_source_set_event_handler(self->_expirationTimer, ^{
+        DZWebServerLRUCache* strongSelf = weakSelf;
+        if (strongSelf) {
+          strongSelf->_expirationTimerArmed = NO;
+          [strongSelf _trimAtTime:CFAbsoluteTimeGetCurrent()];
+        }
+      });
+      dispatch_source_set_timer(self->_expirationTimer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+      dispatch_resume(self->_expirationTimer);
+    }
+    self->_expirationTimerArmed = NO;
+    [self _trimAtTime:CFAbsoluteTimeGetCurrent()];
+  });
+}
+
+// Must be called on _syncQueue
+- (void)_unlinkNode:(DZWebServerLRUCacheNode*)node {
+  if (node->_previous) {
+    node->_previous->_next = node->_next;
+  } else {
+    _head = node->_next;
+  }
+  if (node->_next) {
+    node->_next->_previous = node->_previous;
+  } else {
+    _tail = node->_previous;
+  }
+  node->_previous = nil;
+  node->_next = nil;
+}
+
+// Must be called on _syncQueue
+- (void)_linkNodeAtHead:(DZWebServerLRUCacheNode*)node {
+  node->_previous = nil;
+  node->_next = _head;
+  if (_head) {
+    _head->_previous = node;
+  }
+  _head = node;
+  if (_tail == nil) {
+    _tail = node;
+  }
+}
+
+// Must be called on _syncQueue
+- (void)_removeNode:(DZWebServerLRUCacheNode*)node {
+  id<NSCopying> key = node->_key;
+  [self _unlinkNode:node];
+  _totalCost -= node->_cost;
+  [_nodes removeObjectForKey:key];  // Must be last as this releases the node
+}
+
+// Must be called on _syncQueue
+- (void)_trimAtTime:(CFAbsoluteTime)time {
+  while (_tail && (((_countLimit > 0) && (_nodes.count > _countLimit)) || ((_totalCostLimit > 0) && (_totalCost > _totalCostLimit)) || ((_maximumAge > 0.0) && (time - _tail->_accessTime > _maximumAge)))) {
+    [self _removeNode:_tail];
+  }
+
+  // The least recently used node expires first and its expiration time only moves later, so the timer is armed for it
+  // once and re-armed when it fires, which releases expired objects even while the cache is not accessed
+  if (_expirationTimer && !_expirationTimerArmed && _tail && (_maximumAge > 0.0)) {
+    NSTimeInterval delay = MAX(_tail->_accessTime + _maximumAge - time, 0.0);
+    dispatch_source_set_timer(_expirationTimer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), DISPATCH_TIME_FOREVER, NSEC_PER_SEC);
+    _expirationTimerArmed = YES;
+  }
+}
+
+- (id)objectForKey:(id<NSCopying>)key {
+  __block id object = nil;
+  dispatch_sync(_syncQueue, ^{
+    CFAbsoluteTime time = CFAbsoluteTimeGetCurrent();
+    DZWebServerLRUCacheNode* node = [self->_nodes objectForKey:key];
+    if (node) {
+      if ((self->_maximumAge > 0.0) && (time - node->_accessTime > self->_maximumAge)) {
+        [self _removeNode:node];
+      } else {
+        if (node != self->_head) {
+          [self _unlinkNode:node];
+          [self _linkNodeAtHead:node];
+        }
+        node->_accessTime = time;
+        object = node->_object;
+      }
+    }
+    [self _trimAtTime:time];
+  });
+  return object;
+}
+
+- (void)setObject:(id)object forKey:(id<NSCopying>)key cost:(NSUInteger)cost {
+  dispatch_sync(_syncQueue, ^{
+    DZWebServerLRUCacheNode* node = [self->_nodes objectForKey:key];
+    if (node) {
+      [self _removeNode:node];
+    }
+    if ((self->_totalCostLimit > 0) && (cost > self->_totalCostLimit)) {
+      return;
+    }
+    node = [[DZWebServerLRUCacheNode alloc] init];
+    node->_key = [key copyWithZone:NULL];
+    node->_object = object;
+    node->_cost = cost;
+    node->_accessTime = CFAbsoluteTimeGetCurrent();
+    [self->_nodes setObject:node forKey:node->_key];
+    [self _linkNodeAtHead:node];
+    self->_totalCost += cost;
+    [self _trimAtTime:node->_accessTime];
+  });
+}
+
+- (void)removeObjectForKey:(id<NSCopying>)key {
+  dispatch_sync(_syncQueue, ^{
+    DZWebServerLRUCacheNode* node = [self->_nodes objectForKey:key];
+    if (node) {
+      [self _removeNode:node];
+    }
+  });
+}
+
+- (void)removeAllObjects {
+  dispatch_sync(_syncQueue, ^{
+    self->_head = nil;
+    self->_tail = nil;
+    self->_totalCost = 0;
+    [self->_nodes removeAllObjects];
+  });
+}
+
+- (NSUInteger)count {
+  __block NSUInteger count;
+  dispatch_sync(_syncQueue, ^{
+    count = self->_nodes.count;
+  });
+  return count;
+}
+
+- (NSUInteger)totalCost {
+  __block NSUInteger cost;
+  dispatch_sync(_syncQueue, ^{
+    cost = self->_totalCost;
+  });
+  return cost;
+}
+
+@end
+
+@implementation DZWebServerCachedFile {
+  struct stat _info;
+}
+
+- (instancetype)initWithPath:(NSString*)path info:(const struct stat*)info {
+  if ((self = [super init])) {
+    _path = [path copy];
+    _info = *info;
+    _fileDescriptor = -1;
+    if (S_ISREG(info->st_mode)) {
+      int file = open([path fileSystemRepresentation], O_NOFOLLOW | O_RDONLY);
+      if (file > 0) {
+        struct stat fileInfo;
+        if ((fstat(file, &fileInfo) == 0) && _IsSameFileInfo(&fileInfo, info)) {
+          _fileDescriptor = file;
+        } else {
+          close(file);  // File was replaced between lstat() and open()
+          _openError = ESTALE;
+        }
+      } else {
+        _openError = errno;
+      }
+    }
+  }
+  return self;
+}
+
+- (void)dealloc {
+  if (_fileDescriptor > 0) {
+    close(_fileDescriptor);
+  }
+}
+
+- (const struct stat*)info {
+  return &_info;
+}
+
+@end
+
+@implementation DZWebServerFileDescriptorCache {
+  DZWebServerLRUCache* _files;
+}
+
++ (instancetype)sharedCache {
+  static DZWebServerFileDescriptorCache* cache = nil;
+  static dispatch_once_t onceToken = 0;
+  dispatch_once(&onceToken, ^{
+    cache = [[DZWebServerFileDescriptorCache alloc] init];
+  });
+  return cache;
+}
+
+- (instancetype)init {
+  if ((self = [super init])) {
+    _files = [[DZWebServerLRUCache alloc] initWithCountLimit:kFileDescriptorCacheCountLimit totalCostLimit:0];
+    _files.maximumAge = kFileDescriptorCacheMaximumAge;
+  }
+  return self;
+}
+
+- (DZWebServerCachedFile*)fileForPath:(NSString*)path {
+  struct stat info;
+  if (lstat([path fileSystemRepresentation], &info)) {
+    [_files removeObjectForKey:path];
+    return nil;
+  }
+  if (!S_ISREG(info.st_mode)) {
+    return [[DZWebServerCachedFile alloc] initWithPath:path info:&info];  // Only regular files are worth caching
+  }
+
+  DZWebServerCachedFile* file = [_files objectForKey:path];
+  if (file && _IsSameFileInfo(file.info, &info)) {
+    return file;
+  }
+  file = [[DZWebServerCachedFile alloc] initWithPath:path info:&info];
+  if (file.fileDescriptor > 0) {
+    [_files setObject:file forKey:path cost:1];  // Previous file descriptor for this path, if any, is closed once all responses using it are done
+  } else {
+    [_files removeObjectForKey:path];
+  }
+  return file;
+}
+
+- (void)removeFileForPath:(NSString*)path {
+  [_files removeObjectForKey:path];
+}
+
+- (void)removeAllFiles {
+  [_files removeAllObjects];
+}
+
+@end
+
+@implementation DZWebServerFileCacheEntry {
+  struct stat _info;
+}
+
+- (instancetype)initWithData:(NSData*)data contentType:(NSString*)contentType info:(const struct stat*)info {
+  if ((self = [super init])) {
+    _data = data;
+    _contentType = [contentType copy];
+    _info = *info;
+    _lastModifiedDate = [NSDate dateWithTimeIntervalSince1970:((NSTimeInterval)info->st_mtimespec.tv_sec + (NSTimeInterval)info->st_mtimespec.tv_nsec / 1000000000.0)];
+    _eTag = [NSString stringWithFormat:@"%llu/%li/%li", info->st_ino, info->st_mtimespec.tv_sec, info->st_mtimespec.tv_nsec];  // Same format as DZWebServerFileResponse
+  }
+  return self;
+}
+
+- (BOOL)isValidForInfo:(const struct stat*)info {
+  return _IsSameFileInfo(info, &_info);
+}
+
+@end
+
+@implementation DZWebServerFileCache {
+  DZWebServerLRUCache* _entries;
+}
+
+- (instancetype)initWithMaximumSize:(NSUInteger)maximumSize maximumFileSize:(NSUInteger)maximumFileSize {
+  if ((self = [super init])) {
+    _maximumSize = maximumSize;
+    _maximumFileSize = MIN(maximumFileSize, maximumSize);
+    _entries = [[DZWebServerLRUCache alloc] initWithCountLimit:0 totalCostLimit:maximumSize];
+  }
+  return self;
+}
+
+static NSData* _ReadFileContents(DZWebServerCachedFile* file) {
+  NSMutableData* data = [[NSMutableData alloc] initWithLength:(NSUInteger)file.info->st_size];
+  size_t offset = 0;
+  while (offset < data.length) {
+    ssize_t result = pread(file.fileDescriptor, (char*)data.mutableBytes + offset, data.length - offset, offset);
+    if (result <= 0) {
+      if ((result < 0) && (errno == EINTR)) {
+        continue;
+      }
+      return nil;
+    }
+    offset += result;
+  }
+  struct stat info;
+  if ((fstat(file.fileDescriptor, &info) != 0) || !_IsSameFileInfo(&info, file.info)) {  // Make sure the file was not modified while being read
+    return nil;
+  }
+  return data;
+}
+
+- (DZWebServerFileCacheEntry*)entryForFile:(DZWebServerCachedFile*)file {
+  NSString* path = file.path;
+  if (!S_ISREG(file.info->st_mode)) {
+    [_entries removeObjectForKey:path];
+    return nil;
+  }
+
+  DZWebServerFileCacheEntry* entry = [_entries objectForKey:path];
+  if (entry) {
+    if ([entry isValidForInfo:file.info]) {
+      return entry;
+    }
+    DWS_LOG_DEBUG(@"Invalidating cached contents of file \"%@\"", path);
+    [_entries removeObjectForKey:path];
+  }
+
+  if ((file.fileDescriptor <= 0) || (file.info->st_size < 0) || ((unsigned long long)file.info->st_size > _maximumFileSize)) {
+    return nil;
+  }
+  NSData* data = _ReadFileContents(file);
+  if (data == nil) {
+    return nil;
+  }
+  entry = [[DZWebServerFileCacheEntry alloc] initWithData:data contentType:DZWebServerGetMimeTypeForExtension([path pathExtension], nil) info:file.info];
+  [_entries setObject:entry forKey:path cost:data.length];
+  DWS_LOG_DEBUG(@"Cached contents of file \"%@\" (%lu bytes)", path, (unsigned long)data.length);
+  return entry;
+}
+
+- (void)removeAllEntries {
+  [_entries removeAllObjects];
+}
+
+@end
+
+@interface DZWebServerNegativeLookupEntry : NSObject {
+ @package
+  NSString* _directoryPath;  // Deepest existing directory along the missing path
+  struct stat _directoryInfo;
+}
+@end
+
+@implementation DZWebServerNegativeLookupEntry
+@end
+
+@implementation DZWebServerNegativeLookupCache {
+  DZWebServerLRUCache* _entries;
+}
+
+- (instancetype)initWithCountLimit:(NSUInteger)countLimit {
+  if ((self = [super init])) {
+    _entries = [[DZWebServerLRUCache alloc] initWithCountLimit:countLimit totalCostLimit:0];
+  }
+  return self;
+}
+
+- (BOOL)containsKey:(NSString*)key {
+  DZWebServerNegativeLookupEntry* entry = [_entries objectForKey:key];
+  if (entry == nil) {
+    return NO;
+  }
+  struct stat info;  // Creating anything along the missing path must first add an entry to this directory, which updates its mtime
+  if ((stat([entry->_directoryPath fileSystemRepresentation], &info) == 0) && _IsSameFileInfo(&info, &entry->_directoryInfo)) {
+    return YES;
+  }
+  [_entries removeObjectForKey:key];
+  return NO;
+}
+
+- (void)addKey:(NSString*)key forMissingPath:(NSString*)path rootDirectory:(NSString*)rootDirectory {
+  while ((rootDirectory.length > 1) && [rootDirectory hasSuffix:@"/"]) {
+    rootDirectory = [rootDirectory substringToIndex:(rootDirectory.length - 1)];
+  }
+  NSString* directoryPath = [path stringByDeletingLastPathComponent];
+  while ([directoryPath hasPrefix:rootDirectory]) {
+    DZWebServerNegativeLookupEntry* entry = [[DZWebServerNegativeLookupEntry alloc] init];
+    if (stat([directoryPath fileSystemRepresentation], &entry->_directoryInfo) == 0) {  // Follows symlinks so the directory that actually receives new entries is watched
+      if (S_ISDIR(entry->_directoryInfo.st_mode)) {
+        entry->_directoryPath = directoryPath;
+        [_entries setObject:entry forKey:key cost:1];
+        return;
+      }
+    }
+    NSString* parentPath = [directoryPath stringByDeletingLastPathComponent];
+    if ([parentPath isEqualToString:directoryPath]) {
+      break;
+    }
+    directoryPath = parentPath;
+  }
+}
+
+@end
+
+@implementation DZWebServerEncodedContentCache {
+  DZWebServerLRUCache* _cache;
+  dispatch_queue_t _syncQueue;
+  NSMutableDictionary<NSString*, dispatch_group_t>* _pendingGroups;  // Accessed through _syncQueue only
+}
+
+- (instancetype)initWithMaximumSize:(NSUInteger)maximumSize {
+  if ((self = [super init])) {
+    _maximumSize = maximumSize;
+    _cache = [[DZWebServerLRUCache alloc] initWithCountLimit:0 totalCostLimit:maximumSize];
+    _syncQueue = dispatch_queue_create([NSStringFromClass([self class]) UTF8String], DISPATCH_QUEUE_SERIAL);
+    _pendingGroups = [[NSMutableDictionary alloc] init];
+  }
+  return self;
+}
+
+#if !OS_OBJECT_USE_OBJC_RETAIN_RELEASE
+
+- (void)dealloc {
+  dispatch_release(_syncQueue);
+}
+
+#endif
+
+- (NSData*)dataForKey:(NSString*)key producer:(NSData* _Nullable (^)(void))producer {
+  __block NSData* data = nil;
+  __block dispatch_group_t group = nil;
+  __block BOOL isProducer = NO;
+  dispatch_sync(_syncQueue, ^{
+    data = [self->_cache objectForKey:key];  // Check again under _syncQueue so a producer finishing concurrently is never missed
+    if (data == nil) {
+      group = [self->_pendingGroups objectForKey:key];
+      if (group == nil) {
+        group = dispatch_group_create();
+        dispatch_group_enter(group);
+        [self->_pendingGroups setObject:group forKey:key];
+        isProducer = YES;
+      }
+    }
+  });
+  if (data) {
+    return data;
+  }
+
+  if (isProducer) {
+    data = producer();
+    dispatch_sync(_syncQueue, ^{
+      if (data) {
+        [self->_cache setObject:data forKey:key cost:data.length];
+      }
+      [self->_pendingGroups removeObjectForKey:key];
+    });
+    dispatch_group_leave(group);
+    return data;
+  }
+
+  dispatch_group_wait(group, DISPATCH_TIME_FOREVER);  // Another connection is already encoding the same content
+  return [_cache objectForKey:key];  // Can be nil if the producer failed or the entry was evicted immediately
+}
+
+- (void)removeAllEntries {
+  [_cache removeAllObjects];
+}
+
+@end
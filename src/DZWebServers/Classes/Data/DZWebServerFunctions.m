@@ -37,15 +37,26 @@
 #endif
 #import <CommonCrypto/CommonDigest.h>
 
+#import <copyfile.h>
 #import <ifaddrs.h>
 #import <net/if.h>
 #import <netdb.h>
+#import <os/lock.h>
 
 #import "DZWebServerPrivate.h"
 
+#define kXXH64Prime1 0x9E3779B185EBCA87ULL
+#define kXXH64Prime2 0xC2B2AE3D27D4EB4FULL
+#define kXXH64Prime3 0x165667B19E3779F9ULL
+#define kXXH64Prime4 0x85EBCA77C2B2AE63ULL
+#define kXXH64Prime5 0x27D4EB2F165667C5ULL
+
 static NSDateFormatter* _dateFormatterRFC822 = nil;
 static NSDateFormatter* _dateFormatterISO8601 = nil;
 static dispatch_queue_t _dateFormatterQueue = NULL;
+static os_unfair_lock _currentDateLock = OS_UNFAIR_LOCK_INIT;
+static time_t _currentDateTime = 0;
+static NSString* _currentDateString = nil;
 
 // TODO: Handle RFC 850 and ANSI C's asctime() format
 void DZWebServerInitializeFunctions(void) {
@@ -127,6 +138,21 @@ NSString* DZWebServerFormatRFC822(NSDate* date) {
   return string;
 }
 
+NSString* DZWebServerFormatCurrentRFC822(void) {
+  time_t now = time(NULL);
+  os_unfair_lock_lock(&_currentDateLock);
+  NSString* string = (now == _currentDateTime) ? _currentDateString : nil;
+  os_unfair_lock_unlock(&_currentDateLock);
+  if (string == nil) {
+    string = DZWebServerFormatRFC822([NSDate dateWithTimeIntervalSince1970:now]);
+    os_unfair_lock_lock(&_currentDateLock);
+    _currentDateTime = now;
+    _currentDateString = string;
+    os_unfair_lock_unlock(&_currentDateLock);
+  }
+  return string;
+}
+
 NSDate* DZWebServerParseRFC822(NSString* string) {
   __block NSDate* date;
   dispatch_sync(_dateFormatterQueue, ^{
@@ -155,6 +181,26 @@ BOOL DZWebServerIsTextContentType(NSString* type) {
   return ([type hasPrefix:@"text/"] || [type hasPrefix:@"application/json"] || [type hasPrefix:@"application/xml"]);
 }
 
+BOOL DZWebServerIsCompressibleContentType(NSString* type) {
+  if (type == nil) {
+    return NO;
+  }
+  NSRange range = [type rangeOfString:@";"];
+  NSString* mimeType = [(range.location != NSNotFound ? [type substringToIndex:range.location] : type) stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]].lowercaseString;
+  if ([mimeType isEqualToString:@"text/event-stream"]) {
+    return NO;  // Compressing would delay delivery of individual events
+  }
+  if (DZWebServerIsTextContentType(mimeType) || [mimeType hasSuffix:@"+json"] || [mimeType hasSuffix:@"+xml"]) {
+    return YES;
+  }
+  static NSSet<NSString*>* compressibleTypes = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    compressibleTypes = [[NSSet alloc] initWithObjects:@"application/javascript", @"application/x-javascript", @"application/ecmascript", @"application/wasm", @"application/manifest+json", @"application/x-www-form-urlencoded", @"application/vnd.ms-fontobject", @"application/x-font-ttf", @"font/ttf", @"font/otf", @"image/bmp", @"image/x-icon", @"image/vnd.microsoft.icon", nil];
+  });
+  return [compressibleTypes containsObject:mimeType];
+}
+
 NSString* DZWebServerDescribeData(NSData* data, NSString* type) {
   if (DZWebServerIsTextContentType(type)) {
     NSString* charset = DZWebServerExtractHeaderValueParameter(type, @"charset");
@@ -321,6 +367,84 @@ NSString* DZWebServerComputeMD5Digest(NSString* format, ...) {
   return (NSString*)[NSString stringWithUTF8String:buffer];
 }
 
+static inline uint64_t _RotateLeft64(uint64_t value, int count) {
+  return (value << count) | (value >> (64 - count));
+}
+
+static inline uint64_t _ReadLittleEndian64(const uint8_t* bytes) {
+  uint64_t value;
+  memcpy(&value, bytes, sizeof(value));
+  return CFSwapInt64LittleToHost(value);
+}
+
+static inline uint32_t _ReadLittleEndian32(const uint8_t* bytes) {
+  uint32_t value;
+  memcpy(&value, bytes, sizeof(value));
+  return CFSwapInt32LittleToHost(value);
+}
+
+static inline uint64_t _XXH64Round(uint64_t accumulator, uint64_t input) {
+  accumulator += input * kXXH64Prime2;
+  accumulator = _RotateLeft64(accumulator, 31);
+  return accumulator * kXXH64Prime1;
+}
+
+static inline uint64_t _XXH64MergeRound(uint64_t hash, uint64_t accumulator) {
+  hash ^= _XXH64Round(0, accumulator);
+  return hash * kXXH64Prime1 + kXXH64Prime4;
+}
+
+// https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+// The four independent lanes let the compiler interleave the multiplications of each 32 byte stripe
+uint64_t DZWebServerComputeHash64(const void* bytes, size_t length) {
+  const uint8_t* p = bytes;
+  const uint8_t* end = p + length;
+  uint64_t hash;
+  if (length >= 32) {
+    const uint8_t* limit = end - 32;
+    uint64_t v1 = kXXH64Prime1 + kXXH64Prime2;
+    uint64_t v2 = kXXH64Prime2;
+    uint64_t v3 = 0;
+    uint64_t v4 = -kXXH64Prime1;
+    do {
+      v1 = _XXH64Round(v1, _ReadLittleEndian64(p));
+      v2 = _XXH64Round(v2, _ReadLittleEndian64(p + 8));
+      v3 = _XXH64Round(v3, _ReadLittleEndian64(p + 16));
+      v4 = _XXH64Round(v4, _ReadLittleEndian64(p + 24));
+      p += 32;
+    } while (p <= limit);
+    hash = _RotateLeft64(v1, 1) + _RotateLeft64(v2, 7) + _RotateLeft64(v3, 12) + _RotateLeft64(v4, 18);
+    hash = _XXH64MergeRound(hash, v1);
+    hash = _XXH64MergeRound(hash, v2);
+    hash = _XXH64MergeRound(hash, v3);
+    hash = _XXH64MergeRound(hash, v4);
+  } else {
+    hash = kXXH64Prime5;
+  }
+  hash += (uint64_t)length;
+  while (p + 8 <= end) {
+    hash ^= _XXH64Round(0, _ReadLittleEndian64(p));
+    hash = _RotateLeft64(hash, 27) * kXXH64Prime1 + kXXH64Prime4;
+    p += 8;
+  }
+  if (p + 4 <= end) {
+    hash ^= (uint64_t)_ReadLittleEndian32(p) * kXXH64Prime1;
+    hash = _RotateLeft64(hash, 23) * kXXH64Prime2 + kXXH64Prime3;
+    p += 4;
+  }
+  while (p < end) {
+    hash ^= (uint64_t)(*p) * kXXH64Prime5;
+    hash = _RotateLeft64(hash, 11) * kXXH64Prime1;
+    p += 1;
+  }
+  hash ^= hash >> 33;
+  hash *= kXXH64Prime2;
+  hash ^= hash >> 29;
+  hash *= kXXH64Prime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
 NSString* DZWebServerNormalizePath(NSString* path) {
   NSMutableArray* components = [[NSMutableArray alloc] init];
   for (NSString* component in [path componentsSeparatedByString:@"/"]) {
@@ -335,3 +459,50 @@ NSString* DZWebServerNormalizePath(NSString* path) {
   }
   return [components componentsJoinedByString:@"/"];
 }
+
+// The declared length comes from the client so disk space is only reserved up to a limit the server enforces anyway
+int DZWebServerCreateSpoolFile(NSString* path, NSUInteger length, NSUInteger maximumLength) {
+  int file = open([path fileSystemRepresentation], O_CREAT | O_EXCL | O_WRONLY, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if ((file >= 0) && length && (length != NSUIntegerMax) && maximumLength) {
+    length = MIN(length, maximumLength);
+    fstore_t store = {F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, (off_t)length, 0};
+    if (fcntl(file, F_PREALLOCATE, &store) < 0) {
+      store.fst_flags = F_ALLOCATEALL;
+      if (fcntl(file, F_PREALLOCATE, &store) < 0) {
+        DWS_LOG_DEBUG(@"Failed preallocating %lu bytes for \"%@\": %s (%i)", (unsigned long)length, path, strerror(errno), errno);  // Not fatal as writing extends the file anyway
+      }
+    }
+  }
+  return file;
+}
+
+BOOL DZWebServerMoveSpoolFile(NSString* path, NSString* destinationPath, NSError** error) {
+  if (rename([path fileSystemRepresentation], [destinationPath fileSystemRepresentation]) == 0) {
+    return YES;
+  }
+  if (errno != EXDEV) {
+    if (error) {
+      *error = DZWebServerMakePosixError(errno);
+    }
+    return NO;
+  }
+
+  // Copy across volumes next to the destination first so it can still be replaced with a rename()
+  NSString* temporaryPath = [[destinationPath stringByDeletingLastPathComponent] stringByAppendingPathComponent:[NSString stringWithFormat:@".%@", [[NSProcessInfo processInfo] globallyUniqueString]]];
+  if (copyfile([path fileSystemRepresentation], [temporaryPath fileSystemRepresentation], NULL, COPYFILE_ALL | COPYFILE_EXCL) != 0) {
+    if (error) {
+      *error = DZWebServerMakePosixError(errno);
+    }
+    unlink([temporaryPath fileSystemRepresentation]);
+    return NO;
+  }
+  if (rename([temporaryPath fileSystemRepresentation], [destinationPath fileSystemRepresentation]) != 0) {
+    if (error) {
+      *error = DZWebServerMakePosixError(errno);
+    }
+    unlink([temporaryPath fileSystemRepresentation]);
+    return NO;
+  }
+  unlink([path fileSystemRepresentation]);
+  return YES;
+}
@@ -58,7 +58,9 @@ typedef NS_ENUM(NSInteger, DZWebServerInformationalHTTPStatusCode) {
   /** 101 -- The server is switching to the protocol requested by the client via the @c Upgrade header. */
   kDZWebServerHTTPStatusCode_SwitchingProtocols = 101,
   /** 102 -- The server has accepted the full request but has not yet completed it (WebDAV; RFC 2518). */
-  kDZWebServerHTTPStatusCode_Processing = 102
+  kDZWebServerHTTPStatusCode_Processing = 102,
+  /** 103 -- Headers the final response is likely to include, such as @c Link preload hints (RFC 8297). */
+  kDZWebServerHTTPStatusCode_EarlyHints = 103
 };
 
 /**
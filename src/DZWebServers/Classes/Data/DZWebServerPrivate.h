@@ -27,6 +27,7 @@
 
 #import <os/object.h>
 #import <sys/socket.h>
+#import <zlib.h>
 
 /**
  *  All DZWebServer headers.
@@ -40,7 +41,9 @@
 
 #import "DZWebServerDataRequest.h"
 #import "DZWebServerFileRequest.h"
+#import "DZWebServerHybridRequest.h"
 #import "DZWebServerMultiPartFormRequest.h"
+#import "DZWebServerStreamedRequest.h"
 #import "DZWebServerURLEncodedFormRequest.h"
 
 #import "DZWebServerDataResponse.h"
@@ -176,9 +179,91 @@ extern NSString* _Nullable DZWebServerTruncateHeaderValue(NSString* _Nullable va
 extern NSString* _Nullable DZWebServerExtractHeaderValueParameter(NSString* _Nullable value, NSString* attribute);
 extern NSStringEncoding DZWebServerStringEncodingFromCharset(NSString* charset);
 extern BOOL DZWebServerIsTextContentType(NSString* type);
+extern BOOL DZWebServerIsCompressibleContentType(NSString* _Nullable type);
 extern NSString* DZWebServerDescribeData(NSData* data, NSString* contentType);
 extern NSString* DZWebServerComputeMD5Digest(NSString* format, ...) NS_FORMAT_FUNCTION(1, 2);
+extern uint64_t DZWebServerComputeHash64(const void* bytes, size_t length);  // XXH64 with a zero seed
 extern NSString* DZWebServerStringFromSockAddr(const struct sockaddr* addr, BOOL includeService);
+extern NSString* DZWebServerFormatCurrentRFC822(void);  // Same as DZWebServerFormatRFC822([NSDate date]) but formatted at most once per second
+extern int DZWebServerCreateSpoolFile(NSString* path, NSUInteger length, NSUInteger maximumLength);  // Returns -1 if the file already exists, preallocates "length" bytes capped to "maximumLength" when both are known (0 or NSUIntegerMax if not)
+extern BOOL DZWebServerMoveSpoolFile(NSString* path, NSString* destinationPath, NSError** error);  // Atomically replaces the destination, with a metadata-only rename() when both are on the same volume
+
+#define kDZWebServerZlibBufferSize (256 * 1024)
+
+extern z_stream* _Nullable DZWebServerDequeueDeflateStream(int level, int windowBits, int* status);  // Returns a reset stream from the pool or a newly initialized one
+extern void DZWebServerEnqueueDeflateStream(z_stream* stream, int level, int windowBits);
+extern z_stream* _Nullable DZWebServerDequeueInflateStream(int windowBits, int* status);
+extern void DZWebServerEnqueueInflateStream(z_stream* stream, int windowBits);
+extern NSMutableData* DZWebServerDequeueZlibBuffer(void);  // Scratch buffers of kDZWebServerZlibBufferSize bytes that must not escape
+extern void DZWebServerEnqueueZlibBuffer(NSMutableData* buffer);
+
+typedef NS_ENUM(NSInteger, DZWebServerCompressionDecision) {
+  kDZWebServerCompressionDecision_Compressed = 0,
+  kDZWebServerCompressionDecision_CompressedAtReducedLevel,
+  kDZWebServerCompressionDecision_SkippedForSize,
+  kDZWebServerCompressionDecision_SkippedForContentType
+};
+
+@interface DZWebServerLRUCache : NSObject
+@property(nonatomic, readonly) NSUInteger countLimit;
+@property(nonatomic, readonly) NSUInteger totalCostLimit;
+@property(nonatomic) NSTimeInterval maximumAge;  // Objects not accessed for longer than this are evicted (0 means never)
+@property(nonatomic, readonly) NSUInteger count;
+@property(nonatomic, readonly) NSUInteger totalCost;
+- (instancetype)initWithCountLimit:(NSUInteger)countLimit totalCostLimit:(NSUInteger)totalCostLimit;
+- (nullable id)objectForKey:(id<NSCopying>)key;
+- (void)setObject:(id)object forKey:(id<NSCopying>)key cost:(NSUInteger)cost;
+- (void)removeObjectForKey:(id<NSCopying>)key;
+- (void)removeAllObjects;
+@end
+
+@interface DZWebServerCachedFile : NSObject
+@property(nonatomic, readonly) NSString* path;
+@property(nonatomic, readonly) const struct stat* info;
+@property(nonatomic, readonly) int fileDescriptor;  // -1 if not a regular file or if it could not be opened
+@property(nonatomic, readonly) int openError;
+@end
+
+@interface DZWebServerFileDescriptorCache : NSObject
++ (instancetype)sharedCache;
+- (nullable DZWebServerCachedFile*)fileForPath:(NSString*)path;
+- (void)removeFileForPath:(NSString*)path;
+- (void)removeAllFiles;
+@end
+
+@interface DZWebServerFileCacheEntry : NSObject
+@property(nonatomic, readonly) NSData* data;
+@property(nonatomic, readonly) NSString* contentType;
+@property(nonatomic, readonly) NSString* eTag;
+@property(nonatomic, readonly) NSDate* lastModifiedDate;
+@end
+
+@interface DZWebServerFileCache : NSObject
+@property(nonatomic, readonly) NSUInteger maximumSize;
+@property(nonatomic, readonly) NSUInteger maximumFileSize;
+- (instancetype)initWithMaximumSize:(NSUInteger)maximumSize maximumFileSize:(NSUInteger)maximumFileSize;
+- (nullable DZWebServerFileCacheEntry*)entryForFile:(DZWebServerCachedFile*)file;
+- (void)removeAllEntries;
+@end
+
+@interface DZWebServerEncodedContentCache : NSObject
+@property(nonatomic, readonly) NSUInteger maximumSize;
+- (instancetype)initWithMaximumSize:(NSUInteger)maximumSize;
+- (nullable NSData*)dataForKey:(NSString*)key producer:(NSData* _Nullable (^)(void))producer;  // Concurrent callers for the same key wait for a single producer
+- (void)removeAllEntries;
+@end
+
+@interface DZWebServerNegativeLookupCache : NSObject
+- (instancetype)initWithCountLimit:(NSUInteger)countLimit;
+- (BOOL)containsKey:(NSString*)key;
+- (void)addKey:(NSString*)key forMissingPath:(NSString*)path rootDirectory:(NSString*)rootDirectory;
+@end
+
+@interface DZWebServerSpoolWriter : NSObject
+- (nullable instancetype)initWithFileDescriptor:(int)fileDescriptor;  // Takes ownership of the descriptor unless it returns nil
+- (BOOL)writeData:(NSData*)data error:(NSError**)error;  // Queues the write and blocks while too many are pending, fails once a previous write has failed
+- (BOOL)close:(NSError**)error;  // Waits for pending writes and closes the descriptor
+@end
 
 @interface DZWebServerConnection ()
 - (instancetype)initWithServer:(DZWebServer*)server localAddress:(NSData*)localAddress remoteAddress:(NSData*)remoteAddress socket:(CFSocketNativeHandle)socket;
@@ -192,35 +277,94 @@ extern NSString* DZWebServerStringFromSockAddr(const struct sockaddr* addr, BOOL
 @property(nonatomic, readonly, nullable) NSString* authenticationRealm;
 @property(nonatomic, readonly, nullable) NSMutableDictionary<NSString*, NSString*>* authenticationBasicAccounts;
 @property(nonatomic, readonly, nullable) NSMutableDictionary<NSString*, NSString*>* authenticationDigestAccounts;
+@property(nonatomic, readonly, nullable) NSString* authenticationDigestNonce;
+@property(nonatomic, readonly, nullable) NSString* authenticationChallenge;  // Serialized "WWW-Authenticate" header value
+@property(nonatomic, readonly, nullable) NSString* staleAuthenticationChallenge;  // Same with "stale=TRUE" for Digest Access authentication
 @property(nonatomic, readonly) BOOL shouldAutomaticallyMapHEADToGET;
 @property(nonatomic, readonly) dispatch_queue_priority_t dispatchQueuePriority;
+@property(nonatomic, readonly, nullable) DZWebServerFileCache* fileCache;
+@property(nonatomic, readonly) BOOL servesPrecompressedFiles;
+@property(nonatomic, readonly, nullable) NSDictionary<NSString*, id>* options;
+@property(nonatomic, readonly, nullable) NSArray<NSString*>* contentEncodings;
+@property(nonatomic, readonly) NSUInteger compressionMinimumSize;
+@property(nonatomic, readonly, nullable) NSArray<NSString*>* compressibleContentTypes;
+@property(nonatomic, readonly, nullable) NSDictionary<NSString*, id>* reducedContentEncodingOptions;
+@property(nonatomic, readonly, nullable) DZWebServerEncodedContentCache* encodedContentCache;
+@property(nonatomic, readonly) NSUInteger encodedContentCacheMaximumEntrySize;
+@property(nonatomic, readonly) NSUInteger maximumDecodedBodySize;
+@property(nonatomic, readonly) NSUInteger maximumRequestBodySize;
+@property(nonatomic, readonly) NSUInteger maximumBufferedRequestBodySize;
+@property(nonatomic, readonly) BOOL shouldAutomaticallyComputeETags;
+@property(nonatomic, readonly) BOOL shouldAutomaticallySendServerTiming;
+- (BOOL)shouldReduceCompressionLevel;
+- (void)recordCompressionDecision:(DZWebServerCompressionDecision)decision;
+- (BOOL)reserveBufferedRequestBodySize:(NSUInteger)size;  // Returns NO if the budget would be exceeded
+- (void)releaseBufferedRequestBodySize:(NSUInteger)size;
 - (void)willStartConnection:(DZWebServerConnection*)connection;
 - (void)didEndConnection:(DZWebServerConnection*)connection;
 @end
 
 @interface DZWebServerHandler : NSObject
 @property(nonatomic, readonly) DZWebServerMatchBlock matchBlock;
+@property(nonatomic, readonly, nullable) DZWebServerBodyAcceptanceBlock bodyAcceptanceBlock;
+@property(nonatomic, readonly, nullable) DZWebServerValidatorBlock validatorBlock;
 @property(nonatomic, readonly) DZWebServerAsyncProcessBlock asyncProcessBlock;
 @end
 
+typedef BOOL (^DZWebServerInformationalResponseBlock)(NSInteger statusCode, NSDictionary<NSString*, NSString*>* _Nullable headers);
+typedef void (^DZWebServerBodyPullCompletionBlock)(BOOL finished, NSError* _Nullable error);
+typedef void (^DZWebServerBodyPullBlock)(DZWebServerBodyPullCompletionBlock completionBlock);
+
 @interface DZWebServerRequest ()
 @property(nonatomic, readonly) BOOL usesChunkedTransferEncoding;
+@property(atomic, copy, nullable) DZWebServerInformationalResponseBlock informationalResponseBlock;  // Only set while the request is being processed
+@property(atomic, copy, nullable) DZWebServerBodyPullBlock bodyPullBlock;  // Only set for streamed requests until their body or the response ends
+@property(nonatomic, getter=isHeadRequest) BOOL headRequest;
 @property(nonatomic, copy, nullable) NSData* localAddressData;
 @property(nonatomic, copy, nullable) NSData* remoteAddressData;
-- (void)prepareForWriting;
+@property(nonatomic) NSUInteger bodySizeLimit;  // Effective limit enforced by the connection (0 means no limit)
+@property(nonatomic, nullable) DZWebServer* bufferingServer;  // Only set when the server limits request body bytes held in memory
+- (BOOL)prepareForWritingWithMaximumDecodedBodySize:(NSUInteger)maximumSize;  // Returns NO if a registered decoder could not be created (0 means no limit)
 - (BOOL)performOpen:(NSError**)error;
 - (BOOL)performWriteData:(NSData*)data error:(NSError**)error;
 - (BOOL)performClose:(NSError**)error;
 - (void)setAttribute:(nullable id)attribute forKey:(NSString*)key;
+- (BOOL)reserveBufferedBodySize:(NSUInteger)size error:(NSError**)error;  // Called by subclasses before keeping decoded body bytes in memory
+- (void)releaseBufferedBodySize;  // Releases everything reserved so far
 @end
 
 @interface DZWebServerResponse ()
 @property(nonatomic, readonly) NSDictionary<NSString*, NSString*>* additionalHeaders;
+@property(nonatomic, getter=isMetadataOnly) BOOL metadataOnly;
+@property(nonatomic, readonly) NSArray<NSString*>* declaredTrailers;
+@property(nonatomic, readonly) NSDictionary<NSString*, NSString*>* trailerValues;
 @property(nonatomic, readonly) BOOL usesChunkedTransferEncoding;
-- (void)prepareForReading;
+- (void)prepareForReadingWithContentEncodingOptions:(nullable NSDictionary<NSString*, id>*)options;
+- (void)prepareForReadingWithEncodedBody:(NSData*)body contentEncoding:(NSString*)encoding;
+- (nullable NSData*)encodedBodyWithContentEncoding:(NSString*)encoding options:(nullable NSDictionary<NSString*, id>*)options;
 - (BOOL)performOpen:(NSError**)error;
 - (void)performReadDataWithCompletion:(DZWebServerBodyReaderCompletionBlock)block;
 - (void)performClose;
 @end
 
+@interface DZWebServerFileResponse ()
+@property(nonatomic, readonly) NSString* path;
++ (nullable DZWebServerCachedFile*)precompressedFileForFile:(DZWebServerCachedFile*)file request:(DZWebServerRequest*)request contentEncoding:(NSString* _Nullable* _Nonnull)encoding;
+- (nullable instancetype)initWithCachedFile:(DZWebServerCachedFile*)file precompressedFile:(nullable DZWebServerCachedFile*)encodedFile contentEncoding:(nullable NSString*)encoding byteRanges:(nullable NSArray<NSValue*>*)ranges isAttachment:(BOOL)attachment mimeTypeOverrides:(nullable NSDictionary<NSString*, NSString*>*)overrides NS_DESIGNATED_INITIALIZER;
++ (nullable DZWebServerResponse*)validatorResponseForFile:(NSString*)path;  // Same validators as a response for the file, without the MIME type lookup
+- (void)discardByteRanges;  // Turns a 206 or 416 response back into a 200 for the full file
+@end
+
+@interface DZWebServerDataResponse ()
+- (void)computeETag;  // Strong ETag from a hash of the body
+@end
+
+@interface DZWebServerPrebuiltResponse : DZWebServerDataResponse
+@property(nonatomic, readonly) NSData* body;
+@property(nonatomic, readonly) NSData* headerData;  // Status line and headers serialized at creation time, without "Server" and "Date" nor the final CRLF
+@property(nonatomic, readonly, getter=isPristine) BOOL pristine;  // NO once anything reflected in the headers has changed since creation
+- (instancetype)initWithData:(NSData*)data contentType:(NSString*)type cacheAge:(NSUInteger)cacheAge;
+- (instancetype)initWithPrebuiltResponse:(DZWebServerPrebuiltResponse*)response;  // Cheap per-request copy sharing the body and serialized headers
+@end
+
 NS_ASSUME_NONNULL_END
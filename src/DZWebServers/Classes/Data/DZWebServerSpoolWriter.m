@@ -0,0 +1,119 @@
+/*
+ Copyright (c) 2012-2019, Pierre-Olivier Latour
+ Copyright (c) 2024, Dominic Rodemer
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * The name of Pierre-Olivier Latour may not be used to endorse
+ or promote products derived from this software without specific
+ prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL PIERRE-OLIVIER LATOUR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !__has_feature(objc_arc)
+#error DZWebServer requires ARC
+#endif
+
+#import <stdatomic.h>
+
+#import "DZWebServerPrivate.h"
+
+#define kMaximumPendingWrites 4
+
+@implementation DZWebServerSpoolWriter {
+  dispatch_io_t _channel;
+  dispatch_semaphore_t _pendingWrites;
+  dispatch_group_t _group;
+  atomic_int _error;
+}
+
+- (instancetype)initWithFileDescriptor:(int)fileDescriptor {
+  if ((self = [super init])) {
+    dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_UTILITY, 0);
+    _pendingWrites = dispatch_semaphore_create(kMaximumPendingWrites);
+    _group = dispatch_group_create();
+    dispatch_group_t group = _group;
+    dispatch_group_enter(group);
+    _channel = dispatch_io_create(DISPATCH_IO_STREAM, fileDescriptor, queue, ^(int error) {
+      close(fileDescriptor);  // Only safe once the channel is done with the descriptor
+      dispatch_group_leave(group);
+    });
+    if (_channel == nil) {
+      DWS_LOG_ERROR(@"Failed creating I/O channel for file descriptor %i", fileDescriptor);
+      dispatch_group_leave(group);
+      return nil;
+    }
+  }
+  return self;
+}
+
+- (void)dealloc {
+  if (_channel) {
+    dispatch_io_close(_channel, DISPATCH_IO_STOP);
+  }
+}
+
+- (BOOL)writeData:(NSData*)data error:(NSError**)error {
+  int writeError = atomic_load_explicit(&_error, memory_order_relaxed);
+  if (writeError || !_channel) {
+    if (error) {
+      *error = DZWebServerMakePosixError(writeError ? writeError : EBADF);
+    }
+    return NO;
+  }
+  if (data.length == 0) {
+    return YES;
+  }
+
+  dispatch_semaphore_wait(_pendingWrites, DISPATCH_TIME_FOREVER);  // Stops the connection from reading more from the socket until the disk catches up
+  NSData* immutableData = [data copy];  // Callers may reuse mutable buffers once this returns
+  dispatch_data_t buffer = dispatch_data_create(immutableData.bytes, immutableData.length, NULL, ^{
+    [immutableData self];  // Keeps ARC from releasing data too early
+  });
+  dispatch_group_enter(_group);
+  dispatch_io_write(_channel, 0, buffer, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^(bool done, dispatch_data_t remainingData, int writeErrorInner) {
+    if (writeErrorInner) {
+      int expected = 0;
+      atomic_compare_exchange_strong_explicit(&self->_error, &expected, writeErrorInner, memory_order_relaxed, memory_order_relaxed);
+    }
+    if (done) {
+      dispatch_semaphore_signal(self->_pendingWrites);
+      dispatch_group_leave(self->_group);
+    }
+  });
+  return YES;
+}
+
+- (BOOL)close:(NSError**)error {
+  if (_channel) {
+    dispatch_io_close(_channel, 0);
+    _channel = nil;
+    dispatch_group_wait(_group, DISPATCH_TIME_FOREVER);  // Waits for pending writes and for the descriptor to be closed
+  }
+  int writeError = atomic_load_explicit(&_error, memory_order_relaxed);
+  if (writeError) {
+    if (error) {
+      *error = DZWebServerMakePosixError(writeError);
+    }
+    return NO;
+  }
+  return YES;
+}
+
+@end
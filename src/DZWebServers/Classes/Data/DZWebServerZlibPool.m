@@ -0,0 +1,152 @@
+/*
+ Copyright (c) 2012-2019, Pierre-Olivier Latour
+ Copyright (c) 2024, Dominic Rodemer
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * The name of Pierre-Olivier Latour may not be used to endorse
+ or promote products derived from this software without specific
+ prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL PIERRE-OLIVIER LATOUR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !__has_feature(objc_arc)
+#error DZWebServer requires ARC
+#endif
+
+#import "DZWebServerPrivate.h"
+
+#define kZlibMaxPooledStreamsPerConfiguration 16
+#define kZlibMaxPooledBuffers 16
+
+static dispatch_queue_t _poolQueue = NULL;
+static NSMutableDictionary<NSNumber*, NSMutableArray<NSValue*>*>* _deflateStreams = nil;  // Accessed through _poolQueue only
+static NSMutableDictionary<NSNumber*, NSMutableArray<NSValue*>*>* _inflateStreams = nil;  // Accessed through _poolQueue only
+static NSMutableArray<NSMutableData*>* _buffers = nil;  // Accessed through _poolQueue only
+
+static void _InitializePools(void) {
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    _poolQueue = dispatch_queue_create("DZWebServerZlibPool", DISPATCH_QUEUE_SERIAL);
+    _deflateStreams = [[NSMutableDictionary alloc] init];
+    _inflateStreams = [[NSMutableDictionary alloc] init];
+    _buffers = [[NSMutableArray alloc] init];
+  });
+}
+
+static z_stream* _DequeueStream(NSMutableDictionary<NSNumber*, NSMutableArray<NSValue*>*>* pool, NSNumber* key) {
+  __block z_stream* stream = NULL;
+  dispatch_sync(_poolQueue, ^{
+    NSMutableArray<NSValue*>* streams = [pool objectForKey:key];
+    if (streams.count) {
+      stream = streams.lastObject.pointerValue;
+      [streams removeLastObject];
+    }
+  });
+  return stream;
+}
+
+// Returns NO if the pool for this configuration is full
+static BOOL _EnqueueStream(NSMutableDictionary<NSNumber*, NSMutableArray<NSValue*>*>* pool, NSNumber* key, z_stream* stream) {
+  __block BOOL success = NO;
+  dispatch_sync(_poolQueue, ^{
+    NSMutableArray<NSValue*>* streams = [pool objectForKey:key];
+    if (streams == nil) {
+      streams = [[NSMutableArray alloc] init];
+      [pool setObject:streams forKey:key];
+    }
+    if (streams.count < kZlibMaxPooledStreamsPerConfiguration) {
+      [streams addObject:[NSValue valueWithPointer:stream]];
+      success = YES;
+    }
+  });
+  return success;
+}
+
+// The stream parameters cannot be changed by deflateReset() so streams are pooled per level and window
+static inline NSNumber* _DeflateKey(int level, int windowBits) {
+  return @(level * 256 + windowBits);
+}
+
+z_stream* DZWebServerDequeueDeflateStream(int level, int windowBits, int* status) {
+  _InitializePools();
+  z_stream* stream = _DequeueStream(_deflateStreams, _DeflateKey(level, windowBits));
+  if (stream) {
+    *status = Z_OK;
+    return stream;
+  }
+  stream = calloc(1, sizeof(z_stream));  // zlib keeps a back pointer to the stream so it must not move
+  *status = deflateInit2(stream, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY);
+  if (*status != Z_OK) {
+    free(stream);
+    return NULL;
+  }
+  return stream;
+}
+
+void DZWebServerEnqueueDeflateStream(z_stream* stream, int level, int windowBits) {
+  if ((deflateReset(stream) != Z_OK) || !_EnqueueStream(_deflateStreams, _DeflateKey(level, windowBits), stream)) {
+    deflateEnd(stream);
+    free(stream);
+  }
+}
+
+z_stream* DZWebServerDequeueInflateStream(int windowBits, int* status) {
+  _InitializePools();
+  z_stream* stream = _DequeueStream(_inflateStreams, @(windowBits));
+  if (stream) {
+    *status = Z_OK;
+    return stream;
+  }
+  stream = calloc(1, sizeof(z_stream));
+  *status = inflateInit2(stream, windowBits);
+  if (*status != Z_OK) {
+    free(stream);
+    return NULL;
+  }
+  return stream;
+}
+
+void DZWebServerEnqueueInflateStream(z_stream* stream, int windowBits) {
+  if ((inflateReset(stream) != Z_OK) || !_EnqueueStream(_inflateStreams, @(windowBits), stream)) {
+    inflateEnd(stream);
+    free(stream);
+  }
+}
+
+NSMutableData* DZWebServerDequeueZlibBuffer(void) {
+  _InitializePools();
+  __block NSMutableData* buffer = nil;
+  dispatch_sync(_poolQueue, ^{
+    buffer = _buffers.lastObject;
+    if (buffer) {
+      [_buffers removeLastObject];
+    }
+  });
+  return buffer ? buffer : [[NSMutableData alloc] initWithLength:kDZWebServerZlibBufferSize];
+}
+
+void DZWebServerEnqueueZlibBuffer(NSMutableData* buffer) {
+  DWS_DCHECK(buffer.length == kDZWebServerZlibBufferSize);
+  dispatch_sync(_poolQueue, ^{
+    if (_buffers.count < kZlibMaxPooledBuffers) {
+      [_buffers addObject:buffer];
+    }
+  });
+}
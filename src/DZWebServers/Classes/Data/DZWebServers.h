@@ -52,7 +52,8 @@
  *  Requests and responses are modeled as a class hierarchy:
  *
  *  - **Requests:** @c DZWebServerRequest (base), @c DZWebServerDataRequest,
- *    @c DZWebServerFileRequest, @c DZWebServerMultiPartFormRequest,
+ *    @c DZWebServerFileRequest, @c DZWebServerHybridRequest,
+ *    @c DZWebServerMultiPartFormRequest, @c DZWebServerStreamedRequest,
  *    @c DZWebServerURLEncodedFormRequest.
  *
  *  - **Responses:** @c DZWebServerResponse (base), @c DZWebServerDataResponse,
@@ -89,7 +90,9 @@ NS_ASSUME_NONNULL_END
 // DZWebServer Requests
 #import "DZWebServerDataRequest.h"
 #import "DZWebServerFileRequest.h"
+#import "DZWebServerHybridRequest.h"
 #import "DZWebServerMultiPartFormRequest.h"
+#import "DZWebServerStreamedRequest.h"
 #import "DZWebServerURLEncodedFormRequest.h"
 
 // DZWebServer Responses
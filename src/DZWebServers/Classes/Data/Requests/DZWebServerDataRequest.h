@@ -34,9 +34,8 @@ NS_ASSUME_NONNULL_BEGIN
  *
  *  @discussion DZWebServerDataRequest accumulates all received body data into an
  *  in-memory @c NSData buffer. When the @c Content-Length header is present, the
- *  internal buffer is pre-allocated with that capacity for efficiency. When
- *  @c Content-Length is absent (e.g. chunked transfer encoding), the buffer grows
- *  dynamically as data arrives.
+ *  internal buffer is pre-allocated with that capacity, up to 256 KB, and grows
+ *  dynamically as data arrives beyond it.
  *
  *  Use this class for requests with reasonably sized bodies. For large uploads
  *  where memory pressure is a concern, consider using @c DZWebServerFileRequest
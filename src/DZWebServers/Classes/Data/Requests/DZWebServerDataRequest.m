@@ -31,6 +31,8 @@
 
 #import "DZWebServerPrivate.h"
 
+#define kMaximumInitialCapacity (256 * 1024)
+
 @interface DZWebServerDataRequest ()
 @property(nonatomic) NSMutableData* data;
 @end
@@ -42,7 +44,7 @@
 
 - (BOOL)open:(NSError**)error {
   if (self.contentLength != NSUIntegerMax) {
-    _data = [[NSMutableData alloc] initWithCapacity:self.contentLength];
+    _data = [[NSMutableData alloc] initWithCapacity:MIN(self.contentLength, kMaximumInitialCapacity)];  // Don't trust the client to reserve memory, the buffer grows as data arrives
   } else {
     _data = [[NSMutableData alloc] init];
   }
@@ -56,6 +58,9 @@
 }
 
 - (BOOL)writeData:(NSData*)data error:(NSError**)error {
+  if (![self reserveBufferedBodySize:data.length error:error]) {
+    return NO;
+  }
   [_data appendData:data];
   return YES;
 }
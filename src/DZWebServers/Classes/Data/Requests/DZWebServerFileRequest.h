@@ -54,12 +54,29 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @interface DZWebServerFileRequest : DZWebServerRequest
 
+/**
+ *  @brief The directory in which the temporary file is created, or @c nil for the
+ *  system's temporary directory.
+ *
+ *  @discussion Set it from a handler match block to spool uploads on the volume
+ *  where they will be stored, so @c -moveTemporaryFileToPath:error: finishes
+ *  with a metadata-only rename instead of copying the file. The directory must
+ *  exist and be writable. Changing it after the connection has started
+ *  receiving the body has no effect.
+ *
+ *  The default value is @c nil.
+ */
+@property(nonatomic, copy, nullable) NSString* spoolDirectoryPath;
+
 /**
  *  @brief The file-system path to the temporary file containing the received request body.
  *
- *  @discussion The path points to a uniquely named file inside the system's temporary
- *  directory (@c NSTemporaryDirectory()). The file is created when the connection
- *  begins receiving body data and is populated incrementally as data arrives.
+ *  @discussion The path points to a uniquely named file inside @c spoolDirectoryPath,
+ *  or the system's temporary directory (@c NSTemporaryDirectory()) if it is @c nil.
+ *  The file is created when the connection begins receiving body data and is
+ *  populated incrementally as data arrives. When a maximum body size is enforced
+ *  and the @c Content-Length is known, storage for the body is preallocated, up
+ *  to that maximum.
  *
  *  After the request handler has finished processing, this path remains valid
  *  until the DZWebServerFileRequest instance is deallocated.
@@ -70,6 +87,21 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nonatomic, copy, readonly) NSString* temporaryPath;
 
+/**
+ *  @brief Moves the temporary file to its final location.
+ *
+ *  @discussion The file atomically replaces any file at @a path. When both are on
+ *  the same volume this is a metadata-only @c rename(), otherwise the file is
+ *  first copied next to @a path and then renamed over it, so @a path never holds
+ *  a partially written file. Once moved, the file is no longer deleted when this
+ *  request object is deallocated.
+ *
+ *  @param path  The destination path.
+ *  @param error On failure, set to an @c NSError describing what went wrong.
+ *  @return @c YES on success, @c NO on failure.
+ */
+- (BOOL)moveTemporaryFileToPath:(NSString*)path error:(NSError**)error;
+
 @end
 
 NS_ASSUME_NONNULL_END
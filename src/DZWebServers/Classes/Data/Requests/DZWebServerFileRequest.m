@@ -32,7 +32,9 @@
 #import "DZWebServerPrivate.h"
 
 @implementation DZWebServerFileRequest {
-  int _file;
+  DZWebServerSpoolWriter* _writer;
+  int _file;  // Only used if the writer could not be created
+  BOOL _moved;
 }
 
 - (instancetype)initWithMethod:(NSString*)method url:(NSURL*)url headers:(NSDictionary<NSString*, NSString*>*)headers path:(NSString*)path query:(NSDictionary<NSString*, NSString*>*)query {
@@ -43,21 +45,34 @@
 }
 
 - (void)dealloc {
-  unlink([_temporaryPath fileSystemRepresentation]);
+  if (!_moved) {
+    unlink([_temporaryPath fileSystemRepresentation]);
+  }
 }
 
 - (BOOL)open:(NSError**)error {
-  _file = open([_temporaryPath fileSystemRepresentation], O_CREAT | O_TRUNC | O_WRONLY, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
-  if (_file <= 0) {
+  if (_spoolDirectoryPath) {
+    _temporaryPath = [_spoolDirectoryPath stringByAppendingPathComponent:[_temporaryPath lastPathComponent]];
+  }
+  int file = DZWebServerCreateSpoolFile(_temporaryPath, self.contentLength, self.bodySizeLimit);
+  if (file <= 0) {
     if (error) {
       *error = DZWebServerMakePosixError(errno);
     }
     return NO;
   }
+  _writer = [[DZWebServerSpoolWriter alloc] initWithFileDescriptor:file];
+  if (_writer == nil) {
+    DWS_LOG_WARNING(@"Falling back to synchronous writes for \"%@\"", _temporaryPath);
+    _file = file;
+  }
   return YES;
 }
 
 - (BOOL)writeData:(NSData*)data error:(NSError**)error {
+  if (_writer) {
+    return [_writer writeData:data error:error];
+  }
   if (write(_file, data.bytes, data.length) != (ssize_t)data.length) {
     if (error) {
       *error = DZWebServerMakePosixError(errno);
@@ -68,7 +83,13 @@
 }
 
 - (BOOL)close:(NSError**)error {
-  if (close(_file) < 0) {
+  if (_writer) {
+    BOOL success = [_writer close:error];
+    _writer = nil;
+    if (!success) {
+      return NO;
+    }
+  } else if ((_file > 0) && (close(_file) < 0)) {
     if (error) {
       *error = DZWebServerMakePosixError(errno);
     }
@@ -93,6 +114,17 @@
   return YES;
 }
 
+- (BOOL)moveTemporaryFileToPath:(NSString*)path error:(NSError**)error {
+  if (_moved) {
+    if (error) {
+      *error = DZWebServerMakePosixError(ENOENT);
+    }
+    return NO;
+  }
+  _moved = DZWebServerMoveSpoolFile(_temporaryPath, path, error);
+  return _moved;
+}
+
 - (NSString*)description {
   NSMutableString* description = [NSMutableString stringWithString:[super description]];
   [description appendFormat:@"\n\n{%@}", _temporaryPath];
@@ -0,0 +1,100 @@
+/*
+ Copyright (c) 2012-2019, Pierre-Olivier Latour
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * The name of Pierre-Olivier Latour may not be used to endorse
+ or promote products derived from this software without specific
+ prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL PIERRE-OLIVIER LATOUR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "DZWebServerRequest.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ *  @brief A request subclass that keeps small HTTP bodies in memory and spills
+ *  larger ones to a temporary file on disk.
+ *
+ *  @discussion DZWebServerHybridRequest sits between DZWebServerDataRequest and
+ *  DZWebServerFileRequest. Bodies up to @c memoryThreshold bytes are accumulated
+ *  in an in-memory buffer, so small JSON or form posts never touch the disk.
+ *  When the declared @c Content-Length or the received data exceeds the threshold,
+ *  the buffered bytes are written to a temporary file in the system's temporary
+ *  directory and the rest of the body is appended to it.
+ *
+ *  Either way the body is exposed uniformly through @c data, which maps the
+ *  temporary file into memory when the body was spilled, or through
+ *  @c -inputStream.
+ *
+ *  The temporary file, if any, is automatically deleted when this request object
+ *  is deallocated.
+ *
+ *  @see DZWebServerDataRequest
+ *  @see DZWebServerFileRequest
+ */
+@interface DZWebServerHybridRequest : DZWebServerRequest
+
+/**
+ *  @brief The largest body in bytes kept in memory before spilling to disk.
+ *
+ *  @discussion Set it from a handler match block to tune the threshold per route.
+ *  Changing it after the connection has started receiving the body has no effect.
+ *
+ *  The default value is 256 KB.
+ */
+@property(nonatomic) NSUInteger memoryThreshold;
+
+/**
+ *  @brief The received request body.
+ *
+ *  @discussion Returns the in-memory buffer for small bodies, or the temporary file
+ *  mapped into memory for spilled ones, so large bodies are paged in on demand
+ *  rather than copied. The data is available after the connection has finished
+ *  receiving the request body.
+ *
+ *  If the request has no body, or the temporary file cannot be mapped, this
+ *  returns an empty @c NSData instance.
+ */
+@property(nonatomic, readonly) NSData* data;
+
+/**
+ *  @brief The path to the temporary file holding the body, or @c nil if the body
+ *  was kept in memory.
+ *
+ *  @warning The temporary file is automatically deleted when this request object
+ *  is deallocated. If you need to keep the file, you @b must move or copy it to
+ *  a different location before the request is released.
+ */
+@property(nonatomic, copy, readonly, nullable) NSString* temporaryPath;
+
+/**
+ *  @brief Creates a new unopened stream reading the received request body.
+ *
+ *  @discussion Reads from the in-memory buffer or from the temporary file,
+ *  depending on where the body was stored.
+ *
+ *  @return A new @c NSInputStream instance.
+ */
+- (NSInputStream*)inputStream;
+
+@end
+
+NS_ASSUME_NONNULL_END
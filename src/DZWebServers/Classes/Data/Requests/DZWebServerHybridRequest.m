@@ -0,0 +1,163 @@
+/*
+ Copyright (c) 2012-2019, Pierre-Olivier Latour
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * The name of Pierre-Olivier Latour may not be used to endorse
+ or promote products derived from this software without specific
+ prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL PIERRE-OLIVIER LATOUR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !__has_feature(objc_arc)
+#error DZWebServer requires ARC
+#endif
+
+#import "DZWebServerPrivate.h"
+
+#define kDefaultMemoryThreshold (256 * 1024)
+
+@implementation DZWebServerHybridRequest {
+  NSMutableData* _buffer;
+  DZWebServerSpoolWriter* _writer;
+  int _file;  // Only used if the writer could not be created
+  NSData* _mappedData;
+}
+
+- (instancetype)initWithMethod:(NSString*)method url:(NSURL*)url headers:(NSDictionary<NSString*, NSString*>*)headers path:(NSString*)path query:(NSDictionary<NSString*, NSString*>*)query {
+  if ((self = [super initWithMethod:method url:url headers:headers path:path query:query])) {
+    _memoryThreshold = kDefaultMemoryThreshold;
+  }
+  return self;
+}
+
+- (void)dealloc {
+  if (_temporaryPath) {
+    unlink([_temporaryPath fileSystemRepresentation]);
+  }
+}
+
+- (BOOL)_writeDataToFile:(NSData*)data error:(NSError**)error {
+  if (_writer) {
+    return [_writer writeData:data error:error];
+  }
+  if (write(_file, data.bytes, data.length) != (ssize_t)data.length) {
+    if (error) {
+      *error = DZWebServerMakePosixError(errno);
+    }
+    return NO;
+  }
+  return YES;
+}
+
+- (BOOL)_spillToFile:(NSError**)error {
+  NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+  int file = DZWebServerCreateSpoolFile(path, self.contentLength, self.bodySizeLimit);
+  if (file < 0) {
+    if (error) {
+      *error = DZWebServerMakePosixError(errno);
+    }
+    return NO;
+  }
+  _temporaryPath = [path copy];
+  _writer = [[DZWebServerSpoolWriter alloc] initWithFileDescriptor:file];
+  if (_writer == nil) {
+    DWS_LOG_WARNING(@"Falling back to synchronous writes for \"%@\"", _temporaryPath);
+    _file = file;
+  }
+  if (_buffer.length && ![self _writeDataToFile:_buffer error:error]) {
+    return NO;
+  }
+  _buffer = nil;
+  [self releaseBufferedBodySize];
+  return YES;
+}
+
+- (BOOL)open:(NSError**)error {
+  if ((self.contentLength != NSUIntegerMax) && (self.contentLength > _memoryThreshold)) {
+    return [self _spillToFile:error];
+  }
+  _buffer = [[NSMutableData alloc] initWithCapacity:(self.contentLength != NSUIntegerMax ? self.contentLength : 0)];
+  return YES;
+}
+
+- (BOOL)writeData:(NSData*)data error:(NSError**)error {
+  if (_buffer) {
+    if (_buffer.length + data.length <= _memoryThreshold) {
+      if (![self reserveBufferedBodySize:data.length error:error]) {
+        return NO;
+      }
+      [_buffer appendData:data];
+      return YES;
+    }
+    if (![self _spillToFile:error]) {  // Decoded bodies or chunked ones can outgrow the declared length
+      return NO;
+    }
+  }
+  return [self _writeDataToFile:data error:error];
+}
+
+- (BOOL)close:(NSError**)error {
+  if (_writer) {
+    BOOL success = [_writer close:error];
+    _writer = nil;
+    return success;
+  }
+  if ((_file > 0) && (close(_file) < 0)) {
+    if (error) {
+      *error = DZWebServerMakePosixError(errno);
+    }
+    return NO;
+  }
+  return YES;
+}
+
+- (NSData*)data {
+  if (_buffer) {
+    return _buffer;
+  }
+  if (_temporaryPath && !_mappedData) {
+    NSError* error = nil;
+    _mappedData = [NSData dataWithContentsOfFile:_temporaryPath options:NSDataReadingMappedAlways error:&error];
+    if (_mappedData == nil) {
+      DWS_LOG_ERROR(@"Failed mapping request body from \"%@\": %@", _temporaryPath, error);
+    }
+  }
+  return _mappedData ? _mappedData : [NSData data];
+}
+
+- (NSInputStream*)inputStream {
+  if (_temporaryPath) {
+    return [NSInputStream inputStreamWithFileAtPath:_temporaryPath];
+  }
+  return [NSInputStream inputStreamWithData:(_buffer ? [_buffer copy] : [NSData data])];
+}
+
+- (NSString*)description {
+  NSMutableString* description = [NSMutableString stringWithString:[super description]];
+  if (_temporaryPath) {
+    [description appendFormat:@"\n\n{%@}", _temporaryPath];
+  } else if (_buffer.length) {
+    [description appendString:@"\n\n"];
+    [description appendString:DZWebServerDescribeData(_buffer, (NSString*)self.contentType)];
+  }
+  return description;
+}
+
+@end
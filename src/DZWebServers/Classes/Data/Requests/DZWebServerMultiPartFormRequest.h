@@ -147,8 +147,9 @@ NS_ASSUME_NONNULL_BEGIN
 /**
  *  @brief The absolute path to the temporary file containing the uploaded data.
  *
- *  @discussion The temporary file is created in @c NSTemporaryDirectory() with a
- *  globally unique name. The file contains the raw bytes of the uploaded part body.
+ *  @discussion The temporary file is created in the request's @c spoolDirectoryPath,
+ *  or @c NSTemporaryDirectory() if it is @c nil, with a globally unique name. The
+ *  file contains the raw bytes of the uploaded part body.
  *
  *  @warning This temporary file is automatically deleted when the
  *  @c DZWebServerMultiPartFile instance is deallocated. You must move or copy
@@ -157,6 +158,20 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nonatomic, copy, readonly) NSString* temporaryPath;
 
+/**
+ *  @brief Moves the temporary file to its final location.
+ *
+ *  @discussion Replaces any file at @a path atomically, renaming when possible
+ *  and copying across volumes, as described for
+ *  @c -[DZWebServerFileRequest moveTemporaryFileToPath:error:]. Once moved, the
+ *  file is no longer deleted when this object is deallocated.
+ *
+ *  @param path  The destination path.
+ *  @param error On failure, set to an @c NSError describing what went wrong.
+ *  @return @c YES on success, @c NO on failure.
+ */
+- (BOOL)moveTemporaryFileToPath:(NSString*)path error:(NSError**)error;
+
 @end
 
 /**
@@ -185,6 +200,21 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @interface DZWebServerMultiPartFormRequest : DZWebServerRequest
 
+/**
+ *  @brief The directory in which the temporary files of file parts are created,
+ *  or @c nil for the system's temporary directory.
+ *
+ *  @discussion Set it from a handler match block to spool uploads on the volume
+ *  where they will be stored, so
+ *  @c -[DZWebServerMultiPartFile moveTemporaryFileToPath:error:] finishes with a
+ *  metadata-only rename instead of copying the file. The directory must exist
+ *  and be writable. Changing it after the connection has started receiving the
+ *  body has no effect.
+ *
+ *  The default value is @c nil.
+ */
+@property(nonatomic, copy, nullable) NSString* spoolDirectoryPath;
+
 /**
  *  @brief All non-file parts parsed from the multipart form body.
  *
@@ -81,7 +81,9 @@ static NSData* _dashNewlineData = nil;
 
 @end
 
-@implementation DZWebServerMultiPartFile
+@implementation DZWebServerMultiPartFile {
+  BOOL _moved;
+}
 
 - (instancetype)initWithControlName:(NSString* _Nonnull)name contentType:(NSString* _Nonnull)type fileName:(NSString* _Nonnull)fileName temporaryPath:(NSString* _Nonnull)temporaryPath {
   if ((self = [super initWithControlName:name contentType:type])) {
@@ -92,7 +94,20 @@ static NSData* _dashNewlineData = nil;
 }
 
 - (void)dealloc {
-  unlink([_temporaryPath fileSystemRepresentation]);
+  if (!_moved) {
+    unlink([_temporaryPath fileSystemRepresentation]);
+  }
+}
+
+- (BOOL)moveTemporaryFileToPath:(NSString*)path error:(NSError**)error {
+  if (_moved) {
+    if (error) {
+      *error = DZWebServerMakePosixError(ENOENT);
+    }
+    return NO;
+  }
+  _moved = DZWebServerMoveSpoolFile(_temporaryPath, path, error);
+  return _moved;
 }
 
 - (NSString*)description {
@@ -104,6 +119,7 @@ static NSData* _dashNewlineData = nil;
 @implementation DZWebServerMIMEStreamParser {
   NSData* _boundary;
   NSString* _defaultcontrolName;
+  NSString* _spoolDirectoryPath;
   ParserState _state;
   NSMutableData* _data;
   NSMutableArray<DZWebServerMultiPartArgument*>* _arguments;
@@ -113,7 +129,7 @@ static NSData* _dashNewlineData = nil;
   NSString* _fileName;
   NSString* _contentType;
   NSString* _tmpPath;
-  int _tmpFile;
+  DZWebServerSpoolWriter* _tmpWriter;
   DZWebServerMIMEStreamParser* _subParser;
 }
 
@@ -132,7 +148,7 @@ static NSData* _dashNewlineData = nil;
   }
 }
 
-- (instancetype)initWithBoundary:(NSString* _Nonnull)boundary defaultControlName:(NSString* _Nullable)name arguments:(NSMutableArray<DZWebServerMultiPartArgument*>* _Nonnull)arguments files:(NSMutableArray<DZWebServerMultiPartFile*>* _Nonnull)files {
+- (instancetype)initWithBoundary:(NSString* _Nonnull)boundary defaultControlName:(NSString* _Nullable)name arguments:(NSMutableArray<DZWebServerMultiPartArgument*>* _Nonnull)arguments files:(NSMutableArray<DZWebServerMultiPartFile*>* _Nonnull)files spoolDirectoryPath:(NSString* _Nullable)spoolDirectoryPath {
   NSData* data = boundary.length ? [[NSString stringWithFormat:@"--%@", boundary] dataUsingEncoding:NSASCIIStringEncoding] : nil;
   if (data == nil) {
     DWS_DNOT_REACHED();
@@ -141,6 +157,7 @@ static NSData* _dashNewlineData = nil;
   if ((self = [super init])) {
     _boundary = data;
     _defaultcontrolName = name;
+    _spoolDirectoryPath = [spoolDirectoryPath copy];
     _arguments = arguments;
     _files = files;
     _data = [[NSMutableData alloc] initWithCapacity:kMultiPartBufferSize];
@@ -150,8 +167,8 @@ static NSData* _dashNewlineData = nil;
 }
 
 - (void)dealloc {
-  if (_tmpFile > 0) {
-    close(_tmpFile);
+  if (_tmpWriter) {
+    [_tmpWriter close:NULL];
     unlink([_tmpPath fileSystemRepresentation]);
   }
 }
@@ -201,16 +218,23 @@ static NSData* _dashNewlineData = nil;
       if (_controlName) {
         if ([DZWebServerTruncateHeaderValue(_contentType) isEqualToString:@"multipart/mixed"]) {
           NSString* boundary = DZWebServerExtractHeaderValueParameter(_contentType, @"boundary");
-          _subParser = [[DZWebServerMIMEStreamParser alloc] initWithBoundary:boundary defaultControlName:_controlName arguments:_arguments files:_files];
+          _subParser = [[DZWebServerMIMEStreamParser alloc] initWithBoundary:boundary defaultControlName:_controlName arguments:_arguments files:_files spoolDirectoryPath:_spoolDirectoryPath];
           if (_subParser == nil) {
             DWS_DNOT_REACHED();
             success = NO;
           }
         } else if (_fileName) {
-          NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
-          _tmpFile = open([path fileSystemRepresentation], O_CREAT | O_TRUNC | O_WRONLY, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
-          if (_tmpFile > 0) {
+          NSString* path = [(_spoolDirectoryPath ? _spoolDirectoryPath : NSTemporaryDirectory()) stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+          int file = DZWebServerCreateSpoolFile(path, 0, 0);  // Part sizes are not known in advance
+          if (file > 0) {
             _tmpPath = [path copy];
+            _tmpWriter = [[DZWebServerSpoolWriter alloc] initWithFileDescriptor:file];
+            if (_tmpWriter == nil) {
+              close(file);
+              unlink([path fileSystemRepresentation]);
+              _tmpPath = nil;
+              success = NO;
+            }
           } else {
             DWS_DNOT_REACHED();
             success = NO;
@@ -243,10 +267,10 @@ static NSData* _dashNewlineData = nil;
             }
             _subParser = nil;
           } else if (_tmpPath) {
-            ssize_t result = write(_tmpFile, dataBytes, dataLength);
-            if (result == (ssize_t)dataLength) {
-              if (close(_tmpFile) == 0) {
-                _tmpFile = 0;
+            if ([_tmpWriter writeData:[NSData dataWithBytes:dataBytes length:dataLength] error:NULL]) {
+              BOOL closed = [_tmpWriter close:NULL];
+              _tmpWriter = nil;
+              if (closed) {
                 DZWebServerMultiPartFile* file = [[DZWebServerMultiPartFile alloc] initWithControlName:_controlName contentType:_contentType fileName:_fileName temporaryPath:_tmpPath];
                 [_files addObject:file];
               } else {
@@ -285,8 +309,7 @@ static NSData* _dashNewlineData = nil;
             success = NO;
           }
         } else if (_tmpPath) {
-          ssize_t result = write(_tmpFile, _data.bytes, length);
-          if (result == (ssize_t)length) {
+          if ([_tmpWriter writeData:[_data subdataWithRange:NSMakeRange(0, length)] error:NULL]) {
             [_data replaceBytesInRange:NSMakeRange(0, length) withBytes:NULL length:0];
           } else {
             DWS_DNOT_REACHED();
@@ -334,7 +357,7 @@ static NSData* _dashNewlineData = nil;
 
 - (BOOL)open:(NSError**)error {
   NSString* boundary = DZWebServerExtractHeaderValueParameter(self.contentType, @"boundary");
-  _parser = [[DZWebServerMIMEStreamParser alloc] initWithBoundary:boundary defaultControlName:nil arguments:_arguments files:_files];
+  _parser = [[DZWebServerMIMEStreamParser alloc] initWithBoundary:boundary defaultControlName:nil arguments:_arguments files:_files spoolDirectoryPath:_spoolDirectoryPath];
   if (_parser == nil) {
     if (error) {
       *error = [NSError errorWithDomain:kDZWebServerErrorDomain code:-1 userInfo:@{NSLocalizedDescriptionKey : @"Failed starting to parse multipart form data"}];
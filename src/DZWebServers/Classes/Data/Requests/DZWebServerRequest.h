@@ -109,6 +109,27 @@ extern NSString* const DZWebServerRequestAttribute_RegexCaptures;
 
 @end
 
+/**
+ *  @brief A block that creates a content decoder for a request body.
+ *
+ *  The returned object is inserted in front of @a writer in the body writer
+ *  chain: its @c -open:, @c -writeData:error: and @c -close: methods receive the
+ *  encoded bytes and must forward the decoded bytes to @a writer. @a writer is
+ *  guaranteed to outlive the returned decoder, so it should be held without
+ *  retaining it (e.g., @c __unsafe_unretained).
+ *
+ *  Decoders should forward output in bounded pieces rather than accumulating
+ *  it, so that @c DZWebServerOption_MaxDecodedBodySize can stop oversized
+ *  bodies early.
+ *
+ *  @param writer The downstream body writer receiving decoded data.
+ *  @return The decoder, or @c nil if it cannot be created, in which case the
+ *          request is rejected with a @c 415 status.
+ *
+ *  @see +[DZWebServerRequest registerContentEncoding:withDecoderBlock:]
+ */
+typedef id<DZWebServerBodyWriter> _Nullable (^DZWebServerContentDecoderBlock)(id<DZWebServerBodyWriter> writer);
+
 /**
  *  @brief Base class representing a single parsed HTTP request.
  *
@@ -124,9 +145,16 @@ extern NSString* const DZWebServerRequestAttribute_RegexCaptures;
  *  and @c DZWebServerMultiPartFormRequest override these methods to store the body
  *  in memory, on disk, or to parse multipart form data, respectively.
  *
- *  When the request includes @c Content-Encoding: @c gzip, the framework
- *  automatically inserts an internal gzip decoder in the body-writer chain so that
- *  subclasses receive decompressed data transparently.
+ *  When the request includes a @c Content-Encoding header, the framework
+ *  automatically inserts the decoder registered for each listed coding in the
+ *  body-writer chain, in reverse order of application, so that subclasses
+ *  receive decompressed data transparently. gzip and deflate are always
+ *  available; brotli (@c "br") and zstd (@c "zstd") decoders are available when
+ *  DZWebServer is built with @c __DZWEBSERVER_ENABLE_BROTLI__ and
+ *  @c __DZWEBSERVER_ENABLE_ZSTD__ respectively, and applications can register
+ *  decoders for other codings with @c +registerContentEncoding:withDecoderBlock:.
+ *  If any listed coding has no registered decoder, the body is passed through
+ *  undecoded and handlers see the original @c Content-Encoding header.
  *
  *  @warning @c DZWebServerRequest instances can be created and used on any GCD
  *  thread. Do not assume main-thread access.
@@ -224,6 +252,18 @@ extern NSString* const DZWebServerRequestAttribute_RegexCaptures;
  */
 @property(nonatomic, readonly) NSUInteger contentLength;
 
+/**
+ *  @brief The largest body in bytes accepted for this request.
+ *
+ *  Set it from a handler match block to apply a per-route limit that overrides
+ *  @c DZWebServerOption_MaxRequestBodySize. A declared @c Content-Length above
+ *  the limit is rejected with a @c 413 status before the body is read, and
+ *  chunked bodies are rejected as soon as they grow past it.
+ *
+ *  The default value is @c 0 (use the server limit).
+ */
+@property(nonatomic) NSUInteger maximumBodySize;
+
 /**
  *  @brief The parsed value of the @c If-Modified-Since header as an @c NSDate.
  *
@@ -235,7 +275,8 @@ extern NSString* const DZWebServerRequestAttribute_RegexCaptures;
 @property(nonatomic, readonly, nullable) NSDate* ifModifiedSince;
 
 /**
- *  @brief The raw value of the @c If-None-Match header (typically an ETag string).
+ *  @brief The raw value of the @c If-None-Match header (an ETag, a comma-separated
+ *  list of ETags, or @c *).
  *
  *  Used for conditional GET requests based on entity tags. Returns @c nil if the
  *  header is absent.
@@ -244,11 +285,44 @@ extern NSString* const DZWebServerRequestAttribute_RegexCaptures;
  */
 @property(nonatomic, copy, readonly, nullable) NSString* ifNoneMatch;
 
+/**
+ *  @brief The parsed value of the @c If-Unmodified-Since header as an @c NSDate.
+ *
+ *  Used for conditional requests that must fail with a 412 when the resource changed
+ *  after the given date. Returns @c nil if the header is absent or could not be parsed.
+ *
+ *  @see ifMatch
+ */
+@property(nonatomic, readonly, nullable) NSDate* ifUnmodifiedSince;
+
+/**
+ *  @brief The raw value of the @c If-Match header (an ETag, a comma-separated list
+ *  of ETags, or @c *).
+ *
+ *  Used for conditional requests that must fail with a 412 when none of the ETags
+ *  matches the current one. Returns @c nil if the header is absent.
+ *
+ *  @see ifUnmodifiedSince
+ */
+@property(nonatomic, copy, readonly, nullable) NSString* ifMatch;
+
+/**
+ *  @brief The raw value of the @c If-Range header (an ETag or an HTTP date).
+ *
+ *  Used by resumed downloads: the @c Range header only applies if the validator
+ *  still matches the resource, otherwise the full content is sent. Returns @c nil
+ *  if the header is absent.
+ *
+ *  @see byteRanges
+ */
+@property(nonatomic, copy, readonly, nullable) NSString* ifRange;
+
 /**
  *  @brief The parsed byte range from the @c Range header.
  *
  *  @discussion The @c Range header is parsed according to RFC 7233 @c bytes= syntax.
- *  Only single-range requests are supported; multi-range requests are ignored.
+ *  This property is only set for single-range requests; use @c byteRanges to
+ *  handle requests for several ranges.
  *
  *  The value encodes three distinct cases:
  *  - <b>From beginning:</b> @c "bytes=500-999" produces @c {.location=500, .length=500}.
@@ -262,17 +336,47 @@ extern NSString* const DZWebServerRequestAttribute_RegexCaptures;
  */
 @property(nonatomic, readonly) NSRange byteRange;
 
+/**
+ *  @brief All byte ranges parsed from the @c Range header, in request order.
+ *
+ *  Each element is an @c NSValue wrapping an @c NSRange encoded with the same
+ *  conventions as @c byteRange. Requests such as @c "bytes=0-99,200-299" yield
+ *  several elements, which @c DZWebServerFileResponse serves as a
+ *  @c multipart/byteranges body.
+ *
+ *  The value is @c nil if the @c Range header is absent, syntactically invalid
+ *  or lists more than 64 ranges.
+ *
+ *  @see byteRange
+ *  @see -[DZWebServerFileResponse initWithFile:byteRanges:isAttachment:mimeTypeOverrides:precompressedVariantsForRequest:]
+ */
+@property(nonatomic, copy, readonly, nullable) NSArray<NSValue*>* byteRanges;
+
 /**
  *  @brief Whether the client advertises support for gzip content encoding.
  *
- *  Returns @c YES if the @c Accept-Encoding header contains the string @c "gzip".
- *  When this is @c YES, response handlers may choose to send gzip-compressed
- *  response bodies for bandwidth savings.
+ *  Returns @c YES if the @c Accept-Encoding header lists @c "gzip" (or @c "*")
+ *  with a non-zero quality value. When this is @c YES, response handlers may
+ *  choose to send gzip-compressed response bodies for bandwidth savings.
  *
- *  Defaults to @c NO if the @c Accept-Encoding header is absent.
+ *  Defaults to @c NO if the @c Accept-Encoding header is absent, consistent
+ *  with @c -preferredContentEncodingFromEncodings: returning @c nil in that case.
+ *
+ *  @see -qualityForContentEncoding:
  */
 @property(nonatomic, readonly) BOOL acceptsGzipContentEncoding;
 
+/**
+ *  @brief Whether the client sent a @c HEAD request.
+ *
+ *  @c YES for @c HEAD requests, including the ones handled by @c GET handlers
+ *  when @c DZWebServerOption_AutomaticallyMapHEADToGET is enabled (in which case
+ *  @c method is @c "GET"). Handlers can use it to skip generating a body that
+ *  will never be sent and return a response created with
+ *  @c +[DZWebServerResponse responseWithContentType:contentLength:] instead.
+ */
+@property(nonatomic, readonly, getter=isHeadRequest) BOOL headRequest;
+
 /**
  *  @brief The local (server-side) socket address as raw @c struct @c sockaddr data.
  *
@@ -343,9 +447,12 @@ extern NSString* const DZWebServerRequestAttribute_RegexCaptures;
  *  - @c Transfer-Encoding -- to detect chunked transfer encoding.
  *  - @c If-Modified-Since -- parsed as an RFC 822 date into @c ifModifiedSince.
  *  - @c If-None-Match -- stored as-is into @c ifNoneMatch.
- *  - @c Range -- parsed into @c byteRange. Only single byte ranges in the
- *    @c bytes= format are supported.
- *  - @c Accept-Encoding -- checked for @c "gzip" to set @c acceptsGzipContentEncoding.
+ *  - @c If-Unmodified-Since -- parsed as an RFC 822 date into @c ifUnmodifiedSince.
+ *  - @c If-Match and @c If-Range -- stored as-is into @c ifMatch and @c ifRange.
+ *  - @c Range -- parsed into @c byteRanges, and into @c byteRange for a
+ *    single range, in the @c bytes= format.
+ *  - @c Accept-Encoding -- parsed with its quality values to set
+ *    @c acceptsGzipContentEncoding and answer @c -qualityForContentEncoding:.
  *
  *  @param method  The HTTP method string (e.g., @c @"GET", @c @"POST").
  *  @param url     The full request URL.
@@ -387,6 +494,98 @@ extern NSString* const DZWebServerRequestAttribute_RegexCaptures;
  */
 - (BOOL)hasByteRange;
 
+/**
+ *  @brief Returns the quality value the client assigned to a content coding.
+ *
+ *  The @c Accept-Encoding header is parsed once at initialization, including
+ *  the optional @c q= weight of each coding (defaulting to @c 1.0). Coding
+ *  names are compared case-insensitively. A coding not listed explicitly takes
+ *  the weight of @c "*" if present. @c "identity" is acceptable with weight
+ *  @c 1.0 unless it is excluded explicitly or through @c "*;q=0".
+ *
+ *  If the @c Accept-Encoding header is absent, every coding returns @c 1.0.
+ *
+ *  @param encoding The content coding name (e.g., @c @"gzip", @c @"br").
+ *  @return The quality value between @c 0.0 (not acceptable) and @c 1.0.
+ *
+ *  @see -preferredContentEncodingFromEncodings:
+ */
+- (double)qualityForContentEncoding:(NSString*)encoding;
+
+/**
+ *  @brief Selects the content coding the client prefers among the ones available.
+ *
+ *  Returns the coding from @a encodings with the highest non-zero quality value
+ *  in the @c Accept-Encoding header. When several codings have the same quality,
+ *  the one appearing first in @a encodings wins, so callers should list them in
+ *  server preference order (e.g., @c @[@"br", @"zstd", @"gzip"]).
+ *
+ *  Unlike @c -qualityForContentEncoding:, this method returns @c nil if the
+ *  @c Accept-Encoding header is absent, so that encoded content is only sent to
+ *  clients that explicitly ask for it.
+ *
+ *  @param encodings The content codings the server can produce, in preference order.
+ *  @return The selected coding, or @c nil if the body should be sent unencoded.
+ *
+ *  @see -qualityForContentEncoding:
+ */
+- (nullable NSString*)preferredContentEncodingFromEncodings:(NSArray<NSString*>*)encodings
+    NS_SWIFT_NAME(preferredContentEncoding(from:));
+
+/**
+ *  @brief Sends an informational (1xx) response ahead of the final response.
+ *
+ *  Informational responses can be sent any number of times while the request is
+ *  being processed, i.e. from the process block or before calling the completion
+ *  block of an asynchronous handler. They are written to the socket in order,
+ *  before the final response. This method can be called from any thread, and
+ *  returns @c NO once the final response has started.
+ *
+ *  Status codes @c 100 and @c 101 are reserved for the server, and nothing is
+ *  sent to HTTP/1.0 clients as they do not understand informational responses.
+ *
+ *  @param statusCode The informational status code (102 to 199).
+ *  @param headers    The headers to send, or @c nil.
+ *  @return @c YES if the response was queued for sending, @c NO otherwise.
+ *
+ *  @see -sendEarlyHintsWithLinks:
+ */
+- (BOOL)sendInformationalResponseWithStatusCode:(NSInteger)statusCode headers:(nullable NSDictionary<NSString*, NSString*>*)headers;
+
+/**
+ *  @brief Sends a @c 103 Early Hints response with @c Link headers.
+ *
+ *  Lets browsers start fetching the resources the final response will need
+ *  while the handler is still generating it, for instance
+ *  @c @"</css/index.css>; rel=preload; as=style".
+ *
+ *  @param links The @c Link header values, joined into a single header.
+ *  @return @c YES if the response was queued for sending, @c NO otherwise.
+ *
+ *  @see -sendInformationalResponseWithStatusCode:headers:
+ */
+- (BOOL)sendEarlyHintsWithLinks:(NSArray<NSString*>*)links;
+
+/**
+ *  @brief Registers a decoder for a request body content coding.
+ *
+ *  Registering a coding that is already registered replaces its decoder.
+ *  Coding names are case-insensitive.
+ *
+ *  @param encoding The content coding name received in the @c Content-Encoding header.
+ *  @param block    The block creating decoders for this coding.
+ *
+ *  @note This method is thread-safe.
+ */
++ (void)registerContentEncoding:(NSString*)encoding withDecoderBlock:(DZWebServerContentDecoderBlock)block;
+
+/**
+ *  @brief Returns the request body content codings with a registered decoder.
+ *
+ *  @return The lowercased content coding names.
+ */
++ (NSArray<NSString*>*)registeredContentEncodings;
+
 /**
  *  @brief Retrieves a custom attribute associated with this request.
  *
@@ -30,28 +30,63 @@
 #endif
 
 #import <zlib.h>
+#if defined(__DZWEBSERVER_ENABLE_BROTLI__)
+#import <brotli/decode.h>
+#endif
+#if defined(__DZWEBSERVER_ENABLE_ZSTD__)
+#import <zstd.h>
+#endif
 
 #import "DZWebServerPrivate.h"
 
 NSString* const DZWebServerRequestAttribute_RegexCaptures = @"DZWebServerRequestAttribute_RegexCaptures";
 
 #define kZlibErrorDomain @"ZlibErrorDomain"
-#define kGZipInitialBufferSize (256 * 1024)
+#define kBrotliErrorDomain @"BrotliErrorDomain"
+#define kZstdErrorDomain @"ZstdErrorDomain"
+#define kDecoderBufferSize (64 * 1024)
+#define kMaxByteRanges 64
+#define kGZipMinimumBufferSize (4 * 1024)
+#define kGZipInitialDecodingRatio 4.0
 
 @interface DZWebServerBodyDecoder : NSObject <DZWebServerBodyWriter>
+- (instancetype)initWithWriter:(id<DZWebServerBodyWriter> _Nonnull)writer;
 @end
 
 @interface DZWebServerGZipDecoder : DZWebServerBodyDecoder
 @end
 
+@interface DZWebServerDeflateDecoder : DZWebServerGZipDecoder
+@end
+
+#if defined(__DZWEBSERVER_ENABLE_BROTLI__)
+
+@interface DZWebServerBrotliDecoder : DZWebServerBodyDecoder
+@end
+
+#endif
+
+#if defined(__DZWEBSERVER_ENABLE_ZSTD__)
+
+@interface DZWebServerZstdDecoder : DZWebServerBodyDecoder
+@end
+
+#endif
+
+@interface DZWebServerDecodedBodyLimiter : NSObject <DZWebServerBodyWriter>
+- (instancetype)initWithWriter:(id<DZWebServerBodyWriter> _Nonnull)writer maximumSize:(NSUInteger)maximumSize;
+@end
+
+static NSError* _TruncatedBodyError(void) {
+  return [NSError errorWithDomain:kDZWebServerErrorDomain code:-1 userInfo:@{NSLocalizedDescriptionKey : @"Truncated encoded request body"}];
+}
+
 @implementation DZWebServerBodyDecoder {
-  DZWebServerRequest* __unsafe_unretained _request;
   id<DZWebServerBodyWriter> __unsafe_unretained _writer;
 }
 
-- (instancetype)initWithRequest:(DZWebServerRequest* _Nonnull)request writer:(id<DZWebServerBodyWriter> _Nonnull)writer {
+- (instancetype)initWithWriter:(id<DZWebServerBodyWriter> _Nonnull)writer {
   if ((self = [super init])) {
-    _request = request;
     _writer = writer;
   }
   return self;
@@ -72,73 +107,411 @@ NSString* const DZWebServerRequestAttribute_RegexCaptures = @"DZWebServerRequest
 @end
 
 @implementation DZWebServerGZipDecoder {
-  z_stream _stream;
+  z_stream* _stream;
+  int _windowBits;
+  double _ratio;
   BOOL _finished;
 }
 
+- (void)dealloc {
+  if (_stream) {
+    DZWebServerEnqueueInflateStream(_stream, _windowBits);  // Request was aborted before the body was complete
+  }
+}
+
+- (int)windowBitsForData:(NSData*)data {
+  return 15 + 16;
+}
+
 - (BOOL)open:(NSError**)error {
-  int result = inflateInit2(&_stream, 15 + 16);
-  if (result != Z_OK) {
+  _ratio = kGZipInitialDecodingRatio;
+  return [super open:error];
+}
+
+- (BOOL)writeData:(NSData*)data error:(NSError**)error {
+  if (_finished) {
+    return YES;  // Ignore trailing garbage after the end of the stream
+  }
+  if (_stream == NULL) {  // The stream is set up lazily so the deflate decoder can detect the data format
+    int result;
+    _windowBits = [self windowBitsForData:data];
+    _stream = DZWebServerDequeueInflateStream(_windowBits, &result);
+    if (_stream == NULL) {
+      if (error) {
+        *error = [NSError errorWithDomain:kZlibErrorDomain code:result userInfo:nil];
+      }
+      return NO;
+    }
+  }
+  _stream->next_in = (Bytef*)data.bytes;
+  _stream->avail_in = (uInt)data.length;
+  NSUInteger capacity = MIN(MAX((NSUInteger)(data.length * _ratio), kGZipMinimumBufferSize), kDZWebServerZlibBufferSize);  // Size the output from the ratio observed so far instead of always allocating the maximum
+  while (1) {
+    NSMutableData* decodedData = [[NSMutableData alloc] initWithLength:capacity];
+    if (decodedData == nil) {
+      DWS_DNOT_REACHED();
+      return NO;
+    }
+    _stream->next_out = (Bytef*)decodedData.mutableBytes;
+    _stream->avail_out = (uInt)capacity;
+    int result = inflate(_stream, Z_NO_FLUSH);
+    if ((result != Z_OK) && (result != Z_STREAM_END) && !((result == Z_BUF_ERROR) && (_stream->avail_in == 0))) {
+      if (error) {
+        *error = [NSError errorWithDomain:kZlibErrorDomain code:result userInfo:nil];
+      }
+      return NO;
+    }
+    decodedData.length = capacity - _stream->avail_out;
+    if (decodedData.length && ![super writeData:decodedData error:error]) {  // Pass output downstream as soon as the buffer is full so highly compressed input never expands at once in memory
+      return NO;
+    }
+    if (result == Z_STREAM_END) {
+      _finished = YES;
+      break;
+    }
+    if (_stream->avail_out > 0) {
+      break;
+    }
+    capacity = kDZWebServerZlibBufferSize;
+  }
+  if (_stream->total_in) {
+    _ratio = (double)_stream->total_out / (double)_stream->total_in + 0.5;  // Slight headroom avoids a second pass when the ratio is stable
+  }
+  return YES;
+}
+
+- (BOOL)close:(NSError**)error {
+  if (_stream) {
+    DZWebServerEnqueueInflateStream(_stream, _windowBits);
+    _stream = NULL;
+  }
+  if (!_finished) {
     if (error) {
-      *error = [NSError errorWithDomain:kZlibErrorDomain code:result userInfo:nil];
+      *error = _TruncatedBodyError();
     }
     return NO;
   }
-  if (![super open:error]) {
-    inflateEnd(&_stream);
+  return [super close:error];
+}
+
+@end
+
+@implementation DZWebServerDeflateDecoder
+
+// "deflate" is specified as zlib data but some clients send raw deflate data instead
+- (int)windowBitsForData:(NSData*)data {
+  const unsigned char* bytes = data.bytes;
+  if ((data.length >= 2) && ((bytes[0] & 0x0F) == Z_DEFLATED) && ((((unsigned int)bytes[0] << 8) | bytes[1]) % 31 == 0)) {
+    return 15;
+  }
+  return -15;
+}
+
+@end
+
+#if defined(__DZWEBSERVER_ENABLE_BROTLI__)
+
+@implementation DZWebServerBrotliDecoder {
+  BrotliDecoderState* _state;
+  BOOL _finished;
+}
+
+- (void)dealloc {
+  if (_state) {
+    BrotliDecoderDestroyInstance(_state);
+  }
+}
+
+- (BOOL)open:(NSError**)error {
+  _state = BrotliDecoderCreateInstance(NULL, NULL, NULL);
+  if (_state == NULL) {
+    if (error) {
+      *error = [NSError errorWithDomain:kBrotliErrorDomain code:-1 userInfo:@{NSLocalizedDescriptionKey : @"Failed creating brotli decoder"}];
+    }
     return NO;
   }
-  return YES;
+  return [super open:error];
 }
 
 - (BOOL)writeData:(NSData*)data error:(NSError**)error {
-  DWS_DCHECK(!_finished);
-  _stream.next_in = (Bytef*)data.bytes;
-  _stream.avail_in = (uInt)data.length;
-  NSMutableData* decodedData = [[NSMutableData alloc] initWithLength:kGZipInitialBufferSize];
-  if (decodedData == nil) {
-    DWS_DNOT_REACHED();
-    return NO;
+  if (_finished) {
+    return YES;
   }
-  NSUInteger length = 0;
+  size_t availableIn = data.length;
+  const uint8_t* nextIn = data.bytes;
   while (1) {
-    NSUInteger maxLength = decodedData.length - length;
-    _stream.next_out = (Bytef*)((char*)decodedData.mutableBytes + length);
-    _stream.avail_out = (uInt)maxLength;
-    int result = inflate(&_stream, Z_NO_FLUSH);
-    if ((result != Z_OK) && (result != Z_STREAM_END)) {
+    NSMutableData* decodedData = [[NSMutableData alloc] initWithLength:kDecoderBufferSize];
+    size_t availableOut = kDecoderBufferSize;
+    uint8_t* nextOut = decodedData.mutableBytes;
+    BrotliDecoderResult result = BrotliDecoderDecompressStream(_state, &availableIn, &nextIn, &availableOut, &nextOut, NULL);
+    if (result == BROTLI_DECODER_RESULT_ERROR) {
       if (error) {
-        *error = [NSError errorWithDomain:kZlibErrorDomain code:result userInfo:nil];
+        BrotliDecoderErrorCode code = BrotliDecoderGetErrorCode(_state);
+        *error = [NSError errorWithDomain:kBrotliErrorDomain code:code userInfo:@{NSLocalizedDescriptionKey : [NSString stringWithUTF8String:BrotliDecoderErrorString(code)]}];
       }
       return NO;
     }
-    length += maxLength - _stream.avail_out;
-    if (_stream.avail_out > 0) {
-      if (result == Z_STREAM_END) {
-        _finished = YES;
+    decodedData.length = kDecoderBufferSize - availableOut;
+    if (decodedData.length && ![super writeData:decodedData error:error]) {
+      return NO;
+    }
+    if (result == BROTLI_DECODER_RESULT_SUCCESS) {
+      _finished = YES;
+      break;
+    }
+    if (result == BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT) {
+      break;
+    }
+  }
+  return YES;
+}
+
+- (BOOL)close:(NSError**)error {
+  BrotliDecoderDestroyInstance(_state);
+  _state = NULL;
+  if (!_finished) {
+    if (error) {
+      *error = _TruncatedBodyError();
+    }
+    return NO;
+  }
+  return [super close:error];
+}
+
+@end
+
+#endif
+
+#if defined(__DZWEBSERVER_ENABLE_ZSTD__)
+
+@implementation DZWebServerZstdDecoder {
+  ZSTD_DStream* _stream;
+  BOOL _finished;
+}
+
+- (void)dealloc {
+  ZSTD_freeDStream(_stream);  // Accepts NULL
+}
+
+- (BOOL)open:(NSError**)error {
+  _stream = ZSTD_createDStream();
+  if (_stream == NULL) {
+    if (error) {
+      *error = [NSError errorWithDomain:kZstdErrorDomain code:-1 userInfo:@{NSLocalizedDescriptionKey : @"Failed creating zstd decoder"}];
+    }
+    return NO;
+  }
+  return [super open:error];
+}
+
+- (BOOL)writeData:(NSData*)data error:(NSError**)error {
+  ZSTD_inBuffer input = {data.bytes, data.length, 0};
+  while (1) {
+    NSMutableData* decodedData = [[NSMutableData alloc] initWithLength:kDecoderBufferSize];
+    ZSTD_outBuffer output = {decodedData.mutableBytes, kDecoderBufferSize, 0};
+    size_t result = ZSTD_decompressStream(_stream, &output, &input);
+    if (ZSTD_isError(result)) {
+      if (error) {
+        *error = [NSError errorWithDomain:kZstdErrorDomain code:(NSInteger)ZSTD_getErrorCode(result) userInfo:@{NSLocalizedDescriptionKey : [NSString stringWithUTF8String:ZSTD_getErrorName(result)]}];
       }
+      return NO;
+    }
+    _finished = (result == 0);  // A complete frame was decoded, a new one may follow
+    decodedData.length = output.pos;
+    if (decodedData.length && ![super writeData:decodedData error:error]) {
+      return NO;
+    }
+    if ((input.pos == input.size) && (output.pos < output.size)) {
       break;
     }
-    decodedData.length = 2 * decodedData.length;  // zlib has used all the output buffer so resize it and try again in case more data is available
   }
-  decodedData.length = length;
-  BOOL success = length ? [super writeData:decodedData error:error] : YES;  // No need to call writer if we have no data yet
-  return success;
+  return YES;
 }
 
 - (BOOL)close:(NSError**)error {
-  DWS_DCHECK(_finished);
-  inflateEnd(&_stream);
+  ZSTD_freeDStream(_stream);
+  _stream = NULL;
+  if (!_finished) {
+    if (error) {
+      *error = _TruncatedBodyError();
+    }
+    return NO;
+  }
   return [super close:error];
 }
 
 @end
 
+#endif
+
+@implementation DZWebServerDecodedBodyLimiter {
+  id<DZWebServerBodyWriter> __unsafe_unretained _writer;
+  NSUInteger _maximumSize;
+  NSUInteger _length;
+}
+
+- (instancetype)initWithWriter:(id<DZWebServerBodyWriter> _Nonnull)writer maximumSize:(NSUInteger)maximumSize {
+  if ((self = [super init])) {
+    _writer = writer;
+    _maximumSize = maximumSize;
+  }
+  return self;
+}
+
+- (BOOL)open:(NSError**)error {
+  return [_writer open:error];
+}
+
+- (BOOL)writeData:(NSData*)data error:(NSError**)error {
+  _length += data.length;
+  if (_length > _maximumSize) {
+    if (error) {
+      *error = [NSError errorWithDomain:kDZWebServerErrorDomain code:kDZWebServerHTTPStatusCode_RequestEntityTooLarge userInfo:@{NSLocalizedDescriptionKey : @"Decoded request body exceeds maximum size"}];
+    }
+    return NO;
+  }
+  return [_writer writeData:data error:error];
+}
+
+- (BOOL)close:(NSError**)error {
+  return [_writer close:error];
+}
+
+@end
+
+static dispatch_queue_t _decoderRegistryQueue = NULL;
+static NSMutableDictionary<NSString*, DZWebServerContentDecoderBlock>* _decoderBlocks = nil;  // Accessed through _decoderRegistryQueue only
+static NSMutableArray<NSString*>* _decoderNames = nil;  // Accessed through _decoderRegistryQueue only
+
+static void _RegisterContentDecoder(NSString* encoding, DZWebServerContentDecoderBlock block) {
+  NSString* name = [encoding lowercaseString];
+  dispatch_sync(_decoderRegistryQueue, ^{
+    if ([_decoderBlocks objectForKey:name] == nil) {
+      [_decoderNames addObject:name];
+    }
+    [_decoderBlocks setObject:[block copy] forKey:name];
+  });
+}
+
+static void _InitializeContentDecoderRegistry(void) {
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    _decoderRegistryQueue = dispatch_queue_create("DZWebServerRequest.decoders", DISPATCH_QUEUE_SERIAL);
+    _decoderBlocks = [[NSMutableDictionary alloc] init];
+    _decoderNames = [[NSMutableArray alloc] init];
+
+    DZWebServerContentDecoderBlock gzipBlock = ^id<DZWebServerBodyWriter>(id<DZWebServerBodyWriter> writer) {
+      return [[DZWebServerGZipDecoder alloc] initWithWriter:writer];
+    };
+    _RegisterContentDecoder(@"gzip", gzipBlock);
+    _RegisterContentDecoder(@"x-gzip", gzipBlock);  // Legacy alias from RFC 9110
+    _RegisterContentDecoder(@"deflate", ^id<DZWebServerBodyWriter>(id<DZWebServerBodyWriter> writer) {
+      return [[DZWebServerDeflateDecoder alloc] initWithWriter:writer];
+    });
+#if defined(__DZWEBSERVER_ENABLE_BROTLI__)
+    _RegisterContentDecoder(@"br", ^id<DZWebServerBodyWriter>(id<DZWebServerBodyWriter> writer) {
+      return [[DZWebServerBrotliDecoder alloc] initWithWriter:writer];
+    });
+#endif
+#if defined(__DZWEBSERVER_ENABLE_ZSTD__)
+    _RegisterContentDecoder(@"zstd", ^id<DZWebServerBodyWriter>(id<DZWebServerBodyWriter> writer) {
+      return [[DZWebServerZstdDecoder alloc] initWithWriter:writer];
+    });
+#endif
+  });
+}
+
+static DZWebServerContentDecoderBlock _ContentDecoderBlockForEncoding(NSString* encoding) {
+  _InitializeContentDecoderRegistry();
+  __block DZWebServerContentDecoderBlock block;
+  dispatch_sync(_decoderRegistryQueue, ^{
+    block = [_decoderBlocks objectForKey:encoding];
+  });
+  return block;
+}
+
+static NSRange _ParseByteRange(NSString* string) {
+  NSRange range = NSMakeRange(NSUIntegerMax, 0);
+  NSArray* components = [string componentsSeparatedByString:@"-"];
+  if (components.count == 2) {
+    NSString* startString = [[components objectAtIndex:0] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+    NSInteger startValue = [startString integerValue];
+    NSString* endString = [[components objectAtIndex:1] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+    NSInteger endValue = [endString integerValue];
+    if (startString.length && (startValue >= 0) && endString.length && (endValue >= startValue)) {  // The second 500 bytes: "500-999"
+      range.location = startValue;
+      range.length = endValue - startValue + 1;
+    } else if (startString.length && (startValue >= 0)) {  // The bytes after 9500 bytes: "9500-"
+      range.location = startValue;
+      range.length = NSUIntegerMax;
+    } else if (endString.length && (endValue > 0)) {  // The final 500 bytes: "-500"
+      range.location = NSUIntegerMax;
+      range.length = endValue;
+    }
+  }
+  return range;
+}
+
+// Returns nil if any range is invalid or if there are too many of them
+static NSArray<NSValue*>* _ParseByteRanges(NSString* string) {
+  NSArray<NSString*>* components = [string componentsSeparatedByString:@","];
+  if (components.count > kMaxByteRanges) {
+    return nil;
+  }
+  NSMutableArray<NSValue*>* ranges = [[NSMutableArray alloc] initWithCapacity:components.count];
+  for (NSString* component in components) {
+    NSRange range = _ParseByteRange(component);
+    if (!DZWebServerIsValidByteRange(range)) {
+      return nil;
+    }
+    [ranges addObject:[NSValue valueWithRange:range]];
+  }
+  return ranges;
+}
+
+static NSDictionary<NSString*, NSNumber*>* _ParseAcceptEncodingHeader(NSString* header) {
+  NSMutableDictionary<NSString*, NSNumber*>* qualities = [[NSMutableDictionary alloc] init];
+  for (NSString* element in [header componentsSeparatedByString:@","]) {
+    NSArray<NSString*>* parameters = [element componentsSeparatedByString:@";"];
+    NSString* coding = [[parameters.firstObject stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]] lowercaseString];
+    if (coding.length == 0) {
+      continue;
+    }
+    double quality = 1.0;
+    for (NSUInteger i = 1; i < parameters.count; ++i) {
+      NSString* parameter = [[parameters objectAtIndex:i] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+      if ([parameter hasPrefix:@"q="] || [parameter hasPrefix:@"Q="]) {
+        quality = MIN(MAX([[parameter substringFromIndex:2] doubleValue], 0.0), 1.0);
+      }
+    }
+    if ([qualities objectForKey:coding] == nil) {  // First occurrence wins
+      [qualities setObject:[NSNumber numberWithDouble:quality] forKey:coding];
+    }
+  }
+  return qualities;
+}
+
 @implementation DZWebServerRequest {
   BOOL _opened;
-  NSMutableArray<DZWebServerBodyDecoder*>* _decoders;
+  NSDictionary<NSString*, NSNumber*>* _acceptedEncodings;
+  NSMutableArray<id<DZWebServerBodyWriter>>* _decoders;
   id<DZWebServerBodyWriter> __unsafe_unretained _writer;
   NSMutableDictionary<NSString*, id>* _attributes;
+  NSUInteger _bufferedBodySize;
+}
+
++ (void)registerContentEncoding:(NSString*)encoding withDecoderBlock:(DZWebServerContentDecoderBlock)block {
+  _InitializeContentDecoderRegistry();
+  _RegisterContentDecoder(encoding, block);
+}
+
++ (NSArray<NSString*>*)registeredContentEncodings {
+  _InitializeContentDecoderRegistry();
+  __block NSArray<NSString*>* encodings;
+  dispatch_sync(_decoderRegistryQueue, ^{
+    encodings = [_decoderNames copy];
+  });
+  return encodings;
 }
 
 - (instancetype)initWithMethod:(NSString*)method url:(NSURL*)url headers:(NSDictionary<NSString*, NSString*>*)headers path:(NSString*)path query:(NSDictionary<NSString*, NSString*>*)query {
@@ -181,39 +554,33 @@ NSString* const DZWebServerRequestAttribute_RegexCaptures = @"DZWebServerRequest
       _ifModifiedSince = [DZWebServerParseRFC822(modifiedHeader) copy];
     }
     _ifNoneMatch = [_headers objectForKey:@"If-None-Match"];
+    NSString* unmodifiedHeader = [_headers objectForKey:@"If-Unmodified-Since"];
+    if (unmodifiedHeader) {
+      _ifUnmodifiedSince = [DZWebServerParseRFC822(unmodifiedHeader) copy];
+    }
+    _ifMatch = [_headers objectForKey:@"If-Match"];
+    _ifRange = [_headers objectForKey:@"If-Range"];
+
+    _headRequest = [_method isEqualToString:@"HEAD"];
 
     _byteRange = NSMakeRange(NSUIntegerMax, 0);
     NSString* rangeHeader = DZWebServerNormalizeHeaderValue([_headers objectForKey:@"Range"]);
     if (rangeHeader) {
       if ([rangeHeader hasPrefix:@"bytes="]) {
-        NSArray* components = [[rangeHeader substringFromIndex:6] componentsSeparatedByString:@","];
-        if (components.count == 1) {
-          components = [(NSString*)[components firstObject] componentsSeparatedByString:@"-"];
-          if (components.count == 2) {
-            NSString* startString = [components objectAtIndex:0];
-            NSInteger startValue = [startString integerValue];
-            NSString* endString = [components objectAtIndex:1];
-            NSInteger endValue = [endString integerValue];
-            if (startString.length && (startValue >= 0) && endString.length && (endValue >= startValue)) {  // The second 500 bytes: "500-999"
-              _byteRange.location = startValue;
-              _byteRange.length = endValue - startValue + 1;
-            } else if (startString.length && (startValue >= 0)) {  // The bytes after 9500 bytes: "9500-"
-              _byteRange.location = startValue;
-              _byteRange.length = NSUIntegerMax;
-            } else if (endString.length && (endValue > 0)) {  // The final 500 bytes: "-500"
-              _byteRange.location = NSUIntegerMax;
-              _byteRange.length = endValue;
-            }
-          }
+        _byteRanges = _ParseByteRanges([rangeHeader substringFromIndex:6]);
+        if (_byteRanges.count == 1) {
+          _byteRange = _byteRanges.firstObject.rangeValue;
         }
       }
-      if ((_byteRange.location == NSUIntegerMax) && (_byteRange.length == 0)) {  // Ignore "Range" header if syntactically invalid
+      if (_byteRanges == nil) {  // Ignore "Range" header if syntactically invalid
         DWS_LOG_WARNING(@"Failed to parse 'Range' header \"%@\" for url: %@", rangeHeader, url);
       }
     }
 
-    if ([[_headers objectForKey:@"Accept-Encoding"] rangeOfString:@"gzip"].location != NSNotFound) {
-      _acceptsGzipContentEncoding = YES;
+    NSString* acceptEncodingHeader = [_headers objectForKey:@"Accept-Encoding"];
+    if (acceptEncodingHeader) {  // Left NO without the header, like -preferredContentEncodingFromEncodings:
+      _acceptedEncodings = _ParseAcceptEncodingHeader(acceptEncodingHeader);
+      _acceptsGzipContentEncoding = ([self qualityForContentEncoding:@"gzip"] > 0.0);
     }
 
     _decoders = [[NSMutableArray alloc] init];
@@ -222,6 +589,10 @@ NSString* const DZWebServerRequestAttribute_RegexCaptures = @"DZWebServerRequest
   return self;
 }
 
+- (void)dealloc {
+  [self releaseBufferedBodySize];  // Body bytes kept in memory are released with the request
+}
+
 - (BOOL)hasBody {
   return _contentType ? YES : NO;
 }
@@ -230,6 +601,49 @@ NSString* const DZWebServerRequestAttribute_RegexCaptures = @"DZWebServerRequest
   return DZWebServerIsValidByteRange(_byteRange);
 }
 
+- (double)qualityForContentEncoding:(NSString*)encoding {
+  if (_acceptedEncodings == nil) {
+    return 1.0;
+  }
+  NSString* coding = [encoding lowercaseString];
+  NSNumber* quality = [_acceptedEncodings objectForKey:coding];
+  if (quality == nil) {
+    quality = [_acceptedEncodings objectForKey:@"*"];
+  }
+  if (quality == nil) {
+    return [coding isEqualToString:@"identity"] ? 1.0 : 0.0;  // "identity" is always acceptable unless explicitly excluded
+  }
+  return quality.doubleValue;
+}
+
+- (NSString*)preferredContentEncodingFromEncodings:(NSArray<NSString*>*)encodings {
+  if (_acceptedEncodings == nil) {
+    return nil;  // Don't send encoded content to clients that didn't ask for it
+  }
+  NSString* preferredEncoding = nil;
+  double preferredQuality = 0.0;
+  for (NSString* encoding in encodings) {
+    double quality = [self qualityForContentEncoding:encoding];
+    if (quality > preferredQuality) {  // Ties are resolved by keeping the earlier encoding i.e. the server preference
+      preferredEncoding = encoding;
+      preferredQuality = quality;
+    }
+  }
+  return preferredEncoding;
+}
+
+- (BOOL)sendInformationalResponseWithStatusCode:(NSInteger)statusCode headers:(NSDictionary<NSString*, NSString*>*)headers {
+  DZWebServerInformationalResponseBlock block = self.informationalResponseBlock;
+  return block ? block(statusCode, headers) : NO;
+}
+
+- (BOOL)sendEarlyHintsWithLinks:(NSArray<NSString*>*)links {
+  if (links.count == 0) {
+    return NO;
+  }
+  return [self sendInformationalResponseWithStatusCode:kDZWebServerHTTPStatusCode_EarlyHints headers:@{@"Link" : [links componentsJoinedByString:@", "]}];
+}
+
 - (id)attributeForKey:(NSString*)key {
   return [_attributes objectForKey:key];
 }
@@ -246,13 +660,44 @@ NSString* const DZWebServerRequestAttribute_RegexCaptures = @"DZWebServerRequest
   return YES;
 }
 
-- (void)prepareForWriting {
+- (BOOL)prepareForWritingWithMaximumDecodedBodySize:(NSUInteger)maximumSize {
   _writer = self;
-  if ([DZWebServerNormalizeHeaderValue([self.headers objectForKey:@"Content-Encoding"]) isEqualToString:@"gzip"]) {
-    DZWebServerGZipDecoder* decoder = [[DZWebServerGZipDecoder alloc] initWithRequest:self writer:_writer];
+  NSString* header = [self.headers objectForKey:@"Content-Encoding"];
+  if (header == nil) {
+    return YES;
+  }
+
+  // Bodies using a coding without a registered decoder are passed through undecoded for the handler to deal with
+  NSMutableArray<DZWebServerContentDecoderBlock>* blocks = [[NSMutableArray alloc] init];
+  for (NSString* element in [header componentsSeparatedByString:@","]) {
+    NSString* encoding = [[element stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]] lowercaseString];
+    if ((encoding.length == 0) || [encoding isEqualToString:@"identity"]) {
+      continue;
+    }
+    DZWebServerContentDecoderBlock block = _ContentDecoderBlockForEncoding(encoding);
+    if (block == nil) {
+      DWS_LOG_DEBUG(@"No decoder registered for '%@' content encoding, passing request body through", encoding);
+      return YES;
+    }
+    [blocks addObject:block];
+  }
+
+  // Codings are listed in the order they were applied so the first one must end up closest to the request
+  for (DZWebServerContentDecoderBlock block in blocks) {
+    if (maximumSize > 0) {
+      DZWebServerDecodedBodyLimiter* limiter = [[DZWebServerDecodedBodyLimiter alloc] initWithWriter:_writer maximumSize:maximumSize];
+      [_decoders addObject:limiter];
+      _writer = limiter;
+    }
+    id<DZWebServerBodyWriter> decoder = block(_writer);
+    if (decoder == nil) {
+      DWS_LOG_WARNING(@"Failed creating decoder for request body with '%@' content encoding", header);
+      return NO;
+    }
     [_decoders addObject:decoder];
     _writer = decoder;
   }
+  return YES;
 }
 
 - (BOOL)performOpen:(NSError**)error {
@@ -280,6 +725,28 @@ NSString* const DZWebServerRequestAttribute_RegexCaptures = @"DZWebServerRequest
   [_attributes setValue:attribute forKey:key];
 }
 
+// Bytes are counted after decoding as that is what ends up in memory
+- (BOOL)reserveBufferedBodySize:(NSUInteger)size error:(NSError**)error {
+  if (_bufferingServer == nil) {
+    return YES;
+  }
+  if (![_bufferingServer reserveBufferedRequestBodySize:size]) {
+    if (error) {
+      *error = [NSError errorWithDomain:kDZWebServerErrorDomain code:kDZWebServerHTTPStatusCode_ServiceUnavailable userInfo:@{NSLocalizedDescriptionKey : @"Server request body memory budget exhausted"}];
+    }
+    return NO;
+  }
+  _bufferedBodySize += size;
+  return YES;
+}
+
+- (void)releaseBufferedBodySize {
+  if (_bufferedBodySize) {
+    [_bufferingServer releaseBufferedRequestBodySize:_bufferedBodySize];
+    _bufferedBodySize = 0;
+  }
+}
+
 - (NSString*)localAddressString {
   return DZWebServerStringFromSockAddr(_localAddressData.bytes, YES);
 }
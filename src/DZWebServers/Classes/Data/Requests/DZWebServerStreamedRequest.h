@@ -0,0 +1,83 @@
+/*
+ Copyright (c) 2012-2019, Pierre-Olivier Latour
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * The name of Pierre-Olivier Latour may not be used to endorse
+ or promote products derived from this software without specific
+ prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL PIERRE-OLIVIER LATOUR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "DZWebServerRequest.h"
+#import "DZWebServerResponse.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ *  @brief A request subclass that lets the handler read the HTTP body while it
+ *  is being received.
+ *
+ *  @discussion Other request classes receive the entire body before the handler
+ *  is called. When a match block returns a DZWebServerStreamedRequest, the
+ *  connection calls the handler as soon as the headers have been parsed and
+ *  validated, and only reads the body from the socket when the handler asks for
+ *  it with @c -readDataWithCompletion:. A slow consumer therefore applies
+ *  backpressure all the way to the client, and proxying, hashing or transcoding
+ *  an upload runs in constant memory.
+ *
+ *  The body is decoded according to its @c Content-Encoding and checked against
+ *  the body size limits as it is read. The handler may keep reading after
+ *  calling its completion block, for instance from the stream block of a
+ *  DZWebServerStreamedResponse to pass the body through:
+ *
+ *  @code
+ *  [server addHandlerForMethod:@"POST" path:@"/echo" requestClass:[DZWebServerStreamedRequest class] asyncProcessBlock:^(DZWebServerStreamedRequest* request, DZWebServerCompletionBlock completionBlock) {
+ *    completionBlock([DZWebServerStreamedResponse responseWithContentType:request.contentType asyncStreamBlock:^(DZWebServerBodyReaderCompletionBlock block) {
+ *      [request readDataWithCompletion:block];
+ *    }]);
+ *  }];
+ *  @endcode
+ *
+ *  Any part of the body left unread once the response has been sent is
+ *  discarded with the connection.
+ *
+ *  @see DZWebServerStreamedResponse
+ */
+@interface DZWebServerStreamedRequest : DZWebServerRequest
+
+/**
+ *  @brief Reads the next part of the request body.
+ *
+ *  @discussion Returns data already decoded but not yet consumed, or reads more
+ *  from the socket. Only one read may be outstanding at a time: do not call this
+ *  method again before @a block has been called.
+ *
+ *  @param block Called exactly once on an arbitrary GCD thread with a non-empty
+ *               @c NSData, an empty @c NSData once the whole body has been read
+ *               (immediately if the request has no body), or @c nil and an
+ *               @c NSError if the body could not be received. Errors caused by
+ *               the body size limits use the @c 413 and @c 503 status codes as
+ *               their error code.
+ */
+- (void)readDataWithCompletion:(DZWebServerBodyReaderCompletionBlock)block NS_SWIFT_DISABLE_ASYNC;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,79 @@
+/*
+ Copyright (c) 2012-2019, Pierre-Olivier Latour
+ All rights reserved.
+ 
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+ * The name of Pierre-Olivier Latour may not be used to endorse
+ or promote products derived from this software without specific
+ prior written permission.
+ 
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL PIERRE-OLIVIER LATOUR BE LIABLE FOR ANY
+ DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#if !__has_feature(objc_arc)
+#error DZWebServer requires ARC
+#endif
+
+#import "DZWebServerPrivate.h"
+
+@implementation DZWebServerStreamedRequest {
+  NSMutableData* _pendingData;
+  BOOL _finished;
+}
+
+- (BOOL)open:(NSError**)error {
+  _pendingData = [[NSMutableData alloc] init];
+  return YES;
+}
+
+- (BOOL)writeData:(NSData*)data error:(NSError**)error {
+  [_pendingData appendData:data];
+  return YES;
+}
+
+- (BOOL)close:(NSError**)error {
+  return YES;
+}
+
+- (void)readDataWithCompletion:(DZWebServerBodyReaderCompletionBlock)block {
+  if (_pendingData.length) {
+    NSData* data = _pendingData;
+    _pendingData = [[NSMutableData alloc] init];
+    block(data, nil);
+    return;
+  }
+  if (_finished || ![self hasBody]) {
+    block([NSData data], nil);
+    return;
+  }
+  DZWebServerBodyPullBlock pullBlock = self.bodyPullBlock;
+  if (pullBlock == nil) {
+    block(nil, [NSError errorWithDomain:kDZWebServerErrorDomain code:-1 userInfo:@{NSLocalizedDescriptionKey : @"Request body is no longer available"}]);
+    return;
+  }
+  pullBlock(^(BOOL finished, NSError* error) {
+    if (error) {
+      block(nil, error);
+    } else {
+      self->_finished = finished;
+      [self readDataWithCompletion:block];  // Decoders may need several reads before producing data
+    }
+  });
+}
+
+@end
@@ -63,6 +63,10 @@
   return data;
 }
 
+- (void)computeETag {
+  self.eTag = [NSString stringWithFormat:@"\"%016llx\"", DZWebServerComputeHash64(_data.bytes, _data.length)];
+}
+
 - (NSString*)description {
   NSMutableString* description = [NSMutableString stringWithString:[super description]];
   [description appendString:@"\n\n"];
@@ -72,6 +76,56 @@
 
 @end
 
+@implementation DZWebServerPrebuiltResponse {
+  DZWebServerPrebuiltResponse* _prototype;
+  NSData* _body;
+  NSData* _headerData;
+}
+
+- (instancetype)initWithData:(NSData*)data contentType:(NSString*)type cacheAge:(NSUInteger)cacheAge {
+  if ((self = [self initWithData:data contentType:type])) {
+    _body = data;
+    self.cacheControlMaxAge = cacheAge;
+    [self computeETag];
+
+    CFHTTPMessageRef message = CFHTTPMessageCreateResponse(kCFAllocatorDefault, kDZWebServerHTTPStatusCode_OK, NULL, kCFHTTPVersion1_1);
+    CFHTTPMessageSetHeaderFieldValue(message, CFSTR("Connection"), CFSTR("Close"));
+    CFHTTPMessageSetHeaderFieldValue(message, CFSTR("ETag"), (__bridge CFStringRef)self.eTag);
+    if (cacheAge > 0) {
+      CFHTTPMessageSetHeaderFieldValue(message, CFSTR("Cache-Control"), (__bridge CFStringRef)[NSString stringWithFormat:@"max-age=%i, public", (int)cacheAge]);
+    } else {
+      CFHTTPMessageSetHeaderFieldValue(message, CFSTR("Cache-Control"), CFSTR("no-cache"));
+    }
+    CFHTTPMessageSetHeaderFieldValue(message, CFSTR("Content-Type"), (__bridge CFStringRef)DZWebServerNormalizeHeaderValue(type));
+    CFHTTPMessageSetHeaderFieldValue(message, CFSTR("Content-Length"), (__bridge CFStringRef)[NSString stringWithFormat:@"%lu", (unsigned long)data.length]);
+    CFDataRef serializedData = CFHTTPMessageCopySerializedMessage(message);
+    NSData* headerData = (__bridge NSData*)serializedData;
+    DWS_DCHECK(headerData.length >= 2);
+    _headerData = [headerData subdataWithRange:NSMakeRange(0, headerData.length - 2)];  // Strip the empty line ending the headers so more can be appended
+    CFRelease(serializedData);
+    CFRelease(message);
+  }
+  return self;
+}
+
+- (instancetype)initWithPrebuiltResponse:(DZWebServerPrebuiltResponse*)response {
+  if ((self = [self initWithData:response.body contentType:(NSString*)response.contentType])) {
+    _prototype = response;
+    _body = response.body;
+    _headerData = response.headerData;
+    self.cacheControlMaxAge = response.cacheControlMaxAge;
+    self.eTag = response.eTag;
+  }
+  return self;
+}
+
+- (BOOL)isPristine {
+  DZWebServerPrebuiltResponse* prototype = _prototype ? _prototype : self;
+  return (self.statusCode == kDZWebServerHTTPStatusCode_OK) && (self.cacheControlMaxAge == prototype.cacheControlMaxAge) && [self.contentType isEqualToString:(NSString*)prototype.contentType] && (self.contentLength == _body.length) && [self.eTag isEqualToString:(NSString*)prototype.eTag] && (self.lastModifiedDate == nil) && (self.contentEncoding == nil) && !self.gzipContentEncodingEnabled && !self.automaticContentEncodingEnabled && !self.metadataOnly && (self.additionalHeaders.count == 0);
+}
+
+@end
+
 @implementation DZWebServerDataResponse (Extensions)
 
 + (instancetype)responseWithText:(NSString*)text {
@@ -29,8 +29,44 @@
 #error DZWebServer requires ARC
 #endif
 
+#import <os/lock.h>
+
 #import "DZWebServerPrivate.h"
 
+static os_unfair_lock _htmlPrefixLock = OS_UNFAIR_LOCK_INIT;
+static NSMutableDictionary<NSNumber*, NSData*>* _htmlPrefixes = nil;
+
+// Only messages with format specifiers need to go through the formatting machinery
+static inline NSString* _FormatMessage(NSString* format, va_list arguments) {
+  return ([format rangeOfString:@"%"].location == NSNotFound) ? format : [[NSString alloc] initWithFormat:format arguments:arguments];
+}
+
+// The HTML document up to the message only depends on the status code so it is rendered once
+static NSData* _HTMLPrefixForStatusCode(NSInteger statusCode) {
+  NSNumber* key = [NSNumber numberWithInteger:statusCode];
+  os_unfair_lock_lock(&_htmlPrefixLock);
+  NSData* prefix = [_htmlPrefixes objectForKey:key];
+  os_unfair_lock_unlock(&_htmlPrefixLock);
+  if (prefix == nil) {
+    NSString* title = [NSString stringWithFormat:@"HTTP Error %i", (int)statusCode];
+    prefix = [[NSString stringWithFormat:@"<!DOCTYPE html><html lang=\"en\"><head><meta charset=\"utf-8\"><title>%@</title></head><body><h1>%@: ", title, title] dataUsingEncoding:NSUTF8StringEncoding];
+    os_unfair_lock_lock(&_htmlPrefixLock);
+    if (_htmlPrefixes == nil) {
+      _htmlPrefixes = [[NSMutableDictionary alloc] init];
+    }
+    [_htmlPrefixes setObject:(NSData*)prefix forKey:key];
+    os_unfair_lock_unlock(&_htmlPrefixLock);
+  }
+  return (NSData*)prefix;
+}
+
+static inline void _AppendUTF8String(NSMutableData* data, NSString* string) {
+  const char* utf8String = string.UTF8String;
+  if (utf8String) {
+    [data appendBytes:utf8String length:strlen(utf8String)];
+  }
+}
+
 @implementation DZWebServerErrorResponse
 
 #pragma mark Public (Factory — Swift-friendly)
@@ -58,7 +94,7 @@
 + (instancetype)responseWithClientError:(DZWebServerClientErrorHTTPStatusCode)errorCode message:(NSString*)format, ... {
   va_list arguments;
   va_start(arguments, format);
-  NSString* message = [[NSString alloc] initWithFormat:format arguments:arguments];
+  NSString* message = _FormatMessage(format, arguments);
   va_end(arguments);
   return [self responseWithClientError:errorCode formattedMessage:message];
 }
@@ -66,7 +102,7 @@
 + (instancetype)responseWithServerError:(DZWebServerServerErrorHTTPStatusCode)errorCode message:(NSString*)format, ... {
   va_list arguments;
   va_start(arguments, format);
-  NSString* message = [[NSString alloc] initWithFormat:format arguments:arguments];
+  NSString* message = _FormatMessage(format, arguments);
   va_end(arguments);
   return [self responseWithServerError:errorCode formattedMessage:message];
 }
@@ -74,7 +110,7 @@
 + (instancetype)responseWithClientError:(DZWebServerClientErrorHTTPStatusCode)errorCode underlyingError:(NSError*)underlyingError message:(NSString*)format, ... {
   va_list arguments;
   va_start(arguments, format);
-  NSString* message = [[NSString alloc] initWithFormat:format arguments:arguments];
+  NSString* message = _FormatMessage(format, arguments);
   va_end(arguments);
   return [self responseWithClientError:errorCode underlyingError:underlyingError formattedMessage:message];
 }
@@ -82,7 +118,7 @@
 + (instancetype)responseWithServerError:(DZWebServerServerErrorHTTPStatusCode)errorCode underlyingError:(NSError*)underlyingError message:(NSString*)format, ... {
   va_list arguments;
   va_start(arguments, format);
-  NSString* message = [[NSString alloc] initWithFormat:format arguments:arguments];
+  NSString* message = _FormatMessage(format, arguments);
   va_end(arguments);
   return [self responseWithServerError:errorCode underlyingError:underlyingError formattedMessage:message];
 }
@@ -95,11 +131,14 @@ static inline NSString* _EscapeHTMLString(NSString* string) {
 }
 
 - (instancetype)initWithStatusCode:(NSInteger)statusCode underlyingError:(NSError*)underlyingError formattedMessage:(NSString*)message {
-  NSString* title = [NSString stringWithFormat:@"HTTP Error %i", (int)statusCode];
-  NSString* error = underlyingError ? [NSString stringWithFormat:@"[%@] %@ (%li)", underlyingError.domain, _EscapeHTMLString(underlyingError.localizedDescription), (long)underlyingError.code] : @"";
-  NSString* html = [NSString stringWithFormat:@"<!DOCTYPE html><html lang=\"en\"><head><meta charset=\"utf-8\"><title>%@</title></head><body><h1>%@: %@</h1><h3>%@</h3></body></html>",
-                                              title, title, _EscapeHTMLString(message), error];
-  if ((self = [self initWithHTML:html])) {
+  NSMutableData* html = [NSMutableData dataWithData:_HTMLPrefixForStatusCode(statusCode)];
+  _AppendUTF8String(html, _EscapeHTMLString(message));
+  [html appendBytes:"</h1><h3>" length:9];
+  if (underlyingError) {
+    _AppendUTF8String(html, [NSString stringWithFormat:@"[%@] %@ (%li)", underlyingError.domain, _EscapeHTMLString(underlyingError.localizedDescription), (long)underlyingError.code]);
+  }
+  [html appendBytes:"</h3></body></html>" length:19];
+  if ((self = [self initWithData:html contentType:@"text/html; charset=utf-8"])) {
     self.statusCode = statusCode;
   }
   return self;
@@ -131,7 +170,7 @@ static inline NSString* _EscapeHTMLString(NSString* string) {
 - (instancetype)initWithClientError:(DZWebServerClientErrorHTTPStatusCode)errorCode message:(NSString*)format, ... {
   va_list arguments;
   va_start(arguments, format);
-  NSString* message = [[NSString alloc] initWithFormat:format arguments:arguments];
+  NSString* message = _FormatMessage(format, arguments);
   va_end(arguments);
   return [self initWithClientError:errorCode formattedMessage:message];
 }
@@ -139,7 +178,7 @@ static inline NSString* _EscapeHTMLString(NSString* string) {
 - (instancetype)initWithServerError:(DZWebServerServerErrorHTTPStatusCode)errorCode message:(NSString*)format, ... {
   va_list arguments;
   va_start(arguments, format);
-  NSString* message = [[NSString alloc] initWithFormat:format arguments:arguments];
+  NSString* message = _FormatMessage(format, arguments);
   va_end(arguments);
   return [self initWithServerError:errorCode formattedMessage:message];
 }
@@ -147,7 +186,7 @@ static inline NSString* _EscapeHTMLString(NSString* string) {
 - (instancetype)initWithClientError:(DZWebServerClientErrorHTTPStatusCode)errorCode underlyingError:(NSError*)underlyingError message:(NSString*)format, ... {
   va_list arguments;
   va_start(arguments, format);
-  NSString* message = [[NSString alloc] initWithFormat:format arguments:arguments];
+  NSString* message = _FormatMessage(format, arguments);
   va_end(arguments);
   return [self initWithClientError:errorCode underlyingError:underlyingError formattedMessage:message];
 }
@@ -155,7 +194,7 @@ static inline NSString* _EscapeHTMLString(NSString* string) {
 - (instancetype)initWithServerError:(DZWebServerServerErrorHTTPStatusCode)errorCode underlyingError:(NSError*)underlyingError message:(NSString*)format, ... {
   va_list arguments;
   va_start(arguments, format);
-  NSString* message = [[NSString alloc] initWithFormat:format arguments:arguments];
+  NSString* message = _FormatMessage(format, arguments);
   va_end(arguments);
   return [self initWithServerError:errorCode underlyingError:underlyingError formattedMessage:message];
 }
@@ -27,6 +27,8 @@
 
 #import "DZWebServerResponse.h"
 
+@class DZWebServerRequest;
+
 NS_ASSUME_NONNULL_BEGIN
 
 /**
@@ -50,14 +52,17 @@ NS_ASSUME_NONNULL_BEGIN
  *
  *  When a byte range is provided, the response automatically sets the HTTP status
  *  code to @c 206 (Partial Content) and includes the appropriate @c Content-Range
- *  header.
+ *  header. When several byte ranges remain after overlapping and nearby ones are
+ *  merged, the body is streamed as @c multipart/byteranges. When no requested
+ *  range overlaps the file, the response has status @c 416 (Range Not
+ *  Satisfiable), a @c Content-Range: @c bytes @c * /length header and no body.
  *
  *  The file is opened for reading only when the connection calls @c -open: and is
  *  read incrementally in 32 KB chunks via @c -readData: to keep memory usage low,
  *  even for very large files. Symbolic links are not followed when opening the file.
  *
- *  @note Initialization returns @c nil if the file does not exist, is not a regular
- *  file, or if the requested byte range resolves to zero bytes.
+ *  @note Initialization returns @c nil if the file does not exist or is not a
+ *  regular file.
  *
  *  @see DZWebServerResponse
  *  @see DZWebServerRequest
@@ -157,8 +162,8 @@ NS_ASSUME_NONNULL_BEGIN
  *               full file, @c NSMakeRange(offset, length) for a range from the beginning,
  *               or @c NSMakeRange(NSUIntegerMax, length) for a range from the end.
  *
- *  @return A new file response, or @c nil if the file does not exist, is not a
- *  regular file, or the resolved byte range has zero length.
+ *  @return A new file response, or @c nil if the file does not exist or is not a
+ *  regular file.
  *
  *  @see -initWithFile:byteRange:
  */
@@ -168,8 +173,8 @@ NS_ASSUME_NONNULL_BEGIN
  *  @brief Creates a response with a byte range of a file's contents, optionally as a download attachment.
  *
  *  @discussion This is a convenience factory method that combines byte-range serving
- *  with the @c Content-Disposition attachment header. Equivalent to calling the
- *  designated initializer with @c nil MIME type overrides.
+ *  with the @c Content-Disposition attachment header. Equivalent to calling
+ *  @c -initWithFile:byteRange:isAttachment:mimeTypeOverrides: with @c nil MIME type overrides.
  *
  *  @param path       The absolute path to the file on disk.
  *  @param range      The byte range to serve. See @c -initWithFile:byteRange: for the
@@ -178,19 +183,37 @@ NS_ASSUME_NONNULL_BEGIN
  *                    @c "attachment" with the file's name. If @c NO, no such header
  *                    is added.
  *
- *  @return A new file response, or @c nil if the file does not exist, is not a
- *  regular file, or the resolved byte range has zero length.
+ *  @return A new file response, or @c nil if the file does not exist or is not a
+ *  regular file.
  *
  *  @see -initWithFile:byteRange:isAttachment:mimeTypeOverrides:
  */
 + (nullable instancetype)responseWithFile:(NSString*)path byteRange:(NSRange)range isAttachment:(BOOL)attachment;
 
+/**
+ *  @brief Creates a response with one or more byte ranges of a file's contents.
+ *
+ *  @discussion This is a convenience factory method equivalent to calling
+ *  @c -initWithFile:byteRanges:isAttachment:mimeTypeOverrides:precompressedVariantsForRequest:
+ *  with @c nil MIME type overrides and no precompressed variants.
+ *
+ *  @param path       The absolute path to the file on disk.
+ *  @param ranges     The byte ranges to serve, typically @c DZWebServerRequest.byteRanges,
+ *                    or @c nil for the full file.
+ *  @param attachment If @c YES, the @c Content-Disposition header is set to
+ *                    @c "attachment" with the file's name.
+ *
+ *  @return A new file response, or @c nil if the file does not exist or is not a
+ *  regular file.
+ */
++ (nullable instancetype)responseWithFile:(NSString*)path byteRanges:(nullable NSArray<NSValue*>*)ranges isAttachment:(BOOL)attachment;
+
 /**
  *  @brief Initializes a response with the full contents of a file.
  *
- *  @discussion Equivalent to calling the designated initializer with a byte range
- *  of @c NSMakeRange(NSUIntegerMax, 0) (full file), @a attachment set to @c NO,
- *  and @c nil MIME type overrides.
+ *  @discussion Equivalent to calling @c -initWithFile:byteRange:isAttachment:mimeTypeOverrides:
+ *  with a byte range of @c NSMakeRange(NSUIntegerMax, 0) (full file), @a attachment
+ *  set to @c NO, and @c nil MIME type overrides.
  *
  *  @param path The absolute path to the file on disk.
  *
@@ -204,9 +227,9 @@ NS_ASSUME_NONNULL_BEGIN
 /**
  *  @brief Initializes a response with the full contents of a file, optionally as a download attachment.
  *
- *  @discussion Equivalent to calling the designated initializer with a byte range
- *  of @c NSMakeRange(NSUIntegerMax, 0) (full file), the given @a attachment flag,
- *  and @c nil MIME type overrides.
+ *  @discussion Equivalent to calling @c -initWithFile:byteRange:isAttachment:mimeTypeOverrides:
+ *  with a byte range of @c NSMakeRange(NSUIntegerMax, 0) (full file), the given
+ *  @a attachment flag, and @c nil MIME type overrides.
  *
  *  @param path       The absolute path to the file on disk.
  *  @param attachment If @c YES, the @c Content-Disposition header is set to
@@ -223,8 +246,9 @@ NS_ASSUME_NONNULL_BEGIN
 /**
  *  @brief Initializes a response with a specific byte range of a file's contents.
  *
- *  @discussion Equivalent to calling the designated initializer with the given
- *  @a path and @a range, @a attachment set to @c NO, and @c nil MIME type overrides.
+ *  @discussion Equivalent to calling @c -initWithFile:byteRange:isAttachment:mimeTypeOverrides:
+ *  with the given @a path and @a range, @a attachment set to @c NO, and @c nil MIME
+ *  type overrides.
  *
  *  The @a range parameter encodes the desired byte range using the following conventions:
  *
@@ -243,8 +267,9 @@ NS_ASSUME_NONNULL_BEGIN
  *  @param path  The absolute path to the file on disk.
  *  @param range The byte range to serve, encoded as described above.
  *
- *  @return An initialized file response, or @c nil if the file does not exist,
- *  is not a regular file, or the resolved byte range has zero length.
+ *  @return An initialized file response, or @c nil if the file does not exist
+ *  or is not a regular file. A range starting beyond the end of the file yields
+ *  a @c 416 response.
  *
  *  @see -initWithFile:byteRange:isAttachment:mimeTypeOverrides:
  *  @see DZWebServerRequest.byteRange
@@ -252,11 +277,11 @@ NS_ASSUME_NONNULL_BEGIN
 - (nullable instancetype)initWithFile:(NSString*)path byteRange:(NSRange)range;
 
 /**
- *  @brief Designated initializer. Creates a response from a file with full control over
- *  byte range, attachment disposition, and MIME type mapping.
+ *  @brief Creates a response from a file with full control over byte range,
+ *  attachment disposition, and MIME type mapping.
  *
- *  @discussion This is the designated initializer for @c DZWebServerFileResponse.
- *  All other initializers and factory methods ultimately call this method.
+ *  @discussion Equivalent to calling the designated initializer with @a range as
+ *  the only byte range and no request, so precompressed variants are never used.
  *
  *  The initializer performs the following steps:
  *
@@ -284,8 +309,7 @@ NS_ASSUME_NONNULL_BEGIN
  *                    extension-to-MIME-type mapping. Pass @c nil to use the defaults.
  *
  *  @return An initialized file response, or @c nil if the file does not exist, is not a
- *  regular file, exceeds 4 GiB on 32-bit platforms, or the resolved byte range has zero
- *  length.
+ *  regular file, or exceeds 4 GiB on 32-bit platforms.
  *
  *  @warning On 32-bit platforms, files larger than 4 GiB are not supported and will
  *  cause initialization to return @c nil.
@@ -294,7 +318,85 @@ NS_ASSUME_NONNULL_BEGIN
  *  @see -initWithFile:byteRange:
  *  @see DZWebServerGetMimeTypeForExtension
  */
-- (nullable instancetype)initWithFile:(NSString*)path byteRange:(NSRange)range isAttachment:(BOOL)attachment mimeTypeOverrides:(nullable NSDictionary<NSString*, NSString*>*)overrides NS_DESIGNATED_INITIALIZER;
+- (nullable instancetype)initWithFile:(NSString*)path byteRange:(NSRange)range isAttachment:(BOOL)attachment mimeTypeOverrides:(nullable NSDictionary<NSString*, NSString*>*)overrides;
+
+/**
+ *  @brief Initializes a response from a file, serving a precompressed sibling
+ *  file instead when the client accepts its content encoding.
+ *
+ *  @discussion Behaves like @c -initWithFile:byteRange:isAttachment:mimeTypeOverrides:
+ *  but first looks for precompressed variants of @a path built ahead of time
+ *  (e.g., by an asset pipeline) next to the original file:
+ *
+ *  - @c path.br -- served with @c Content-Encoding: @c br
+ *  - @c path.zst -- served with @c Content-Encoding: @c zstd
+ *  - @c path.gz -- served with @c Content-Encoding: @c gzip
+ *
+ *  Candidates are tried in the order of the quality values of the request's
+ *  @c Accept-Encoding header, ties being resolved in the order above. A variant
+ *  is ignored if it is not a regular file or if it is older than the original
+ *  file. No variant is used if the request has no @c Accept-Encoding header.
+ *
+ *  When a variant is used, @c contentType and the @c Content-Disposition file
+ *  name still come from the original file, while @c contentLength,
+ *  @c lastModifiedDate, @c eTag and @a range refer to the variant, so byte
+ *  ranges are served from the encoded bytes as required by HTTP. A
+ *  @c Vary: @c Accept-Encoding header is always added when @a request is not
+ *  @c nil.
+ *
+ *  @param path       The absolute path to the original file on disk.
+ *  @param range      The byte range to serve. See @c -initWithFile:byteRange: for the
+ *                    range encoding conventions.
+ *  @param attachment If @c YES, the @c Content-Disposition header is set to @c "attachment"
+ *                    with the original file's name.
+ *  @param overrides  An optional dictionary of extension to MIME type overrides.
+ *  @param request    The request whose @c Accept-Encoding header drives the selection,
+ *                    or @c nil to always serve the original file.
+ *
+ *  @return An initialized file response, or @c nil under the same conditions as
+ *  the designated initializer.
+ *
+ *  @see DZWebServerRequest.preferredContentEncodingFromEncodings:
+ */
+- (nullable instancetype)initWithFile:(NSString*)path byteRange:(NSRange)range isAttachment:(BOOL)attachment mimeTypeOverrides:(nullable NSDictionary<NSString*, NSString*>*)overrides precompressedVariantsForRequest:(nullable DZWebServerRequest*)request
+    NS_SWIFT_NAME(init(file:byteRange:isAttachment:mimeTypeOverrides:precompressedVariantsFor:));
+
+/**
+ *  @brief Designated initializer. Initializes a response serving one or more
+ *  byte ranges of a file, optionally from a precompressed sibling file.
+ *
+ *  @discussion Behaves like
+ *  @c -initWithFile:byteRange:isAttachment:mimeTypeOverrides:precompressedVariantsForRequest:
+ *  for a list of ranges, each encoded with the conventions of
+ *  @c -initWithFile:byteRange: . Ranges are clamped to the file size, ranges
+ *  starting beyond its end are dropped, and the remaining ones are sorted and
+ *  merged when they overlap or are separated by less than the overhead of a
+ *  multipart part header.
+ *
+ *  - A single remaining range is served as a regular @c 206 response with a
+ *    @c Content-Range header.
+ *  - Several remaining ranges are served as a @c 206 response with a
+ *    @c multipart/byteranges body, streamed part by part from the file with a
+ *    known @c Content-Length.
+ *  - If no range remains, the response has status @c 416, a
+ *    @c Content-Range: @c bytes @c * /length header and no body.
+ *
+ *  @param path       The absolute path to the original file on disk.
+ *  @param ranges     The byte ranges to serve, typically @c DZWebServerRequest.byteRanges,
+ *                    or @c nil for the full file.
+ *  @param attachment If @c YES, the @c Content-Disposition header is set to @c "attachment"
+ *                    with the original file's name.
+ *  @param overrides  An optional dictionary of extension to MIME type overrides.
+ *  @param request    The request whose @c Accept-Encoding header drives the selection
+ *                    of a precompressed variant, or @c nil to always serve the original file.
+ *
+ *  @return An initialized file response, or @c nil if the file does not exist, is not a
+ *  regular file, or exceeds 4 GiB on 32-bit platforms.
+ *
+ *  @see DZWebServerRequest.byteRanges
+ */
+- (nullable instancetype)initWithFile:(NSString*)path byteRanges:(nullable NSArray<NSValue*>*)ranges isAttachment:(BOOL)attachment mimeTypeOverrides:(nullable NSDictionary<NSString*, NSString*>*)overrides precompressedVariantsForRequest:(nullable DZWebServerRequest*)request
+    NS_SWIFT_NAME(init(file:byteRanges:isAttachment:mimeTypeOverrides:precompressedVariantsFor:)) NS_DESIGNATED_INITIALIZER;
 
 @end
 
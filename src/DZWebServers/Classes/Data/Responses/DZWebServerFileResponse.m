@@ -34,12 +34,30 @@
 #import "DZWebServerPrivate.h"
 
 #define kFileReadBufferSize (32 * 1024)
+#define kByteRangesCoalescingGap 80  // Ranges separated by less than the overhead of a part header are sent as one part
+
+// Content codings for precompressed sibling files in server preference order
+static const struct {
+  const char* encoding;
+  const char* extension;
+} _precompressedVariants[] = {
+    {"br", "br"},
+    {"zstd", "zst"},
+    {"gzip", "gz"},
+};
 
 @implementation DZWebServerFileResponse {
   NSString* _path;
+  DZWebServerCachedFile* _file;
   NSUInteger _offset;
   NSUInteger _size;
-  int _file;
+  NSUInteger _fileSize;
+  NSString* _mimeType;
+  NSArray<NSValue*>* _partRanges;  // Only set for multipart/byteranges responses
+  NSArray<NSData*>* _partHeaders;
+  NSData* _partsTrailer;
+  NSUInteger _partIndex;
+  BOOL _readingPart;
 }
 
 @dynamic contentType, lastModifiedDate, eTag;
@@ -60,6 +78,10 @@
   return [(DZWebServerFileResponse*)[[self class] alloc] initWithFile:path byteRange:range isAttachment:attachment mimeTypeOverrides:nil];
 }
 
++ (instancetype)responseWithFile:(NSString*)path byteRanges:(NSArray<NSValue*>*)ranges isAttachment:(BOOL)attachment {
+  return [(DZWebServerFileResponse*)[[self class] alloc] initWithFile:path byteRanges:ranges isAttachment:attachment mimeTypeOverrides:nil precompressedVariantsForRequest:nil];
+}
+
 - (instancetype)initWithFile:(NSString*)path {
   return [self initWithFile:path byteRange:NSMakeRange(NSUIntegerMax, 0) isAttachment:NO mimeTypeOverrides:nil];
 }
@@ -72,93 +94,251 @@
   return [self initWithFile:path byteRange:range isAttachment:NO mimeTypeOverrides:nil];
 }
 
+static inline NSArray<NSValue*>* _ByteRangesFromByteRange(NSRange range) {
+  return DZWebServerIsValidByteRange(range) ? @[ [NSValue valueWithRange:range] ] : nil;
+}
+
+// Clamps ranges to the file size, drops unsatisfiable ones and merges the ones that overlap or are close together
+static NSArray<NSValue*>* _ResolveByteRanges(NSArray<NSValue*>* ranges, NSUInteger fileSize) {
+  NSMutableArray<NSValue*>* resolvedRanges = [[NSMutableArray alloc] initWithCapacity:ranges.count];
+  for (NSValue* value in ranges) {
+    NSRange range = value.rangeValue;
+    if (range.location != NSUIntegerMax) {
+      if (range.location >= fileSize) {
+        continue;
+      }
+      range.length = MIN(range.length, fileSize - range.location);
+    } else {
+      range.length = MIN(range.length, fileSize);
+      range.location = fileSize - range.length;
+    }
+    if (range.length) {
+      [resolvedRanges addObject:[NSValue valueWithRange:range]];
+    }
+  }
+  if (resolvedRanges.count < 2) {
+    return resolvedRanges;
+  }
+  [resolvedRanges sortUsingComparator:^NSComparisonResult(NSValue* value1, NSValue* value2) {
+    NSUInteger location1 = value1.rangeValue.location;
+    NSUInteger location2 = value2.rangeValue.location;
+    return location1 < location2 ? NSOrderedAscending : (location1 > location2 ? NSOrderedDescending : NSOrderedSame);
+  }];
+  NSMutableArray<NSValue*>* coalescedRanges = [[NSMutableArray alloc] initWithCapacity:resolvedRanges.count];
+  NSRange currentRange = resolvedRanges.firstObject.rangeValue;
+  for (NSUInteger i = 1; i < resolvedRanges.count; ++i) {
+    NSRange range = [resolvedRanges objectAtIndex:i].rangeValue;
+    if (range.location <= NSMaxRange(currentRange) + kByteRangesCoalescingGap) {
+      currentRange.length = MAX(NSMaxRange(currentRange), NSMaxRange(range)) - currentRange.location;
+    } else {
+      [coalescedRanges addObject:[NSValue valueWithRange:currentRange]];
+      currentRange = range;
+    }
+  }
+  [coalescedRanges addObject:[NSValue valueWithRange:currentRange]];
+  return coalescedRanges;
+}
+
 static inline NSDate* _NSDateFromTimeSpec(const struct timespec* t) {
   return [NSDate dateWithTimeIntervalSince1970:((NSTimeInterval)t->tv_sec + (NSTimeInterval)t->tv_nsec / 1000000000.0)];
 }
 
+static inline NSString* _ETagFromFileInfo(const struct stat* info) {
+  return [NSString stringWithFormat:@"%llu/%li/%li", info->st_ino, info->st_mtimespec.tv_sec, info->st_mtimespec.tv_nsec];
+}
+
 - (instancetype)initWithFile:(NSString*)path byteRange:(NSRange)range isAttachment:(BOOL)attachment mimeTypeOverrides:(NSDictionary<NSString*, NSString*>*)overrides {
-  struct stat info;
-  if (lstat([path fileSystemRepresentation], &info) || !(info.st_mode & S_IFREG)) {
+  return [self initWithFile:path byteRanges:_ByteRangesFromByteRange(range) isAttachment:attachment mimeTypeOverrides:overrides precompressedVariantsForRequest:nil];
+}
+
+- (instancetype)initWithFile:(NSString*)path byteRange:(NSRange)range isAttachment:(BOOL)attachment mimeTypeOverrides:(NSDictionary<NSString*, NSString*>*)overrides precompressedVariantsForRequest:(DZWebServerRequest*)request {
+  return [self initWithFile:path byteRanges:_ByteRangesFromByteRange(range) isAttachment:attachment mimeTypeOverrides:overrides precompressedVariantsForRequest:request];
+}
+
+- (instancetype)initWithFile:(NSString*)path byteRanges:(NSArray<NSValue*>*)ranges isAttachment:(BOOL)attachment mimeTypeOverrides:(NSDictionary<NSString*, NSString*>*)overrides precompressedVariantsForRequest:(DZWebServerRequest*)request {
+  DZWebServerCachedFile* file = [[DZWebServerFileDescriptorCache sharedCache] fileForPath:path];
+  if (file == nil) {
     DWS_DNOT_REACHED();
     return nil;
   }
+  NSString* encoding = nil;
+  DZWebServerCachedFile* encodedFile = request ? [DZWebServerFileResponse precompressedFileForFile:file request:request contentEncoding:&encoding] : nil;
+  if ((self = [super init])) {
+    if (![self _setUpWithCachedFile:file precompressedFile:encodedFile contentEncoding:encoding byteRanges:ranges isAttachment:attachment mimeTypeOverrides:overrides]) {
+      return nil;
+    }
+    if (request) {
+      [self setValue:@"Accept-Encoding" forAdditionalHeader:@"Vary"];
+    }
+  }
+  return self;
+}
+
++ (DZWebServerCachedFile*)precompressedFileForFile:(DZWebServerCachedFile*)file request:(DZWebServerRequest*)request contentEncoding:(NSString**)encoding {
+  if (!S_ISREG(file.info->st_mode)) {
+    return nil;
+  }
+  NSMutableArray<NSString*>* encodings = [[NSMutableArray alloc] init];
+  NSMutableDictionary<NSString*, NSString*>* extensions = [[NSMutableDictionary alloc] init];
+  for (size_t i = 0; i < sizeof(_precompressedVariants) / sizeof(_precompressedVariants[0]); ++i) {
+    NSString* variantEncoding = [NSString stringWithUTF8String:_precompressedVariants[i].encoding];
+    [encodings addObject:variantEncoding];
+    [extensions setObject:[NSString stringWithUTF8String:_precompressedVariants[i].extension] forKey:variantEncoding];
+  }
+  NSString* preferredEncoding;
+  while ((preferredEncoding = [request preferredContentEncodingFromEncodings:encodings])) {  // Try candidates from most to least preferred by the client
+    NSString* extension = [extensions objectForKey:preferredEncoding];
+    DZWebServerCachedFile* encodedFile = [[DZWebServerFileDescriptorCache sharedCache] fileForPath:[file.path stringByAppendingPathExtension:extension]];
+    if (encodedFile && S_ISREG(encodedFile.info->st_mode)) {
+      const struct timespec* encodedTime = &encodedFile.info->st_mtimespec;
+      const struct timespec* originalTime = &file.info->st_mtimespec;
+      if ((encodedTime->tv_sec > originalTime->tv_sec) || ((encodedTime->tv_sec == originalTime->tv_sec) && (encodedTime->tv_nsec >= originalTime->tv_nsec))) {
+        *encoding = preferredEncoding;
+        return encodedFile;
+      }
+      DWS_LOG_DEBUG(@"Ignoring precompressed file \"%@\" older than \"%@\"", encodedFile.path, file.path);
+    }
+    [encodings removeObject:preferredEncoding];
+  }
+  return nil;
+}
+
++ (DZWebServerResponse*)validatorResponseForFile:(NSString*)path {
+  DZWebServerCachedFile* file = [[DZWebServerFileDescriptorCache sharedCache] fileForPath:path];
+  if ((file == nil) || !S_ISREG(file.info->st_mode)) {
+    return nil;
+  }
+  DZWebServerResponse* response = [DZWebServerResponse response];
+  response.lastModifiedDate = _NSDateFromTimeSpec(&file.info->st_mtimespec);
+  response.eTag = _ETagFromFileInfo(file.info);
+  return response;
+}
+
+- (instancetype)initWithCachedFile:(DZWebServerCachedFile*)file precompressedFile:(DZWebServerCachedFile*)encodedFile contentEncoding:(NSString*)encoding byteRanges:(NSArray<NSValue*>*)ranges isAttachment:(BOOL)attachment mimeTypeOverrides:(NSDictionary<NSString*, NSString*>*)overrides {
+  if ((self = [super init])) {
+    if (![self _setUpWithCachedFile:file precompressedFile:encodedFile contentEncoding:encoding byteRanges:ranges isAttachment:attachment mimeTypeOverrides:overrides]) {
+      return nil;
+    }
+  }
+  return self;
+}
+
+- (BOOL)_setUpWithCachedFile:(DZWebServerCachedFile*)originalFile precompressedFile:(DZWebServerCachedFile*)encodedFile contentEncoding:(NSString*)encoding byteRanges:(NSArray<NSValue*>*)ranges isAttachment:(BOOL)attachment mimeTypeOverrides:(NSDictionary<NSString*, NSString*>*)overrides {
+  DZWebServerCachedFile* file = encodedFile ? encodedFile : originalFile;  // Name and MIME type come from the original file, everything else from the file actually served
+  NSString* path = originalFile.path;
+  struct stat info = *file.info;
+  if (!(info.st_mode & S_IFREG)) {
+    DWS_DNOT_REACHED();
+    return NO;
+  }
 #ifndef __LP64__
   if (info.st_size >= (off_t)4294967295) {  // In 32 bit mode, we can't handle files greater than 4 GiBs (don't use "NSUIntegerMax" here to avoid potential unsigned to signed conversion issues)
     DWS_DNOT_REACHED();
-    return nil;
+    return NO;
   }
 #endif
   NSUInteger fileSize = (NSUInteger)info.st_size;
+  NSString* mimeType = DZWebServerGetMimeTypeForExtension([path pathExtension], overrides);
+  NSString* contentType = mimeType;
 
-  BOOL hasByteRange = DZWebServerIsValidByteRange(range);
-  if (hasByteRange) {
-    if (range.location != NSUIntegerMax) {
-      range.location = MIN(range.location, fileSize);
-      range.length = MIN(range.length, fileSize - range.location);
-    } else {
-      range.length = MIN(range.length, fileSize);
-      range.location = fileSize - range.length;
-    }
-    if (range.length == 0) {
-      return nil;  // TODO: Return 416 status code and "Content-Range: bytes */{file length}" header
-    }
-  } else {
-    range.location = 0;
-    range.length = fileSize;
+  _path = [file.path copy];
+  _file = file;
+  _fileSize = fileSize;
+  _mimeType = mimeType;
+  self.lastModifiedDate = _NSDateFromTimeSpec(&info.st_mtimespec);
+  self.eTag = _ETagFromFileInfo(&info);
+
+  NSArray<NSValue*>* resolvedRanges = ranges ? _ResolveByteRanges(ranges, fileSize) : nil;
+  if (ranges && (resolvedRanges.count == 0)) {
+    [self setStatusCode:kDZWebServerHTTPStatusCode_RequestedRangeNotSatisfiable];
+    [self setValue:[NSString stringWithFormat:@"bytes */%lu", (unsigned long)fileSize] forAdditionalHeader:@"Content-Range"];
+    DWS_LOG_DEBUG(@"No satisfiable byte range for file \"%@\"", _path);
+    return YES;  // Response without body
   }
 
-  if ((self = [super init])) {
-    _path = [path copy];
+  if (resolvedRanges.count > 1) {
+    NSString* boundary = [[NSUUID UUID] UUIDString];
+    NSMutableArray<NSData*>* partHeaders = [[NSMutableArray alloc] initWithCapacity:resolvedRanges.count];
+    NSUInteger contentLength = 0;
+    for (NSValue* value in resolvedRanges) {
+      NSRange range = value.rangeValue;
+      NSString* partHeader = [NSString stringWithFormat:@"\r\n--%@\r\nContent-Type: %@\r\nContent-Range: bytes %lu-%lu/%lu\r\n\r\n", boundary, mimeType, (unsigned long)range.location, (unsigned long)(NSMaxRange(range) - 1), (unsigned long)fileSize];
+      NSData* data = [partHeader dataUsingEncoding:NSUTF8StringEncoding];
+      [partHeaders addObject:data];
+      contentLength += data.length + range.length;
+    }
+    _partRanges = resolvedRanges;
+    _partHeaders = partHeaders;
+    _partsTrailer = [[NSString stringWithFormat:@"\r\n--%@--\r\n", boundary] dataUsingEncoding:NSUTF8StringEncoding];
+    _size = contentLength + _partsTrailer.length;
+    contentType = [NSString stringWithFormat:@"multipart/byteranges; boundary=%@", boundary];
+    [self setStatusCode:kDZWebServerHTTPStatusCode_PartialContent];
+    DWS_LOG_DEBUG(@"Using %lu content byte ranges for file \"%@\"", (unsigned long)resolvedRanges.count, _path);
+  } else if (resolvedRanges.count == 1) {
+    NSRange range = resolvedRanges.firstObject.rangeValue;
     _offset = range.location;
     _size = range.length;
-    if (hasByteRange) {
-      [self setStatusCode:kDZWebServerHTTPStatusCode_PartialContent];
-      [self setValue:[NSString stringWithFormat:@"bytes %lu-%lu/%lu", (unsigned long)_offset, (unsigned long)(_offset + _size - 1), (unsigned long)fileSize] forAdditionalHeader:@"Content-Range"];
-      DWS_LOG_DEBUG(@"Using content bytes range [%lu-%lu] for file \"%@\"", (unsigned long)_offset, (unsigned long)(_offset + _size - 1), path);
-    }
+    [self setStatusCode:kDZWebServerHTTPStatusCode_PartialContent];
+    [self setValue:[NSString stringWithFormat:@"bytes %lu-%lu/%lu", (unsigned long)_offset, (unsigned long)(_offset + _size - 1), (unsigned long)fileSize] forAdditionalHeader:@"Content-Range"];
+    DWS_LOG_DEBUG(@"Using content bytes range [%lu-%lu] for file \"%@\"", (unsigned long)_offset, (unsigned long)(_offset + _size - 1), _path);
+  } else {
+    _offset = 0;
+    _size = fileSize;
+  }
+  if (encodedFile) {
+    [self setValue:encoding forAdditionalHeader:@"Content-Encoding"];
+    DWS_LOG_DEBUG(@"Using precompressed file \"%@\" with '%@' content encoding", _path, encoding);
+  }
 
-    if (attachment) {
-      NSString* fileName = [path lastPathComponent];
-      NSData* data = [[fileName stringByReplacingOccurrencesOfString:@"\"" withString:@""] dataUsingEncoding:NSISOLatin1StringEncoding allowLossyConversion:YES];
-      NSString* lossyFileName = data ? [[NSString alloc] initWithData:data encoding:NSISOLatin1StringEncoding] : nil;
-      if (lossyFileName) {
-        NSString* value = [NSString stringWithFormat:@"attachment; filename=\"%@\"; filename*=UTF-8''%@", lossyFileName, DZWebServerEscapeURLString(fileName)];
-        [self setValue:value forAdditionalHeader:@"Content-Disposition"];
-      } else {
-        DWS_DNOT_REACHED();
-      }
+  if (attachment) {
+    NSString* fileName = [path lastPathComponent];
+    NSData* data = [[fileName stringByReplacingOccurrencesOfString:@"\"" withString:@""] dataUsingEncoding:NSISOLatin1StringEncoding allowLossyConversion:YES];
+    NSString* lossyFileName = data ? [[NSString alloc] initWithData:data encoding:NSISOLatin1StringEncoding] : nil;
+    if (lossyFileName) {
+      NSString* value = [NSString stringWithFormat:@"attachment; filename=\"%@\"; filename*=UTF-8''%@", lossyFileName, DZWebServerEscapeURLString(fileName)];
+      [self setValue:value forAdditionalHeader:@"Content-Disposition"];
+    } else {
+      DWS_DNOT_REACHED();
     }
+  }
+
+  self.contentType = contentType;
+  self.contentLength = _size;
+  return YES;
+}
 
-    self.contentType = DZWebServerGetMimeTypeForExtension([_path pathExtension], overrides);
-    self.contentLength = _size;
-    self.lastModifiedDate = _NSDateFromTimeSpec(&info.st_mtimespec);
-    self.eTag = [NSString stringWithFormat:@"%llu/%li/%li", info.st_ino, info.st_mtimespec.tv_sec, info.st_mtimespec.tv_nsec];
+- (void)discardByteRanges {
+  if ((self.statusCode != kDZWebServerHTTPStatusCode_PartialContent) && (self.statusCode != kDZWebServerHTTPStatusCode_RequestedRangeNotSatisfiable)) {
+    return;
   }
-  return self;
+  _partRanges = nil;
+  _partHeaders = nil;
+  _partsTrailer = nil;
+  _partIndex = 0;
+  _readingPart = NO;
+  _offset = 0;
+  _size = _fileSize;
+  [self setValue:nil forAdditionalHeader:@"Content-Range"];
+  [self setStatusCode:kDZWebServerHTTPStatusCode_OK];
+  self.contentType = _mimeType;
+  self.contentLength = _size;
+  DWS_LOG_DEBUG(@"Discarded byte ranges for file \"%@\"", _path);
 }
 
 - (BOOL)open:(NSError**)error {
-  _file = open([_path fileSystemRepresentation], O_NOFOLLOW | O_RDONLY);
-  if (_file <= 0) {
+  if (_file.fileDescriptor <= 0) {  // The file descriptor is shared with concurrent responses for the same file so it must only be accessed through pread()
     if (error) {
-      *error = DZWebServerMakePosixError(errno);
+      *error = DZWebServerMakePosixError(_file.openError ? _file.openError : EBADF);
     }
     return NO;
   }
-  if (lseek(_file, _offset, SEEK_SET) != (off_t)_offset) {
-    if (error) {
-      *error = DZWebServerMakePosixError(errno);
-    }
-    close(_file);
-    return NO;
-  }
   return YES;
 }
 
-- (NSData*)readData:(NSError**)error {
+- (NSData*)_readFileData:(NSError**)error {
   size_t length = MIN((NSUInteger)kFileReadBufferSize, _size);
   NSMutableData* data = [[NSMutableData alloc] initWithLength:length];
-  ssize_t result = read(_file, data.mutableBytes, length);
+  ssize_t result = pread(_file.fileDescriptor, data.mutableBytes, length, _offset);
   if (result < 0) {
     if (error) {
       *error = DZWebServerMakePosixError(errno);
@@ -167,13 +347,40 @@ static inline NSDate* _NSDateFromTimeSpec(const struct timespec* t) {
   }
   if (result > 0) {
     [data setLength:result];
+    _offset += result;
     _size -= result;
+  } else {
+    [data setLength:0];
   }
   return data;
 }
 
+// Multipart bodies are streamed as part header, then file bytes, for each range before the closing boundary
+- (NSData*)readData:(NSError**)error {
+  if (_partRanges == nil) {
+    return [self _readFileData:error];
+  }
+  while (_partIndex < _partRanges.count) {
+    if (!_readingPart) {
+      NSRange range = [_partRanges objectAtIndex:_partIndex].rangeValue;
+      _offset = range.location;
+      _size = range.length;
+      _readingPart = YES;
+      return [_partHeaders objectAtIndex:_partIndex];
+    }
+    if (_size) {
+      return [self _readFileData:error];
+    }
+    _readingPart = NO;
+    _partIndex += 1;
+  }
+  NSData* trailer = _partsTrailer;
+  _partsTrailer = nil;
+  return trailer ? trailer : [NSData data];
+}
+
 - (void)close {
-  close(_file);
+  ;  // The file descriptor is owned by the shared cache
 }
 
 - (NSString*)description {
@@ -123,6 +123,25 @@ typedef void (^DZWebServerBodyReaderCompletionBlock)(NSData* _Nullable data, NSE
 
 @end
 
+/**
+ *  @brief A block that creates a content encoder for a response body.
+ *
+ *  The returned object is inserted in front of @a reader in the body reader
+ *  chain: its @c -open:, @c -readData: and @c -close methods must forward to
+ *  @a reader and return the encoded bytes. @a reader is guaranteed to outlive
+ *  the returned encoder, so it should be held without retaining it (e.g.,
+ *  @c __unsafe_unretained) to avoid a retain cycle with the response.
+ *
+ *  @param reader  The upstream body reader to pull unencoded data from.
+ *  @param options The options of the server sending the response, used to look
+ *                 up encoder settings such as compression levels. May be @c nil.
+ *  @return The encoder, or @c nil if it cannot be created, in which case the
+ *          body is sent unencoded.
+ *
+ *  @see +[DZWebServerResponse registerContentEncoding:withEncoderBlock:]
+ */
+typedef id<DZWebServerBodyReader> _Nullable (^DZWebServerContentEncoderBlock)(id<DZWebServerBodyReader> reader, NSDictionary<NSString*, id>* _Nullable options);
+
 /**
  *  @brief Base class representing a single HTTP response.
  *
@@ -137,9 +156,19 @@ typedef void (^DZWebServerBodyReaderCompletionBlock)(NSData* _Nullable data, NSE
  *  @c DZWebServerStreamedResponse override the reader methods to supply actual
  *  body content.
  *
- *  When @c gzipContentEncodingEnabled is set to @c YES, a gzip encoder is
- *  automatically chained in front of the body reader. This removes the
- *  @c Content-Length header and adds a @c Content-Encoding: gzip header.
+ *  When @c contentEncoding is set (or @c gzipContentEncodingEnabled is set to
+ *  @c YES), the encoder registered for that content coding is automatically
+ *  chained in front of the body reader. This removes the @c Content-Length
+ *  header and adds the matching @c Content-Encoding header. gzip is always
+ *  available. Additional encoders can be registered with
+ *  @c +registerContentEncoding:withEncoderBlock:.
+ *
+ *  @note The built-in brotli (@c "br") and zstd (@c "zstd") encoders are not
+ *  part of the default build and are unsupported unless the application links
+ *  libbrotlienc and libzstd itself and compiles DZWebServer with
+ *  @c __DZWEBSERVER_ENABLE_BROTLI__ and @c __DZWEBSERVER_ENABLE_ZSTD__ defined
+ *  (e.g., in @c GCC_PREPROCESSOR_DEFINITIONS). The Xcode project does not
+ *  define them, and without them these codings are never negotiated.
  *
  *  @warning DZWebServerResponse instances can be created and used on any GCD
  *           thread.
@@ -248,6 +277,69 @@ typedef void (^DZWebServerBodyReaderCompletionBlock)(NSData* _Nullable data, NSE
  */
 @property(nonatomic, getter=isGZipContentEncodingEnabled) BOOL gzipContentEncodingEnabled;
 
+/**
+ *  @brief The content coding to apply to the response body.
+ *
+ *  When non-nil, the encoder registered for this content coding (e.g.,
+ *  @c @"gzip", @c @"br" or @c @"zstd") is inserted into the body reader chain
+ *  during response preparation. Like gzip encoding, this adds the matching
+ *  @c Content-Encoding header and resets @c contentLength to
+ *  @c NSUIntegerMax. If no encoder is registered for the coding, the body is
+ *  sent unencoded.
+ *
+ *  Takes precedence over @c gzipContentEncodingEnabled.
+ *
+ *  Defaults to @c nil.
+ *
+ *  @see automaticContentEncodingEnabled
+ *  @see +registeredContentEncodings
+ */
+@property(nonatomic, copy, nullable) NSString* contentEncoding;
+
+/**
+ *  @brief Whether the content coding is negotiated automatically with the client.
+ *
+ *  When set to @c YES and @c contentEncoding is @c nil, the connection sets
+ *  @c contentEncoding right before sending the response, to the coding with the
+ *  highest quality value in the request's @c Accept-Encoding header among the
+ *  ones the server supports, ties being resolved by server preference (see
+ *  @c DZWebServerOption_ContentEncodings). A @c Vary: @c Accept-Encoding
+ *  header is added. Responses without a body, partial content responses and
+ *  responses that already carry a @c Content-Encoding header are sent as-is.
+ *
+ *  Defaults to @c NO.
+ *
+ *  @see contentEncoding
+ *  @see DZWebServerRequest.preferredContentEncodingFromEncodings:
+ */
+@property(nonatomic, getter=isAutomaticContentEncodingEnabled) BOOL automaticContentEncodingEnabled;
+
+/**
+ *  @brief Registers an encoder for a content coding.
+ *
+ *  Registered codings can be used with @c contentEncoding and take part in
+ *  automatic content encoding negotiation. Registering a coding that is already
+ *  registered replaces its encoder (e.g., to provide a different brotli
+ *  implementation). Coding names are case-insensitive.
+ *
+ *  @param encoding The content coding name sent in the @c Content-Encoding header.
+ *  @param block    The block creating encoders for this coding.
+ *
+ *  @note This method is thread-safe.
+ */
++ (void)registerContentEncoding:(NSString*)encoding withEncoderBlock:(DZWebServerContentEncoderBlock)block;
+
+/**
+ *  @brief Returns the content codings with a registered encoder.
+ *
+ *  Built-in codings come first in their default server preference order
+ *  (@c "br", @c "zstd", @c "gzip", depending on the build flags), followed by
+ *  custom codings in registration order.
+ *
+ *  @return The lowercased content coding names.
+ */
++ (NSArray<NSString*>*)registeredContentEncodings;
+
 /**
  *  @brief Creates an empty response with no body.
  *
@@ -269,6 +361,8 @@ typedef void (^DZWebServerBodyReaderCompletionBlock)(NSData* _Nullable data, NSE
  *  - @c lastModifiedDate = @c nil
  *  - @c eTag = @c nil
  *  - @c gzipContentEncodingEnabled = @c NO
+ *  - @c contentEncoding = @c nil
+ *  - @c automaticContentEncodingEnabled = @c NO
  *
  *  @return A newly initialized response instance.
  */
@@ -293,6 +387,56 @@ typedef void (^DZWebServerBodyReaderCompletionBlock)(NSData* _Nullable data, NSE
  */
 - (void)setValue:(nullable NSString*)value forAdditionalHeader:(NSString*)header;
 
+/**
+ *  @brief Declares a trailer field sent after a chunked body.
+ *
+ *  Declared trailers are listed in the @c Trailer header so their values can be
+ *  computed while the body is streamed, for instance a checksum updated from
+ *  the reader of a @c DZWebServerStreamedResponse, and set with
+ *  @c -setValue:forTrailer: before the last chunk is read.
+ *
+ *  Trailers are only sent for responses using chunked transfer encoding, i.e.
+ *  with a body of unknown @c contentLength, and are dropped otherwise.
+ *
+ *  Fields that control message framing, routing, authentication or how the
+ *  response is handled, such as @c Content-Length, @c Transfer-Encoding,
+ *  @c Host, @c Authorization or @c Content-Type, are not allowed in trailers
+ *  (RFC 7230 section 4.1.2) and are ignored with a warning.
+ *
+ *  @param trailer The trailer field name (e.g., @c @"Content-MD5").
+ *
+ *  @see -setValue:forTrailer:
+ */
+- (void)declareTrailer:(NSString*)trailer;
+
+/**
+ *  @brief Sets or removes the value of a trailer field.
+ *
+ *  The value is read once the body has been fully sent. Setting the value of a
+ *  trailer declares it if needed, but only trailers declared before the
+ *  headers are sent are listed in the @c Trailer header. Fields not allowed in
+ *  trailers are ignored as described for @c -declareTrailer:.
+ *
+ *  @param value   The trailer value, or @c nil to send no value.
+ *  @param trailer The trailer field name.
+ *
+ *  @see -declareTrailer:
+ */
+- (void)setValue:(nullable NSString*)value forTrailer:(NSString*)trailer;
+
+/**
+ *  @brief Sends a SHA-256 @c Digest trailer computed over the sent body.
+ *
+ *  When enabled, the connection hashes the body as it is written, after any
+ *  content encoding, and sends the result as a @c "Digest: sha-256=..."
+ *  trailer (RFC 3230). Like other trailers, it is only sent with chunked
+ *  transfer encoding: responses with a known @c contentLength, including
+ *  @c DZWebServerDataResponse and @c DZWebServerFileResponse, never carry it.
+ *
+ *  The default value is @c NO.
+ */
+@property(nonatomic, getter=isContentDigestTrailerEnabled) BOOL contentDigestTrailerEnabled;
+
 /**
  *  @brief Returns whether this response has a body.
  *
@@ -304,6 +448,18 @@ typedef void (^DZWebServerBodyReaderCompletionBlock)(NSData* _Nullable data, NSE
  */
 - (BOOL)hasBody;
 
+/**
+ *  @brief Whether this response only describes a body without providing it.
+ *
+ *  @c YES for responses created with @c +responseWithContentType:contentLength:.
+ *  Such responses can only answer @c HEAD requests: the connection sends their
+ *  @c Content-Type and @c Content-Length headers but never reads a body, and
+ *  replies with a 500 if one is returned for any other method.
+ *
+ *  @see DZWebServerRequest.headRequest
+ */
+@property(nonatomic, readonly, getter=isMetadataOnly) BOOL metadataOnly;
+
 @end
 
 /**
@@ -341,6 +497,23 @@ typedef void (^DZWebServerBodyReaderCompletionBlock)(NSData* _Nullable data, NSE
  */
 + (instancetype)responseWithRedirect:(NSURL*)location permanent:(BOOL)permanent;
 
+/**
+ *  @brief Creates a metadata-only response for a @c HEAD request.
+ *
+ *  The response carries the @c Content-Type and @c Content-Length the @c GET
+ *  response would have without generating its body, so answering @c HEAD costs
+ *  no more than computing that metadata. It is never content-encoded.
+ *
+ *  @param type   The content type of the body the @c GET response would have.
+ *  @param length The length in bytes of that body, or @c NSUIntegerMax if it is
+ *                not known without generating it (the @c Content-Length header
+ *                is then omitted).
+ *  @return A new metadata-only response instance.
+ *
+ *  @see DZWebServerRequest.headRequest
+ */
++ (instancetype)responseWithContentType:(NSString*)type contentLength:(NSUInteger)length;
+
 /**
  *  @brief Initializes an empty response with the specified HTTP status code.
  *
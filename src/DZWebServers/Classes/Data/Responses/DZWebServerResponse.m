@@ -30,26 +30,61 @@
 #endif
 
 #import <zlib.h>
+#if defined(__DZWEBSERVER_ENABLE_BROTLI__)
+#import <brotli/encode.h>
+#endif
+#if defined(__DZWEBSERVER_ENABLE_ZSTD__)
+#import <zstd.h>
+#endif
 
 #import "DZWebServerPrivate.h"
 
 #define kZlibErrorDomain @"ZlibErrorDomain"
-#define kGZipInitialBufferSize (256 * 1024)
+#define kBrotliErrorDomain @"BrotliErrorDomain"
+#define kZstdErrorDomain @"ZstdErrorDomain"
+#define kEncoderInitialBufferSize (64 * 1024)
+#define kParallelGZipDefaultBlockSize (128 * 1024)
+#define kParallelGZipMinimumBlockSize (1024)
 
 @interface DZWebServerBodyEncoder : NSObject <DZWebServerBodyReader>
+- (instancetype)initWithReader:(id<DZWebServerBodyReader> _Nonnull)reader options:(NSDictionary<NSString*, id>* _Nullable)options;
 @end
 
 @interface DZWebServerGZipEncoder : DZWebServerBodyEncoder
 @end
 
+@interface DZWebServerParallelGZipEncoder : DZWebServerBodyEncoder
+@end
+
+#if defined(__DZWEBSERVER_ENABLE_BROTLI__)
+
+@interface DZWebServerBrotliEncoder : DZWebServerBodyEncoder
+@end
+
+#endif
+
+#if defined(__DZWEBSERVER_ENABLE_ZSTD__)
+
+@interface DZWebServerZstdEncoder : DZWebServerBodyEncoder
+@end
+
+#endif
+
+@interface DZWebServerEncodedBodyReader : NSObject <DZWebServerBodyReader>
+- (instancetype)initWithData:(NSData*)data;
+@end
+
+static inline NSInteger _GetIntegerOption(NSDictionary<NSString*, id>* options, NSString* key, NSInteger defaultValue) {
+  NSNumber* value = [options objectForKey:key];
+  return value ? value.integerValue : defaultValue;
+}
+
 @implementation DZWebServerBodyEncoder {
-  DZWebServerResponse* __unsafe_unretained _response;
   id<DZWebServerBodyReader> __unsafe_unretained _reader;
 }
 
-- (instancetype)initWithResponse:(DZWebServerResponse* _Nonnull)response reader:(id<DZWebServerBodyReader> _Nonnull)reader {
+- (instancetype)initWithReader:(id<DZWebServerBodyReader> _Nonnull)reader options:(NSDictionary<NSString*, id>*)options {
   if ((self = [super init])) {
-    _response = response;
     _reader = reader;
   }
   return self;
@@ -69,29 +104,349 @@
 
 @end
 
+@implementation DZWebServerEncodedBodyReader {
+  NSData* _data;
+  BOOL _done;
+}
+
+- (instancetype)initWithData:(NSData*)data {
+  if ((self = [super init])) {
+    _data = data;
+  }
+  return self;
+}
+
+- (BOOL)open:(NSError**)error {
+  _done = NO;
+  return YES;
+}
+
+- (NSData*)readData:(NSError**)error {
+  if (_done) {
+    return [NSData data];
+  }
+  _done = YES;
+  return _data;
+}
+
+- (void)close {
+  ;
+}
+
+@end
+
 @implementation DZWebServerGZipEncoder {
-  z_stream _stream;
+  z_stream* _stream;
+  int _level;
+  int _windowBits;
   BOOL _finished;
 }
 
-- (instancetype)initWithResponse:(DZWebServerResponse* _Nonnull)response reader:(id<DZWebServerBodyReader> _Nonnull)reader {
-  if ((self = [super initWithResponse:response reader:reader])) {
-    response.contentLength = NSUIntegerMax;  // Make sure "Content-Length" header is not set since we don't know it
-    [response setValue:@"gzip" forAdditionalHeader:@"Content-Encoding"];
+- (instancetype)initWithReader:(id<DZWebServerBodyReader> _Nonnull)reader options:(NSDictionary<NSString*, id>*)options {
+  if ((self = [super initWithReader:reader options:options])) {
+    _level = (int)_GetIntegerOption(options, DZWebServerOption_GZipCompressionLevel, Z_DEFAULT_COMPRESSION);
+    _windowBits = (int)MIN(MAX(_GetIntegerOption(options, DZWebServerOption_GZipWindowBits, MAX_WBITS), 9), MAX_WBITS) + 16;
   }
   return self;
 }
 
+- (void)dealloc {
+  if (_stream) {
+    DZWebServerEnqueueDeflateStream(_stream, _level, _windowBits);  // Response was never closed
+  }
+}
+
 - (BOOL)open:(NSError**)error {
-  int result = deflateInit2(&_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
-  if (result != Z_OK) {
+  int result;
+  _stream = DZWebServerDequeueDeflateStream(_level, _windowBits, &result);
+  if (_stream == NULL) {
     if (error) {
       *error = [NSError errorWithDomain:kZlibErrorDomain code:result userInfo:nil];
     }
     return NO;
   }
   if (![super open:error]) {
-    deflateEnd(&_stream);
+    DZWebServerEnqueueDeflateStream(_stream, _level, _windowBits);
+    _stream = NULL;
+    return NO;
+  }
+  return YES;
+}
+
+- (NSData*)readData:(NSError**)error {
+  if (_finished) {
+    return [NSData data];
+  }
+  NSMutableData* buffer = DZWebServerDequeueZlibBuffer();  // Compress into a pooled scratch buffer and only copy out the actual output
+  NSMutableData* encodedData = nil;
+  do {
+    NSData* data = [super readData:error];
+    if (data == nil) {
+      encodedData = nil;
+      break;
+    }
+    _stream->next_in = (Bytef*)data.bytes;
+    _stream->avail_in = (uInt)data.length;
+    BOOL failed = NO;
+    do {
+      _stream->next_out = (Bytef*)buffer.mutableBytes;
+      _stream->avail_out = (uInt)buffer.length;
+      int result = deflate(_stream, data.length ? Z_NO_FLUSH : Z_FINISH);
+      if ((result != Z_OK) && (result != Z_STREAM_END) && (result != Z_BUF_ERROR)) {  // Z_BUF_ERROR only means no progress was possible after exactly filling the previous buffer
+        if (error) {
+          *error = [NSError errorWithDomain:kZlibErrorDomain code:result userInfo:nil];
+        }
+        failed = YES;
+        break;
+      }
+      NSUInteger length = buffer.length - _stream->avail_out;
+      if (length) {
+        if (encodedData == nil) {
+          encodedData = [[NSMutableData alloc] initWithBytes:buffer.bytes length:length];
+        } else {
+          [encodedData appendBytes:buffer.bytes length:length];
+        }
+      }
+      if (result == Z_STREAM_END) {
+        _finished = YES;
+      }
+    } while (_stream->avail_out == 0);  // zlib has used all the scratch buffer so drain it again in case more data is available
+    if (failed) {
+      encodedData = nil;
+      break;
+    }
+    DWS_DCHECK(_stream->avail_in == 0);
+  } while (encodedData == nil);  // Make sure we don't return an empty NSData if not in finished state
+  DZWebServerEnqueueZlibBuffer(buffer);
+  return encodedData;
+}
+
+- (void)close {
+  if (_stream) {
+    DZWebServerEnqueueDeflateStream(_stream, _level, _windowBits);
+    _stream = NULL;
+  }
+  [super close];
+}
+
+@end
+
+// Compresses a block as raw deflate data ending with a sync flush, so blocks can be concatenated into a single stream
+static NSData* _DeflateBlock(NSData* input, NSData* dictionary, int level, int windowBits, int* status) {
+  z_stream* stream = DZWebServerDequeueDeflateStream(level, -windowBits, status);
+  if (stream == NULL) {
+    return nil;
+  }
+  if (dictionary.length) {
+    *status = deflateSetDictionary(stream, dictionary.bytes, (uInt)dictionary.length);
+    if (*status != Z_OK) {
+      DZWebServerEnqueueDeflateStream(stream, level, -windowBits);
+      return nil;
+    }
+  }
+  NSMutableData* output = [[NSMutableData alloc] initWithLength:(deflateBound(stream, input.length) + 16)];  // Extra room for the sync flush marker
+  NSUInteger length = 0;
+  stream->next_in = (Bytef*)input.bytes;
+  stream->avail_in = (uInt)input.length;
+  while (1) {
+    NSUInteger maxLength = output.length - length;
+    stream->next_out = (Bytef*)((char*)output.mutableBytes + length);
+    stream->avail_out = (uInt)maxLength;
+    int result = deflate(stream, Z_SYNC_FLUSH);
+    if ((result != Z_OK) && (result != Z_BUF_ERROR)) {
+      *status = result;
+      DZWebServerEnqueueDeflateStream(stream, level, -windowBits);
+      return nil;
+    }
+    length += maxLength - stream->avail_out;
+    if (stream->avail_out > 0) {
+      break;
+    }
+    output.length = 2 * output.length;
+  }
+  DWS_DCHECK(stream->avail_in == 0);
+  DZWebServerEnqueueDeflateStream(stream, level, -windowBits);
+  output.length = length;
+  *status = Z_OK;
+  return output;
+}
+
+@interface DZWebServerParallelGZipBlock : NSObject {
+ @package
+  dispatch_group_t _group;
+  NSUInteger _inputLength;
+  uLong _crc;
+  NSData* _output;  // Written by the compression task only, read after _group completes
+  int _status;
+}
+@end
+
+@implementation DZWebServerParallelGZipBlock
+@end
+
+@implementation DZWebServerParallelGZipEncoder {
+  int _level;
+  int _windowBits;
+  NSUInteger _blockSize;
+  NSUInteger _maxBlocksInFlight;
+  NSMutableArray<DZWebServerParallelGZipBlock*>* _blocks;
+  NSData* _previousInput;
+  uLong _crc;
+  uLong _totalLength;
+  BOOL _headerWritten;
+  BOOL _inputFinished;
+  BOOL _finished;
+}
+
+- (instancetype)initWithReader:(id<DZWebServerBodyReader> _Nonnull)reader options:(NSDictionary<NSString*, id>*)options {
+  if ((self = [super initWithReader:reader options:options])) {
+    _level = (int)_GetIntegerOption(options, DZWebServerOption_GZipCompressionLevel, Z_DEFAULT_COMPRESSION);
+    _windowBits = (int)MIN(MAX(_GetIntegerOption(options, DZWebServerOption_GZipWindowBits, MAX_WBITS), 9), MAX_WBITS);
+    _blockSize = MAX((NSUInteger)_GetIntegerOption(options, DZWebServerOption_ParallelGZipBlockSize, kParallelGZipDefaultBlockSize), kParallelGZipMinimumBlockSize);
+    _maxBlocksInFlight = MAX((NSUInteger)_GetIntegerOption(options, DZWebServerOption_ParallelGZipMaxBlocksInFlight, 2 * [[NSProcessInfo processInfo] activeProcessorCount]), 1);
+    _blocks = [[NSMutableArray alloc] init];
+  }
+  return self;
+}
+
+- (BOOL)open:(NSError**)error {
+  _crc = crc32(0L, Z_NULL, 0);
+  _totalLength = 0;
+  return [super open:error];
+}
+
+- (void)_enqueueBlockWithInput:(NSData*)input {
+  DZWebServerParallelGZipBlock* block = [[DZWebServerParallelGZipBlock alloc] init];
+  block->_group = dispatch_group_create();
+  block->_inputLength = input.length;
+  NSData* dictionary = nil;
+  if (_previousInput) {
+    NSUInteger dictionaryLength = MIN(_previousInput.length, (NSUInteger)1 << _windowBits);
+    dictionary = [_previousInput subdataWithRange:NSMakeRange(_previousInput.length - dictionaryLength, dictionaryLength)];
+  }
+  _previousInput = input;
+  int level = _level;
+  int windowBits = _windowBits;
+  dispatch_group_async(block->_group, dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
+    block->_crc = crc32(crc32(0L, Z_NULL, 0), input.bytes, (uInt)input.length);
+    int status;
+    block->_output = _DeflateBlock(input, dictionary, level, windowBits, &status);
+    block->_status = status;
+  });
+  [_blocks addObject:block];
+}
+
+- (NSData*)readData:(NSError**)error {
+  if (_finished) {
+    return [NSData data];
+  }
+
+  // Read ahead and start compressing up to the maximum number of blocks
+  while (!_inputFinished && (_blocks.count < _maxBlocksInFlight)) {
+    NSMutableData* input = [[NSMutableData alloc] initWithCapacity:_blockSize];
+    while (input.length < _blockSize) {
+      NSData* data = [super readData:error];
+      if (data == nil) {
+        return nil;
+      }
+      if (data.length == 0) {
+        _inputFinished = YES;
+        break;
+      }
+      [input appendData:data];
+    }
+    if (input.length) {
+      [self _enqueueBlockWithInput:input];
+    }
+  }
+
+  NSMutableData* encodedData = [[NSMutableData alloc] init];
+  if (!_headerWritten) {
+    const unsigned char header[10] = {0x1F, 0x8B, Z_DEFLATED, 0, 0, 0, 0, 0, (_level == 9 ? 2 : (_level == 1 ? 4 : 0)), 3};  // No file name or modification time, Unix
+    [encodedData appendBytes:header length:sizeof(header)];
+    _headerWritten = YES;
+  }
+
+  // Emit blocks in order as they complete
+  DZWebServerParallelGZipBlock* block = _blocks.firstObject;
+  if (block) {
+    dispatch_group_wait(block->_group, DISPATCH_TIME_FOREVER);
+    [_blocks removeObjectAtIndex:0];
+    if (block->_output == nil) {
+      if (error) {
+        *error = [NSError errorWithDomain:kZlibErrorDomain code:block->_status userInfo:nil];
+      }
+      return nil;
+    }
+    [encodedData appendData:block->_output];
+    _crc = crc32_combine(_crc, block->_crc, (z_off_t)block->_inputLength);
+    _totalLength += block->_inputLength;
+  }
+
+  if (_inputFinished && (_blocks.count == 0)) {
+    const unsigned char trailer[10] = {
+        0x03, 0x00,  // Empty final fixed Huffman block
+        (unsigned char)(_crc & 0xFF), (unsigned char)((_crc >> 8) & 0xFF), (unsigned char)((_crc >> 16) & 0xFF), (unsigned char)((_crc >> 24) & 0xFF),
+        (unsigned char)(_totalLength & 0xFF), (unsigned char)((_totalLength >> 8) & 0xFF), (unsigned char)((_totalLength >> 16) & 0xFF), (unsigned char)((_totalLength >> 24) & 0xFF)};
+    [encodedData appendBytes:trailer length:sizeof(trailer)];
+    _finished = YES;
+  }
+  return encodedData;
+}
+
+- (void)close {
+  for (DZWebServerParallelGZipBlock* block in _blocks) {
+    dispatch_group_wait(block->_group, DISPATCH_TIME_FOREVER);  // Compression tasks only retain their block so this just bounds CPU usage after an early close
+  }
+  [_blocks removeAllObjects];
+  _previousInput = nil;
+  [super close];
+}
+
+@end
+
+// Only responses of known length above the threshold are worth splitting across cores
+static BOOL _ShouldUseParallelGZipEncoder(id<DZWebServerBodyReader> reader, NSDictionary<NSString*, id>* options) {
+  NSInteger minimumSize = _GetIntegerOption(options, DZWebServerOption_ParallelGZipMinimumSize, 0);
+  if ((minimumSize <= 0) || ([[NSProcessInfo processInfo] activeProcessorCount] < 2) || ![(id)reader isKindOfClass:[DZWebServerResponse class]]) {
+    return NO;
+  }
+  NSUInteger contentLength = [(DZWebServerResponse*)reader contentLength];
+  return (contentLength != NSUIntegerMax) && (contentLength >= (NSUInteger)minimumSize);
+}
+
+#if defined(__DZWEBSERVER_ENABLE_BROTLI__)
+
+@implementation DZWebServerBrotliEncoder {
+  BrotliEncoderState* _state;
+  uint32_t _quality;
+  uint32_t _windowBits;
+  BOOL _finished;
+}
+
+- (instancetype)initWithReader:(id<DZWebServerBodyReader> _Nonnull)reader options:(NSDictionary<NSString*, id>*)options {
+  if ((self = [super initWithReader:reader options:options])) {
+    _quality = (uint32_t)MIN(MAX(_GetIntegerOption(options, DZWebServerOption_BrotliCompressionQuality, 5), BROTLI_MIN_QUALITY), BROTLI_MAX_QUALITY);  // Level 5 compresses better than gzip at a similar CPU cost
+    _windowBits = (uint32_t)MIN(MAX(_GetIntegerOption(options, DZWebServerOption_BrotliWindowBits, BROTLI_DEFAULT_WINDOW), BROTLI_MIN_WINDOW_BITS), BROTLI_MAX_WINDOW_BITS);
+  }
+  return self;
+}
+
+- (BOOL)open:(NSError**)error {
+  _state = BrotliEncoderCreateInstance(NULL, NULL, NULL);
+  if ((_state == NULL) || !BrotliEncoderSetParameter(_state, BROTLI_PARAM_QUALITY, _quality) || !BrotliEncoderSetParameter(_state, BROTLI_PARAM_LGWIN, _windowBits)) {
+    if (_state) {
+      BrotliEncoderDestroyInstance(_state);
+      _state = NULL;
+    }
+    if (error) {
+      *error = [NSError errorWithDomain:kBrotliErrorDomain code:-1 userInfo:nil];
+    }
+    return NO;
+  }
+  if (![super open:error]) {
+    BrotliEncoderDestroyInstance(_state);
+    _state = NULL;
     return NO;
   }
   return YES;
@@ -102,7 +457,7 @@
   if (_finished) {
     encodedData = [[NSMutableData alloc] init];
   } else {
-    encodedData = [[NSMutableData alloc] initWithLength:kGZipInitialBufferSize];
+    encodedData = [[NSMutableData alloc] initWithLength:kEncoderInitialBufferSize];
     if (encodedData == nil) {
       DWS_DNOT_REACHED();
       return nil;
@@ -113,47 +468,223 @@
       if (data == nil) {
         return nil;
       }
-      _stream.next_in = (Bytef*)data.bytes;
-      _stream.avail_in = (uInt)data.length;
+      BrotliEncoderOperation operation = data.length ? BROTLI_OPERATION_PROCESS : BROTLI_OPERATION_FINISH;
+      size_t availableIn = data.length;
+      const uint8_t* nextIn = data.bytes;
       while (1) {
-        NSUInteger maxLength = encodedData.length - length;
-        _stream.next_out = (Bytef*)((char*)encodedData.mutableBytes + length);
-        _stream.avail_out = (uInt)maxLength;
-        int result = deflate(&_stream, data.length ? Z_NO_FLUSH : Z_FINISH);
-        if (result == Z_STREAM_END) {
-          _finished = YES;
-        } else if (result != Z_OK) {
+        size_t availableOut = encodedData.length - length;
+        uint8_t* nextOut = (uint8_t*)encodedData.mutableBytes + length;
+        if (!BrotliEncoderCompressStream(_state, operation, &availableIn, &nextIn, &availableOut, &nextOut, NULL)) {
           if (error) {
-            *error = [NSError errorWithDomain:kZlibErrorDomain code:result userInfo:nil];
+            *error = [NSError errorWithDomain:kBrotliErrorDomain code:-1 userInfo:nil];
           }
           return nil;
         }
-        length += maxLength - _stream.avail_out;
-        if (_stream.avail_out > 0) {
+        length = encodedData.length - availableOut;
+        if (operation == BROTLI_OPERATION_FINISH) {
+          if (BrotliEncoderIsFinished(_state)) {
+            _finished = YES;
+            break;
+          }
+        } else if ((availableIn == 0) && !BrotliEncoderHasMoreOutput(_state)) {
           break;
         }
-        encodedData.length = 2 * encodedData.length;  // zlib has used all the output buffer so resize it and try again in case more data is available
+        if (availableOut == 0) {
+          encodedData.length = 2 * encodedData.length;  // Brotli has used all the output buffer so resize it and try again
+        }
       }
-      DWS_DCHECK(_stream.avail_in == 0);
-    } while (length == 0);  // Make sure we don't return an empty NSData if not in finished state
+    } while ((length == 0) && !_finished);  // Make sure we don't return an empty NSData if not in finished state
     encodedData.length = length;
   }
   return encodedData;
 }
 
 - (void)close {
-  deflateEnd(&_stream);
+  if (_state) {
+    BrotliEncoderDestroyInstance(_state);
+    _state = NULL;
+  }
   [super close];
 }
 
 @end
 
+#endif
+
+#if defined(__DZWEBSERVER_ENABLE_ZSTD__)
+
+@implementation DZWebServerZstdEncoder {
+  ZSTD_CCtx* _context;
+  int _level;
+  int _windowLog;
+  BOOL _finished;
+}
+
+- (instancetype)initWithReader:(id<DZWebServerBodyReader> _Nonnull)reader options:(NSDictionary<NSString*, id>*)options {
+  if ((self = [super initWithReader:reader options:options])) {
+    _level = (int)_GetIntegerOption(options, DZWebServerOption_ZstdCompressionLevel, ZSTD_CLEVEL_DEFAULT);
+    _windowLog = (int)_GetIntegerOption(options, DZWebServerOption_ZstdWindowLog, 0);  // 0 lets zstd pick the window size from the level
+  }
+  return self;
+}
+
+- (BOOL)open:(NSError**)error {
+  _context = ZSTD_createCCtx();
+  if (_context == NULL) {
+    if (error) {
+      *error = [NSError errorWithDomain:kZstdErrorDomain code:-1 userInfo:nil];
+    }
+    return NO;
+  }
+  size_t result = ZSTD_CCtx_setParameter(_context, ZSTD_c_compressionLevel, _level);
+  if (!ZSTD_isError(result)) {
+    result = ZSTD_CCtx_setParameter(_context, ZSTD_c_windowLog, _windowLog);
+  }
+  if (ZSTD_isError(result)) {
+    ZSTD_freeCCtx(_context);
+    _context = NULL;
+    if (error) {
+      *error = [NSError errorWithDomain:kZstdErrorDomain code:(NSInteger)ZSTD_getErrorCode(result) userInfo:nil];
+    }
+    return NO;
+  }
+  if (![super open:error]) {
+    ZSTD_freeCCtx(_context);
+    _context = NULL;
+    return NO;
+  }
+  return YES;
+}
+
+- (NSData*)readData:(NSError**)error {
+  NSMutableData* encodedData;
+  if (_finished) {
+    encodedData = [[NSMutableData alloc] init];
+  } else {
+    encodedData = [[NSMutableData alloc] initWithLength:kEncoderInitialBufferSize];
+    if (encodedData == nil) {
+      DWS_DNOT_REACHED();
+      return nil;
+    }
+    NSUInteger length = 0;
+    do {
+      NSData* data = [super readData:error];
+      if (data == nil) {
+        return nil;
+      }
+      ZSTD_EndDirective directive = data.length ? ZSTD_e_continue : ZSTD_e_end;
+      ZSTD_inBuffer input = {data.bytes, data.length, 0};
+      while (1) {
+        ZSTD_outBuffer output = {(char*)encodedData.mutableBytes + length, encodedData.length - length, 0};
+        size_t result = ZSTD_compressStream2(_context, &output, &input, directive);
+        if (ZSTD_isError(result)) {
+          if (error) {
+            *error = [NSError errorWithDomain:kZstdErrorDomain code:(NSInteger)ZSTD_getErrorCode(result) userInfo:@{NSLocalizedDescriptionKey : [NSString stringWithUTF8String:ZSTD_getErrorName(result)]}];
+          }
+          return nil;
+        }
+        length += output.pos;
+        if (directive == ZSTD_e_end) {
+          if (result == 0) {
+            _finished = YES;
+            break;
+          }
+        } else if (input.pos == input.size) {
+          break;
+        }
+        if (output.pos == output.size) {
+          encodedData.length = 2 * encodedData.length;  // Zstd has used all the output buffer so resize it and try again
+        }
+      }
+    } while ((length == 0) && !_finished);  // Make sure we don't return an empty NSData if not in finished state
+    encodedData.length = length;
+  }
+  return encodedData;
+}
+
+- (void)close {
+  if (_context) {
+    ZSTD_freeCCtx(_context);
+    _context = NULL;
+  }
+  [super close];
+}
+
+@end
+
+#endif
+
+static dispatch_queue_t _encoderRegistryQueue = NULL;
+static NSMutableDictionary<NSString*, DZWebServerContentEncoderBlock>* _encoderBlocks = nil;  // Accessed through _encoderRegistryQueue only
+static NSMutableArray<NSString*>* _encoderNames = nil;  // Accessed through _encoderRegistryQueue only
+
+static void _RegisterContentEncoder(NSString* encoding, DZWebServerContentEncoderBlock block) {
+  NSString* name = [encoding lowercaseString];
+  dispatch_sync(_encoderRegistryQueue, ^{
+    if ([_encoderBlocks objectForKey:name] == nil) {
+      [_encoderNames addObject:name];
+    }
+    [_encoderBlocks setObject:[block copy] forKey:name];
+  });
+}
+
+static void _InitializeContentEncoderRegistry(void) {
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    _encoderRegistryQueue = dispatch_queue_create("DZWebServerResponse.encoders", DISPATCH_QUEUE_SERIAL);
+    _encoderBlocks = [[NSMutableDictionary alloc] init];
+    _encoderNames = [[NSMutableArray alloc] init];
+
+    // Built-in encoders are registered in default server preference order
+#if defined(__DZWEBSERVER_ENABLE_BROTLI__)
+    _RegisterContentEncoder(@"br", ^id<DZWebServerBodyReader>(id<DZWebServerBodyReader> reader, NSDictionary<NSString*, id>* options) {
+      return [[DZWebServerBrotliEncoder alloc] initWithReader:reader options:options];
+    });
+#endif
+#if defined(__DZWEBSERVER_ENABLE_ZSTD__)
+    _RegisterContentEncoder(@"zstd", ^id<DZWebServerBodyReader>(id<DZWebServerBodyReader> reader, NSDictionary<NSString*, id>* options) {
+      return [[DZWebServerZstdEncoder alloc] initWithReader:reader options:options];
+    });
+#endif
+    _RegisterContentEncoder(@"gzip", ^id<DZWebServerBodyReader>(id<DZWebServerBodyReader> reader, NSDictionary<NSString*, id>* options) {
+      if (_ShouldUseParallelGZipEncoder(reader, options)) {
+        return [[DZWebServerParallelGZipEncoder alloc] initWithReader:reader options:options];
+      }
+      return [[DZWebServerGZipEncoder alloc] initWithReader:reader options:options];
+    });
+  });
+}
+
+static DZWebServerContentEncoderBlock _ContentEncoderBlockForEncoding(NSString* encoding) {
+  _InitializeContentEncoderRegistry();
+  NSString* name = [encoding lowercaseString];
+  __block DZWebServerContentEncoderBlock block;
+  dispatch_sync(_encoderRegistryQueue, ^{
+    block = [_encoderBlocks objectForKey:name];
+  });
+  return block;
+}
+
 @implementation DZWebServerResponse {
   BOOL _opened;
-  NSMutableArray<DZWebServerBodyEncoder*>* _encoders;
+  NSMutableArray<id<DZWebServerBodyReader>>* _encoders;
   id<DZWebServerBodyReader> __unsafe_unretained _reader;
 }
 
++ (void)registerContentEncoding:(NSString*)encoding withEncoderBlock:(DZWebServerContentEncoderBlock)block {
+  _InitializeContentEncoderRegistry();
+  _RegisterContentEncoder(encoding, block);
+}
+
++ (NSArray<NSString*>*)registeredContentEncodings {
+  _InitializeContentEncoderRegistry();
+  __block NSArray<NSString*>* encodings;
+  dispatch_sync(_encoderRegistryQueue, ^{
+    encodings = [_encoderNames copy];
+  });
+  return encodings;
+}
+
 + (instancetype)response {
   return [(DZWebServerResponse*)[[self class] alloc] init];
 }
@@ -165,6 +696,8 @@
     _statusCode = kDZWebServerHTTPStatusCode_OK;
     _cacheControlMaxAge = 0;
     _additionalHeaders = [[NSMutableDictionary alloc] init];
+    _declaredTrailers = [[NSMutableArray alloc] init];
+    _trailerValues = [[NSMutableDictionary alloc] init];
     _encoders = [[NSMutableArray alloc] init];
   }
   return self;
@@ -174,12 +707,41 @@
   [_additionalHeaders setValue:value forKey:header];
 }
 
+// Fields that control framing, routing, authentication or the handling of the response are not allowed in trailers (RFC 7230 section 4.1.2)
+static BOOL _IsAllowedTrailer(NSString* trailer) {
+  static NSSet<NSString*>* forbiddenTrailers = nil;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    forbiddenTrailers = [[NSSet alloc] initWithObjects:@"transfer-encoding", @"content-length", @"host", @"cache-control", @"expect", @"max-forwards", @"pragma", @"range", @"te", @"if-match", @"if-none-match", @"if-modified-since", @"if-unmodified-since", @"if-range", @"authorization", @"proxy-authorization", @"www-authenticate", @"proxy-authenticate", @"cookie", @"set-cookie", @"age", @"date", @"expires", @"location", @"retry-after", @"vary", @"warning", @"content-encoding", @"content-type", @"content-range", @"trailer", nil];
+  });
+  return ![forbiddenTrailers containsObject:[trailer lowercaseString]];
+}
+
+- (void)declareTrailer:(NSString*)trailer {
+  if (!_IsAllowedTrailer(trailer)) {
+    DWS_LOG_WARNING(@"Ignoring '%@' header which is not allowed in trailers", trailer);
+    return;
+  }
+  if (![_declaredTrailers containsObject:trailer]) {
+    [(NSMutableArray*)_declaredTrailers addObject:trailer];
+  }
+}
+
+- (void)setValue:(NSString*)value forTrailer:(NSString*)trailer {
+  if (!_IsAllowedTrailer(trailer)) {
+    DWS_LOG_WARNING(@"Ignoring '%@' header which is not allowed in trailers", trailer);
+    return;
+  }
+  [self declareTrailer:trailer];
+  [(NSMutableDictionary*)_trailerValues setValue:value forKey:trailer];
+}
+
 - (BOOL)hasBody {
   return _contentType ? YES : NO;
 }
 
 - (BOOL)usesChunkedTransferEncoding {
-  return (_contentType != nil) && (_contentLength == NSUIntegerMax);
+  return (_contentType != nil) && (_contentLength == NSUIntegerMax) && !_metadataOnly;
 }
 
 - (BOOL)open:(NSError**)error {
@@ -194,15 +756,59 @@
   ;
 }
 
-- (void)prepareForReading {
+- (void)prepareForReadingWithContentEncodingOptions:(NSDictionary<NSString*, id>*)options {
   _reader = self;
-  if (_gzipContentEncodingEnabled) {
-    DZWebServerGZipEncoder* encoder = [[DZWebServerGZipEncoder alloc] initWithResponse:self reader:_reader];
-    [_encoders addObject:encoder];
-    _reader = encoder;
+  NSString* encoding = _contentEncoding ? _contentEncoding : (_gzipContentEncodingEnabled ? @"gzip" : nil);
+  if (encoding) {
+    DZWebServerContentEncoderBlock block = _ContentEncoderBlockForEncoding(encoding);
+    id<DZWebServerBodyReader> encoder = block ? block(_reader, options) : nil;
+    if (encoder) {
+      [_encoders addObject:encoder];
+      _reader = encoder;
+      self.contentLength = NSUIntegerMax;  // Make sure "Content-Length" header is not set since we don't know it
+      [self setValue:encoding forAdditionalHeader:@"Content-Encoding"];
+    } else {
+      DWS_LOG_WARNING(@"No encoder registered for '%@' content encoding", encoding);
+    }
   }
 }
 
+- (void)prepareForReadingWithEncodedBody:(NSData*)body contentEncoding:(NSString*)encoding {
+  id<DZWebServerBodyReader> reader = [[DZWebServerEncodedBodyReader alloc] initWithData:body];
+  [_encoders addObject:reader];
+  _reader = reader;
+  self.contentLength = body.length;
+  [self setValue:encoding forAdditionalHeader:@"Content-Encoding"];
+}
+
+- (NSData*)encodedBodyWithContentEncoding:(NSString*)encoding options:(NSDictionary<NSString*, id>*)options {
+  DZWebServerContentEncoderBlock block = _ContentEncoderBlockForEncoding(encoding);
+  id<DZWebServerBodyReader> encoder = block ? block(self, options) : nil;
+  if (encoder == nil) {
+    return nil;
+  }
+  NSError* error = nil;
+  if (![encoder open:&error]) {
+    DWS_LOG_ERROR(@"Failed opening encoder for '%@' content encoding: %@", encoding, error);
+    return nil;
+  }
+  NSMutableData* body = [[NSMutableData alloc] init];
+  while (1) {
+    NSData* data = [encoder readData:&error];
+    if (data == nil) {
+      DWS_LOG_ERROR(@"Failed encoding body for '%@' content encoding: %@", encoding, error);
+      body = nil;
+      break;
+    }
+    if (data.length == 0) {
+      break;
+    }
+    [body appendData:data];
+  }
+  [encoder close];
+  return body;
+}
+
 - (BOOL)performOpen:(NSError**)error {
   DWS_DCHECK(_contentType);
   DWS_DCHECK(_reader);
@@ -266,6 +872,14 @@
   return [(DZWebServerResponse*)[self alloc] initWithRedirect:location permanent:permanent];
 }
 
++ (instancetype)responseWithContentType:(NSString*)type contentLength:(NSUInteger)length {
+  DZWebServerResponse* response = [(DZWebServerResponse*)[self alloc] init];
+  response.contentType = type;
+  response.contentLength = length;
+  response.metadataOnly = YES;
+  return response;
+}
+
 - (instancetype)initWithStatusCode:(NSInteger)statusCode {
   if ((self = [self init])) {
     self.statusCode = statusCode;
@@ -81,10 +81,20 @@ NS_ASSUME_NONNULL_END
     [self addGETHandlerForBasePath:@"/" directoryPath:(NSString*)[siteBundle resourcePath] indexFilename:nil cacheAge:3600 allowRangeRequests:NO];
 
     // Web page
+    NSArray<NSString*>* preloadLinks = @[
+      @"</css/bootstrap.css>; rel=preload; as=style",
+      @"</css/bootstrap-theme.css>; rel=preload; as=style",
+      @"</css/jquery.fileupload.css>; rel=preload; as=style",
+      @"</css/index.css>; rel=preload; as=style",
+      @"</js/jquery.min.js>; rel=preload; as=script",
+      @"</js/bootstrap.min.js>; rel=preload; as=script",
+      @"</js/index.js>; rel=preload; as=script"
+    ];
     [self addHandlerForMethod:@"GET"
                          path:@"/"
                  requestClass:[DZWebServerRequest class]
                  processBlock:^DZWebServerResponse*(DZWebServerRequest* request) {
+                   [request sendEarlyHintsWithLinks:preloadLinks];  // Let the browser fetch the assets while the page is generated
 
 #if TARGET_OS_IPHONE
                    NSString* device = [[UIDevice currentDevice] name];
@@ -305,7 +315,7 @@ NS_ASSUME_NONNULL_END
   }
 
   NSError* error = nil;
-  if (![[NSFileManager defaultManager] moveItemAtPath:file.temporaryPath toPath:absolutePath error:&error]) {
+  if (![file moveTemporaryFileToPath:absolutePath error:&error]) {
     return [DZWebServerErrorResponse responseWithServerError:kDZWebServerHTTPStatusCode_InternalServerError underlyingError:error message:@"Failed moving uploaded file to \"%@\"", relativePath];
   }
 
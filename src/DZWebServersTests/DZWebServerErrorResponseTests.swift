@@ -489,6 +489,37 @@ struct ErrorResponseMessageTests {
             "Longer message should produce a response with greater content length"
         )
     }
+
+    @Test("Responses with the same status code share the rendered HTML around the message")
+    func sameStatusCodeSharesRenderedHTML() throws {
+        let first = DZWebServerErrorResponse(clientError: .httpStatusCode_NotFound, message: "alpha")
+        let second = DZWebServerErrorResponse(clientError: .httpStatusCode_NotFound, message: "omega!")
+        #expect(second.contentLength == first.contentLength + 1)
+
+        let firstBody = try readBody(first)
+        let secondBody = try readBody(second)
+        #expect(firstBody != secondBody)
+        let prefixLength = zip(firstBody, secondBody).prefix { $0 == $1 }.count
+        let prefix = try #require(String(data: firstBody.prefix(prefixLength), encoding: .utf8))
+        #expect(prefix.hasPrefix("<!DOCTYPE html>"))
+        #expect(prefix.hasSuffix(": "))
+        #expect(String(data: firstBody.dropFirst(prefixLength), encoding: .utf8)?.hasPrefix("alpha") == true)
+        #expect(String(data: secondBody.dropFirst(prefixLength), encoding: .utf8)?.hasPrefix("omega!") == true)
+    }
+
+    private func readBody(_ response: DZWebServerErrorResponse) throws -> Data {
+        try response.open()
+        var body = Data()
+        while true {
+            let chunk = try response.readData()
+            if chunk.isEmpty {
+                break
+            }
+            body.append(chunk)
+        }
+        response.close()
+        return body
+    }
 }
 
 // MARK: - Factory Methods vs Initializers
@@ -207,6 +207,19 @@ struct DZWebServerFileRequestTests {
             #expect(fileContents.count == size)
         }
 
+        @Test("Payloads larger than the pending disk writes are stored in order")
+        func payloadLargerThanPendingWrites() async throws {
+            let (server, capture, url) = try makeFileServer()
+            defer { server.stop() }
+
+            let size = 8 * 1024 * 1024 + 123
+            let body = Data((0..<size).map { UInt8(truncatingIfNeeded: $0 / 4096) })
+            _ = try await sendFilePost(to: url, body: body)
+
+            let fileContents = try #require(capture.fileContents)
+            #expect(fileContents == body)
+        }
+
         @Test("Binary data with all 256 byte values is stored exactly")
         func binaryDataAllByteValues() async throws {
             let (server, capture, url) = try makeFileServer()
@@ -559,4 +572,47 @@ struct DZWebServerFileRequestTests {
             #expect(fileContents == Data("put-body-content".utf8))
         }
     }
+
+    // MARK: - Spool Directory
+
+    @Suite("Spool directory and finalization")
+    struct SpoolDirectory {
+        @Test("Body is spooled in the configured directory and moved into place")
+        func spooledBodyIsMovedIntoPlace() async throws {
+            let directory = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent(UUID().uuidString)
+            try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+            defer { try? FileManager.default.removeItem(at: directory) }
+            let destination = directory.appendingPathComponent("upload.bin")
+            try Data("previous".utf8).write(to: destination)
+
+            let capture = FileRequestCapture()
+            let server = DZWebServer()
+            server.addHandler(
+                match: { method, url, headers, path, query in
+                    let request = DZWebServerFileRequest(method: method, url: url, headers: headers, path: path, query: query)
+                    request.spoolDirectoryPath = directory.path
+                    return request
+                },
+                processBlock: { request in
+                    let fileRequest = request as! DZWebServerFileRequest
+                    capture.temporaryPath = fileRequest.temporaryPath
+                    let moved = (try? fileRequest.moveTemporaryFile(toPath: destination.path)) != nil
+                    return DZWebServerResponse(statusCode: moved ? 201 : 500)
+                }
+            )
+            try server.start(options: [DZWebServerOption_Port: 0, DZWebServerOption_BindToLocalhost: true])
+
+            let body = Data(repeating: 0x41, count: 100_000)
+            var request = URLRequest(url: URL(string: "http://localhost:\(server.port)/upload")!)
+            request.httpMethod = "PUT"
+            request.httpBody = body
+            let (_, response) = try await URLSession.shared.data(for: request)
+            server.stop()
+
+            #expect((response as? HTTPURLResponse)?.statusCode == 201)
+            let temporaryPath = try #require(capture.temporaryPath)
+            #expect((temporaryPath as NSString).deletingLastPathComponent == directory.path)
+            #expect(try Data(contentsOf: destination) == body)
+        }
+    }
 }
@@ -262,8 +262,8 @@ struct ByteRangeResponseTests {
         )
     }
 
-    @Test("Range with offset beyond file size results in zero length and returns nil")
-    func rangeWithOffsetBeyondFileSizeReturnsNil() throws {
+    @Test("Range with offset beyond file size produces a 416 response without body")
+    func rangeWithOffsetBeyondFileSizeReturns416() throws {
         let dir = try makeTestDirectory()
         defer { removeTestDirectory(dir) }
 
@@ -275,8 +275,12 @@ struct ByteRangeResponseTests {
         let response = DZWebServerFileResponse(file: path, byteRange: range)
 
         #expect(
-            response == nil,
-            "Should return nil when the resolved byte range has zero length"
+            response?.statusCode == 416,
+            "Status code should be 416 when no byte range overlaps the file"
+        )
+        #expect(
+            response?.hasBody() == false,
+            "A 416 response should not have a body"
         )
     }
 
@@ -714,8 +718,8 @@ struct EdgeCaseTests {
         )
     }
 
-    @Test("Byte range on empty file returns nil because resolved range is zero length")
-    func byteRangeOnEmptyFileReturnsNil() throws {
+    @Test("Byte range on empty file produces a 416 response because no byte is satisfiable")
+    func byteRangeOnEmptyFileReturns416() throws {
         let dir = try makeTestDirectory()
         defer { removeTestDirectory(dir) }
 
@@ -724,13 +728,13 @@ struct EdgeCaseTests {
         let response = DZWebServerFileResponse(file: path, byteRange: range)
 
         #expect(
-            response == nil,
-            "Should return nil because the byte range resolves to zero bytes on an empty file"
+            response?.statusCode == 416,
+            "Status code should be 416 because the byte range resolves to zero bytes on an empty file"
         )
     }
 
-    @Test("Suffix range on empty file returns nil")
-    func suffixRangeOnEmptyFileReturnsNil() throws {
+    @Test("Suffix range on empty file produces a 416 response")
+    func suffixRangeOnEmptyFileReturns416() throws {
         let dir = try makeTestDirectory()
         defer { removeTestDirectory(dir) }
 
@@ -739,8 +743,8 @@ struct EdgeCaseTests {
         let response = DZWebServerFileResponse(file: path, byteRange: range)
 
         #expect(
-            response == nil,
-            "Should return nil because suffix range on an empty file resolves to zero bytes"
+            response?.statusCode == 416,
+            "Status code should be 416 because a suffix range on an empty file resolves to zero bytes"
         )
     }
 
@@ -874,4 +878,268 @@ struct BodyReaderTests {
             "Data read should match the expected byte range of the original content"
         )
     }
+
+    @Test("Multiple byte ranges are merged when close together and streamed as multipart/byteranges")
+    func readingMultipleByteRangesProducesMultipartBody() throws {
+        let dir = try makeTestDirectory()
+        defer { removeTestDirectory(dir) }
+
+        let content = makeTestData(byteCount: 1000)
+        let path = try writeTestFile(named: "multi_range.bin", content: content, inDirectory: dir)
+
+        // 0-9 and 20-29 are merged, 500-509 and the last 10 bytes stay separate parts
+        let ranges = [
+            NSValue(range: NSRange(location: 500, length: 10)),
+            NSValue(range: NSRange(location: 0, length: 10)),
+            NSValue(range: NSRange(location: 20, length: 10)),
+            NSValue(range: NSRange(location: Int(bitPattern: UInt.max), length: 10)),
+        ]
+        let response = try #require(DZWebServerFileResponse(file: path, byteRanges: ranges, isAttachment: false))
+
+        #expect(response.statusCode == 206, "Status code should be 206 for multiple byte ranges")
+        let contentType = try #require(response.contentType)
+        #expect(
+            contentType.hasPrefix("multipart/byteranges; boundary="),
+            "Content type should be multipart/byteranges with a boundary"
+        )
+        let boundary = String(contentType.dropFirst("multipart/byteranges; boundary=".count))
+
+        try response.open()
+        var allData = Data()
+        while true {
+            let chunk = try response.readData()
+            if chunk.isEmpty {
+                break
+            }
+            allData.append(chunk)
+        }
+        response.close()
+
+        #expect(
+            allData.count == response.contentLength,
+            "Streamed multipart body should match the announced contentLength"
+        )
+
+        let mimeType = try #require(DZWebServerFileResponse(file: path)?.contentType)
+        var expected = Data()
+        for (location, length) in [(0, 30), (500, 10), (990, 10)] {
+            let header = "\r\n--\(boundary)\r\nContent-Type: \(mimeType)\r\n"
+                + "Content-Range: bytes \(location)-\(location + length - 1)/1000\r\n\r\n"
+            expected.append(Data(header.utf8))
+            expected.append(content[location..<(location + length)])
+        }
+        expected.append(Data("\r\n--\(boundary)--\r\n".utf8))
+        #expect(allData == expected, "Multipart body should contain each merged range in file order")
+    }
+
+    @Test("Multiple byte ranges that are all beyond the file size produce a 416 response")
+    func multipleUnsatisfiableByteRangesReturn416() throws {
+        let dir = try makeTestDirectory()
+        defer { removeTestDirectory(dir) }
+
+        let path = try writeTestFile(named: "multi_416.bin", content: makeTestData(byteCount: 100), inDirectory: dir)
+        let ranges = [
+            NSValue(range: NSRange(location: 100, length: 10)),
+            NSValue(range: NSRange(location: 200, length: 10)),
+        ]
+        let response = try #require(DZWebServerFileResponse(file: path, byteRanges: ranges, isAttachment: false))
+
+        #expect(response.statusCode == 416, "Status code should be 416 when no range is satisfiable")
+        #expect(response.hasBody() == false, "A 416 response should not have a body")
+    }
+
+    @Test("Interleaved reads from two responses for the same file return independent contents")
+    func interleavedReadsForSameFileAreIndependent() throws {
+        let dir = try makeTestDirectory()
+        defer { removeTestDirectory(dir) }
+
+        let content = makeTestData(byteCount: 100_000)
+        let path = try writeTestFile(named: "shared.bin", content: content, inDirectory: dir)
+        let fullResponse = try #require(DZWebServerFileResponse(file: path))
+        let rangeResponse = try #require(
+            DZWebServerFileResponse(file: path, byteRange: NSRange(location: 50000, length: 40000))
+        )
+
+        try fullResponse.open()
+        try rangeResponse.open()
+
+        var fullData = Data()
+        var rangeData = Data()
+        var fullDone = false
+        var rangeDone = false
+        while !fullDone || !rangeDone {
+            if !fullDone {
+                let chunk = try fullResponse.readData()
+                fullDone = chunk.isEmpty
+                fullData.append(chunk)
+            }
+            if !rangeDone {
+                let chunk = try rangeResponse.readData()
+                rangeDone = chunk.isEmpty
+                rangeData.append(chunk)
+            }
+        }
+
+        fullResponse.close()
+        rangeResponse.close()
+
+        #expect(fullData == content, "Full response should read the whole file")
+        #expect(
+            rangeData == Data(content[50000..<90000]),
+            "Range response should read only its own range"
+        )
+    }
+
+    @Test("A file replaced on disk is read from its new contents")
+    func replacedFileIsReadFromNewContents() throws {
+        let dir = try makeTestDirectory()
+        defer { removeTestDirectory(dir) }
+
+        let path = try writeTestFile(named: "replaced.txt", content: Data("old contents".utf8), inDirectory: dir)
+        let oldResponse = try #require(DZWebServerFileResponse(file: path))
+        try oldResponse.open()
+        oldResponse.close()
+
+        try Data("brand new contents".utf8).write(to: URL(fileURLWithPath: path), options: .atomic)
+        let newResponse = try #require(DZWebServerFileResponse(file: path))
+
+        try newResponse.open()
+        var allData = Data()
+        while true {
+            let chunk = try newResponse.readData()
+            if chunk.isEmpty {
+                break
+            }
+            allData.append(chunk)
+        }
+        newResponse.close()
+
+        #expect(String(data: allData, encoding: .utf8) == "brand new contents")
+    }
+}
+
+// MARK: - Precompressed Variants
+
+@Suite("DZWebServerFileResponse - Precompressed Variants", .serialized, .tags(.response, .fileIO))
+struct PrecompressedVariantTests {
+    init() {
+        DZWebServerTestSetup.ensureInitialized()
+    }
+
+    private func makeRequest(acceptEncoding: String?) throws -> DZWebServerRequest {
+        let url = try #require(URL(string: "http://localhost/app.js"))
+        var headers: [String: String] = [:]
+        if let acceptEncoding {
+            headers["Accept-Encoding"] = acceptEncoding
+        }
+        return try #require(DZWebServerRequest(method: "GET", url: url, headers: headers, path: "/app.js", query: nil))
+    }
+
+    private func readAll(_ response: DZWebServerFileResponse) throws -> Data {
+        try response.open()
+        var allData = Data()
+        while true {
+            let chunk = try response.readData()
+            if chunk.isEmpty {
+                break
+            }
+            allData.append(chunk)
+        }
+        response.close()
+        return allData
+    }
+
+    @Test("The variant preferred by Accept-Encoding is served with the original content type")
+    func preferredVariantIsServed() throws {
+        let dir = try makeTestDirectory()
+        defer { removeTestDirectory(dir) }
+
+        let path = try writeTestFile(named: "app.js", content: makeTestData(byteCount: 4096), inDirectory: dir)
+        try writeTestFile(named: "app.js.gz", content: Data("gzip-variant".utf8), inDirectory: dir)
+        try writeTestFile(named: "app.js.br", content: Data("br-variant".utf8), inDirectory: dir)
+
+        let request = try makeRequest(acceptEncoding: "gzip, br;q=0.5")
+        let response = try #require(DZWebServerFileResponse(
+            file: path,
+            byteRange: NSRange(location: Int(bitPattern: UInt.max), length: 0),
+            isAttachment: false,
+            mimeTypeOverrides: nil,
+            precompressedVariantsFor: request
+        ))
+
+        #expect(response.contentType == "text/javascript")
+        #expect(response.contentLength == UInt("gzip-variant".utf8.count))
+        #expect(try readAll(response) == Data("gzip-variant".utf8))
+    }
+
+    @Test("The original file is served when no acceptable variant exists")
+    func originalFileIsServedWithoutAcceptableVariant() throws {
+        let dir = try makeTestDirectory()
+        defer { removeTestDirectory(dir) }
+
+        let content = makeTestData(byteCount: 1000)
+        let path = try writeTestFile(named: "app.js", content: content, inDirectory: dir)
+        try writeTestFile(named: "app.js.br", content: Data("br-variant".utf8), inDirectory: dir)
+
+        for acceptEncoding in [nil, "gzip", "br;q=0"] {
+            let request = try makeRequest(acceptEncoding: acceptEncoding)
+            let response = try #require(DZWebServerFileResponse(
+                file: path,
+                byteRange: NSRange(location: Int(bitPattern: UInt.max), length: 0),
+                isAttachment: false,
+                mimeTypeOverrides: nil,
+                precompressedVariantsFor: request
+            ))
+
+            #expect(response.contentLength == 1000)
+            #expect(try readAll(response) == content)
+        }
+    }
+
+    @Test("A variant older than the original file is ignored")
+    func staleVariantIsIgnored() throws {
+        let dir = try makeTestDirectory()
+        defer { removeTestDirectory(dir) }
+
+        let content = makeTestData(byteCount: 500)
+        let path = try writeTestFile(named: "app.js", content: content, inDirectory: dir)
+        let variantPath = try writeTestFile(named: "app.js.gz", content: Data("stale".utf8), inDirectory: dir)
+        try FileManager.default.setAttributes(
+            [.modificationDate: Date(timeIntervalSinceNow: -3600)],
+            ofItemAtPath: variantPath
+        )
+
+        let request = try makeRequest(acceptEncoding: "gzip")
+        let response = try #require(DZWebServerFileResponse(
+            file: path,
+            byteRange: NSRange(location: Int(bitPattern: UInt.max), length: 0),
+            isAttachment: false,
+            mimeTypeOverrides: nil,
+            precompressedVariantsFor: request
+        ))
+
+        #expect(try readAll(response) == content)
+    }
+
+    @Test("Byte ranges apply to the bytes of the variant")
+    func byteRangeAppliesToVariant() throws {
+        let dir = try makeTestDirectory()
+        defer { removeTestDirectory(dir) }
+
+        let path = try writeTestFile(named: "app.js", content: makeTestData(byteCount: 4096), inDirectory: dir)
+        try writeTestFile(named: "app.js.zst", content: Data("0123456789".utf8), inDirectory: dir)
+
+        let request = try makeRequest(acceptEncoding: "zstd")
+        let response = try #require(DZWebServerFileResponse(
+            file: path,
+            byteRange: NSRange(location: 2, length: 5),
+            isAttachment: false,
+            mimeTypeOverrides: nil,
+            precompressedVariantsFor: request
+        ))
+
+        #expect(response.statusCode == 206)
+        #expect(response.contentLength == 5)
+        #expect(try readAll(response) == Data("23456".utf8))
+    }
 }
@@ -23,6 +23,7 @@ struct InformationalHTTPStatusCodeTests {
             (DZWebServerInformationalHTTPStatusCode.httpStatusCode_Continue, 100, "Continue"),
             (DZWebServerInformationalHTTPStatusCode.httpStatusCode_SwitchingProtocols, 101, "SwitchingProtocols"),
             (DZWebServerInformationalHTTPStatusCode.httpStatusCode_Processing, 102, "Processing"),
+            (DZWebServerInformationalHTTPStatusCode.httpStatusCode_EarlyHints, 103, "EarlyHints"),
         ] as [(DZWebServerInformationalHTTPStatusCode, Int, String)]
     )
     func informationalStatusCodeHasCorrectRawValue(
@@ -42,6 +43,7 @@ struct InformationalHTTPStatusCodeTests {
             DZWebServerInformationalHTTPStatusCode.httpStatusCode_Continue,
             DZWebServerInformationalHTTPStatusCode.httpStatusCode_SwitchingProtocols,
             DZWebServerInformationalHTTPStatusCode.httpStatusCode_Processing,
+            DZWebServerInformationalHTTPStatusCode.httpStatusCode_EarlyHints,
         ]
     )
     func informationalStatusCodeIsInValidRange(
@@ -0,0 +1,135 @@
+//
+//  DZWebServerHybridRequestTests.swift
+//  DZWebServersTests
+//
+//  Created by Dominic Rodemer on 17.10.26.
+//  Copyright © 2026 Dominic Rodemer. All rights reserved.
+//
+
+import Foundation
+import Testing
+@testable import DZWebServers
+
+// MARK: - Helpers
+
+/// Creates a POST hybrid request with the given headers.
+private func makeHybridRequest(headers: [String: String] = [:]) -> DZWebServerHybridRequest {
+    DZWebServerHybridRequest(
+        method: "POST",
+        url: URL(string: "http://localhost/upload")!,
+        headers: headers,
+        path: "/upload",
+        query: nil
+    )
+}
+
+/// Feeds the body to the request in chunks of the given size, as the connection does.
+private func receive(_ body: Data, into request: DZWebServerHybridRequest, chunkSize: Int) throws {
+    try request.open()
+    var offset = 0
+    while offset < body.count {
+        let end = min(offset + chunkSize, body.count)
+        try request.writeData(body.subdata(in: offset..<end))
+        offset = end
+    }
+    try request.close()
+}
+
+// MARK: - Root Suite
+
+@Suite("DZWebServerHybridRequest", .serialized, .tags(.request, .fileIO))
+struct DZWebServerHybridRequestTests {
+    init() {
+        DZWebServerTestSetup.ensureInitialized()
+    }
+
+    @Test("Bodies up to the threshold stay in memory")
+    func smallBodyStaysInMemory() throws {
+        let request = makeHybridRequest()
+        request.memoryThreshold = 16
+        let body = Data("{\"small\":true}".utf8)
+        try receive(body, into: request, chunkSize: 4)
+
+        #expect(request.temporaryPath == nil)
+        #expect(request.data == body)
+    }
+
+    @Test("Bodies growing past the threshold spill to a temporary file")
+    func largeBodySpillsToDisk() throws {
+        let request = makeHybridRequest()
+        request.memoryThreshold = 16
+        let body = Data((0..<100).map { UInt8($0) })
+        try receive(body, into: request, chunkSize: 7)
+
+        let path = try #require(request.temporaryPath)
+        #expect(path.hasPrefix(NSTemporaryDirectory()))
+        #expect(try Data(contentsOf: URL(fileURLWithPath: path)) == body)
+        #expect(request.data == body)
+    }
+
+    @Test("A declared Content-Length above the threshold writes directly to disk")
+    func declaredLengthSpillsImmediately() throws {
+        let request = makeHybridRequest(headers: ["Content-Length": "32", "Content-Type": "application/octet-stream"])
+        request.memoryThreshold = 16
+        try request.open()
+
+        #expect(request.temporaryPath != nil)
+        try request.writeData(Data(repeating: 0x61, count: 32))
+        try request.close()
+        #expect(request.data.count == 32)
+    }
+
+    @Test("inputStream reads the body from memory or from disk")
+    func inputStreamReadsBody() throws {
+        for size in [8, 64] {
+            let request = makeHybridRequest()
+            request.memoryThreshold = 16
+            let body = Data(repeating: 0x62, count: size)
+            try receive(body, into: request, chunkSize: 5)
+
+            let stream = request.inputStream()
+            stream.open()
+            defer { stream.close() }
+            var buffer = [UInt8](repeating: 0, count: 128)
+            let count = stream.read(&buffer, maxLength: buffer.count)
+            #expect(count == size)
+        }
+    }
+
+    @Test("The temporary file is deleted when the request is deallocated")
+    func temporaryFileDeletedOnDeallocation() throws {
+        var path: String?
+        do {
+            let request = makeHybridRequest()
+            request.memoryThreshold = 4
+            try receive(Data("spilled-body".utf8), into: request, chunkSize: 3)
+            path = request.temporaryPath
+        }
+        let spilledPath = try #require(path)
+        #expect(!FileManager.default.fileExists(atPath: spilledPath))
+    }
+
+    @Test("Handlers receive the body through the server")
+    func bodyReceivedThroughServer() async throws {
+        let server = DZWebServer()
+        server.addHandler(
+            match: { method, url, headers, path, query in
+                let request = DZWebServerHybridRequest(method: method, url: url, headers: headers, path: path, query: query)
+                request.memoryThreshold = 8
+                return request
+            },
+            processBlock: { request in
+                let hybridRequest = request as! DZWebServerHybridRequest
+                return DZWebServerDataResponse(text: "\(hybridRequest.temporaryPath != nil):\(hybridRequest.data.count)")
+            }
+        )
+        try server.start(options: [DZWebServerOption_Port: 0, DZWebServerOption_BindToLocalhost: true])
+        defer { server.stop() }
+
+        var urlRequest = URLRequest(url: URL(string: "http://localhost:\(server.port)/upload")!)
+        urlRequest.httpMethod = "POST"
+        urlRequest.httpBody = Data(repeating: 0x63, count: 1000)
+        let (data, _) = try await URLSession.shared.data(for: urlRequest)
+        #expect(String(data: data, encoding: .utf8) == "true:1000")
+    }
+}
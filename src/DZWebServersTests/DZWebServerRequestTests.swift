@@ -422,6 +422,62 @@ struct DZWebServerRequestTests {
         }
     }
 
+    // MARK: - HEAD
+
+    @Suite("HEAD")
+    struct HeadRequest {
+        @Test("HEAD method sets isHeadRequest")
+        func headMethodSetsIsHeadRequest() {
+            #expect(makeRequest(method: "HEAD")?.isHeadRequest == true)
+        }
+
+        @Test("GET method does not set isHeadRequest")
+        func getMethodDoesNotSetIsHeadRequest() {
+            #expect(makeRequest(method: "GET")?.isHeadRequest == false)
+        }
+    }
+
+    // MARK: - Informational Responses
+
+    @Suite("Informational Responses")
+    struct InformationalResponses {
+        @Test("Early hints cannot be sent for a request that is not being processed")
+        func earlyHintsOutsideOfConnectionAreNotSent() {
+            let request = makeRequest()
+            #expect(request?.sendEarlyHints(withLinks: ["</style.css>; rel=preload; as=style"]) == false)
+            #expect(request?.sendInformationalResponse(withStatusCode: 103, headers: nil) == false)
+        }
+    }
+
+    // MARK: - If-Match, If-Unmodified-Since and If-Range
+
+    @Suite("If-Match, If-Unmodified-Since and If-Range")
+    struct OtherPreconditions {
+        @Test("Precondition headers are exposed on the request")
+        func preconditionHeadersArePopulated() {
+            let request = makeRequest(
+                headers: [
+                    "If-Match": "\"a\", \"b\"",
+                    "If-Unmodified-Since": "Sun, 06 Nov 1994 08:49:37 GMT",
+                    "If-Range": "\"a\"",
+                ]
+            )
+
+            #expect(request?.ifMatch == "\"a\", \"b\"")
+            #expect(request?.ifUnmodifiedSince == Date(timeIntervalSince1970: 784_111_777))
+            #expect(request?.ifRange == "\"a\"")
+        }
+
+        @Test("Absent precondition headers result in nil properties")
+        func absentHeadersResultInNil() {
+            let request = makeRequest(headers: [:])
+
+            #expect(request?.ifMatch == nil)
+            #expect(request?.ifUnmodifiedSince == nil)
+            #expect(request?.ifRange == nil)
+        }
+    }
+
     // MARK: - Byte Range
 
     @Suite("Byte Range")
@@ -514,6 +570,29 @@ struct DZWebServerRequestTests {
             #expect(request?.hasByteRange() == false)
         }
 
+        @Test("Multi-range 'bytes=0-99,200-,-50' is exposed through byteRanges")
+        func multiRangeIsParsedIntoByteRanges() {
+            let request = makeRequest(
+                headers: ["Range": "bytes=0-99, 200-,-50"]
+            )
+
+            let ranges = request?.byteRanges?.map { $0.rangeValue }
+            #expect(ranges?.count == 3)
+            #expect(ranges?[0] == NSRange(location: 0, length: 100))
+            #expect(ranges?[1] == NSRange(location: 200, length: Int(bitPattern: UInt.max)))
+            #expect(ranges?[2] == NSRange(location: Int(bitPattern: UInt.max), length: 50))
+        }
+
+        @Test("Multi-range with one invalid range is ignored entirely")
+        func multiRangeWithInvalidRangeIsIgnored() {
+            let request = makeRequest(
+                headers: ["Range": "bytes=0-99,abc"]
+            )
+
+            #expect(request?.byteRanges == nil)
+            #expect(request?.hasByteRange() == false)
+        }
+
         @Test("Range header without 'bytes=' prefix is ignored")
         func rangeWithoutBytesPrefixIsIgnored() {
             let request = makeRequest(
@@ -564,11 +643,12 @@ struct DZWebServerRequestTests {
             #expect(request?.acceptsGzipContentEncoding == false)
         }
 
-        @Test("No Accept-Encoding header defaults acceptsGzipContentEncoding to true")
-        func absentHeaderDefaultsToTrue() {
+        @Test("No Accept-Encoding header leaves acceptsGzipContentEncoding false")
+        func absentHeaderDefaultsToFalse() {
             let request = makeRequest(headers: [:])
 
-            #expect(request?.acceptsGzipContentEncoding == true)
+            #expect(request?.acceptsGzipContentEncoding == false)
+            #expect(request?.preferredContentEncoding(from: ["gzip"]) == nil)
         }
 
         @Test("Accept-Encoding with 'gzip' as part of a list sets acceptsGzipContentEncoding to true")
@@ -579,6 +659,52 @@ struct DZWebServerRequestTests {
 
             #expect(request?.acceptsGzipContentEncoding == true)
         }
+
+        @Test("Accept-Encoding with 'gzip;q=0' sets acceptsGzipContentEncoding to false")
+        func gzipWithZeroQualitySetsFalse() {
+            let request = makeRequest(
+                headers: ["Accept-Encoding": "br, gzip;q=0"]
+            )
+
+            #expect(request?.acceptsGzipContentEncoding == false)
+        }
+
+        @Test("qualityForContentEncoding parses q-values, wildcard and identity")
+        func qualityForContentEncodingParsesQValues() throws {
+            let request = try #require(makeRequest(
+                headers: ["Accept-Encoding": "BR;q=0.5, zstd ; q=0.9, *;q=0.1"]
+            ))
+
+            #expect(request.quality(forContentEncoding: "br") == 0.5)
+            #expect(request.quality(forContentEncoding: "zstd") == 0.9)
+            #expect(request.quality(forContentEncoding: "gzip") == 0.1)
+            #expect(request.quality(forContentEncoding: "identity") == 0.1)
+        }
+
+        @Test("preferredContentEncoding picks the highest q-value and breaks ties by server order")
+        func preferredContentEncodingFollowsQValues() throws {
+            let weighted = try #require(makeRequest(
+                headers: ["Accept-Encoding": "gzip, br;q=0.8"]
+            ))
+            #expect(weighted.preferredContentEncoding(from: ["br", "zstd", "gzip"]) == "gzip")
+
+            let tied = try #require(makeRequest(
+                headers: ["Accept-Encoding": "gzip, deflate, br"]
+            ))
+            #expect(tied.preferredContentEncoding(from: ["br", "zstd", "gzip"]) == "br")
+
+            let excluded = try #require(makeRequest(
+                headers: ["Accept-Encoding": "br;q=0, zstd;q=0"]
+            ))
+            #expect(excluded.preferredContentEncoding(from: ["br", "zstd"]) == nil)
+        }
+
+        @Test("preferredContentEncoding returns nil without an Accept-Encoding header")
+        func preferredContentEncodingWithoutHeaderIsNil() throws {
+            let request = try #require(makeRequest(headers: [:]))
+
+            #expect(request.preferredContentEncoding(from: ["br", "gzip"]) == nil)
+        }
     }
 
     // MARK: - attributeForKey
@@ -660,6 +786,14 @@ struct DZWebServerRequestTests {
 
             try request.close()
         }
+
+        @Test("gzip and deflate are always registered content decodings")
+        func builtInDecodersAreRegistered() {
+            let encodings = DZWebServerRequest.registeredContentEncodings()
+
+            #expect(encodings.contains("gzip"))
+            #expect(encodings.contains("deflate"))
+        }
     }
 
     // MARK: - Description
@@ -330,6 +330,26 @@ struct DZWebServerResponseTests {
             #expect(response.isGZipContentEncodingEnabled == false)
         }
 
+        @Test("contentEncoding and automaticContentEncodingEnabled default to off and are persisted")
+        func settingContentEncoding() {
+            let response = DZWebServerResponse()
+            #expect(response.contentEncoding == nil)
+            #expect(response.isAutomaticContentEncodingEnabled == false)
+
+            response.contentEncoding = "gzip"
+            response.isAutomaticContentEncodingEnabled = true
+
+            #expect(response.contentEncoding == "gzip")
+            #expect(response.isAutomaticContentEncodingEnabled == true)
+        }
+
+        @Test("gzip is always a registered content encoding")
+        func gzipIsRegistered() {
+            let encodings = DZWebServerResponse.registeredContentEncodings()
+
+            #expect(encodings.contains("gzip"))
+        }
+
         @Test("Setting contentLength to a concrete value is persisted")
         func settingContentLength() {
             let response = DZWebServerResponse()
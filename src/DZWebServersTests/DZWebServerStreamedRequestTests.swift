@@ -0,0 +1,159 @@
+//
+//  DZWebServerStreamedRequestTests.swift
+//  DZWebServersTests
+//
+//  Created by Dominic Rodemer on 17.10.26.
+//  Copyright © 2026 Dominic Rodemer. All rights reserved.
+//
+
+import Foundation
+import Testing
+@testable import DZWebServers
+
+// MARK: - Helpers
+
+/// Thread-safe container for the outcome of reading a streamed request body in a handler.
+private final class StreamCapture: @unchecked Sendable {
+    private let lock = NSLock()
+    private var _data = Data()
+    private var _error: NSError?
+
+    var data: Data {
+        lock.lock()
+        defer { lock.unlock() }
+        return _data
+    }
+
+    var error: NSError? {
+        lock.lock()
+        defer { lock.unlock() }
+        return _error
+    }
+
+    func append(_ data: Data) {
+        lock.lock()
+        _data.append(data)
+        lock.unlock()
+    }
+
+    func fail(_ error: NSError) {
+        lock.lock()
+        _error = error
+        lock.unlock()
+    }
+}
+
+/// Reads the whole body of a streamed request, then calls the completion block.
+private func drain(_ request: DZWebServerStreamedRequest, into capture: StreamCapture, completion: @escaping () -> Void) {
+    request.readData { data, error in
+        if let data, !data.isEmpty {
+            capture.append(data)
+            drain(request, into: capture, completion: completion)
+        } else {
+            if let error {
+                capture.fail(error as NSError)
+            }
+            completion()
+        }
+    }
+}
+
+/// Starts a server whose POST /upload handler drains the streamed body and answers with its length.
+private func makeDrainingServer(capture: StreamCapture, options: [String: Any] = [:]) throws -> DZWebServer {
+    let server = DZWebServer()
+    server.addHandler(
+        forMethod: "POST",
+        path: "/upload",
+        request: DZWebServerStreamedRequest.self,
+        asyncProcessBlock: { request, completionBlock in
+            drain(request as! DZWebServerStreamedRequest, into: capture) {
+                completionBlock(DZWebServerDataResponse(text: "\(capture.data.count)"))
+            }
+        }
+    )
+    var allOptions: [String: Any] = [DZWebServerOption_Port: 0, DZWebServerOption_BindToLocalhost: true]
+    allOptions.merge(options) { _, new in new }
+    try server.start(options: allOptions)
+    return server
+}
+
+private func post(to server: DZWebServer, body: Data? = nil, bodyStream: InputStream? = nil) async throws -> (Data, HTTPURLResponse) {
+    var request = URLRequest(url: URL(string: "http://localhost:\(server.port)/upload")!)
+    request.httpMethod = "POST"
+    request.httpBody = body
+    request.httpBodyStream = bodyStream
+    let (data, response) = try await URLSession.shared.data(for: request)
+    return (data, response as! HTTPURLResponse)
+}
+
+// MARK: - Root Suite
+
+@Suite("DZWebServerStreamedRequest", .serialized, .tags(.request, .streaming, .integration))
+struct DZWebServerStreamedRequestTests {
+    init() {
+        DZWebServerTestSetup.ensureInitialized()
+    }
+
+    @Test("Handler reads a Content-Length body incrementally")
+    func readsContentLengthBody() async throws {
+        let capture = StreamCapture()
+        let server = try makeDrainingServer(capture: capture)
+        defer { server.stop() }
+
+        let body = Data((0..<(1024 * 1024)).map { UInt8(truncatingIfNeeded: $0) })
+        let (data, response) = try await post(to: server, body: body)
+
+        #expect(response.statusCode == 200)
+        #expect(String(data: data, encoding: .utf8) == "\(body.count)")
+        #expect(capture.data == body)
+    }
+
+    @Test("Handler reads a chunked body incrementally")
+    func readsChunkedBody() async throws {
+        let capture = StreamCapture()
+        let server = try makeDrainingServer(capture: capture)
+        defer { server.stop() }
+
+        let body = Data(repeating: 0x7A, count: 300_000)
+        let (_, response) = try await post(to: server, bodyStream: InputStream(data: body))
+
+        #expect(response.statusCode == 200)
+        #expect(capture.data == body)
+    }
+
+    @Test("Body size limits are reported to the handler as errors")
+    func bodySizeLimitReportedAsError() async throws {
+        let capture = StreamCapture()
+        let server = try makeDrainingServer(capture: capture, options: [DZWebServerOption_MaxRequestBodySize: 1000])
+        defer { server.stop() }
+
+        _ = try? await post(to: server, bodyStream: InputStream(data: Data(repeating: 0x7A, count: 5000)))  // The server may close the connection before the whole body is sent
+
+        #expect(capture.error?.code == 413)
+        #expect(capture.data.count <= 1000)
+    }
+
+    @Test("Body is passed through to a streamed response")
+    func bodyPassedThroughToStreamedResponse() async throws {
+        let server = DZWebServer()
+        server.addHandler(
+            forMethod: "POST",
+            path: "/upload",
+            request: DZWebServerStreamedRequest.self,
+            asyncProcessBlock: { request, completionBlock in
+                let streamedRequest = request as! DZWebServerStreamedRequest
+                completionBlock(DZWebServerStreamedResponse(contentType: "application/octet-stream", asyncStreamBlock: { block in
+                    streamedRequest.readData(completion: block)
+                }))
+            }
+        )
+        try server.start(options: [DZWebServerOption_Port: 0, DZWebServerOption_BindToLocalhost: true])
+        defer { server.stop() }
+
+        let body = Data((0..<200_000).map { UInt8(truncatingIfNeeded: $0 &* 31) })
+        let (data, response) = try await post(to: server, body: body)
+
+        #expect(response.statusCode == 200)
+        #expect(data == body)
+    }
+}
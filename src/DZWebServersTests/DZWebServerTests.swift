@@ -446,6 +446,51 @@ struct DZWebServerTests {
             #expect(httpResponse.statusCode == 200)
             #expect(String(data: data, encoding: .utf8) == "custom-matched")
         }
+
+        @Test("Handler validator block answers revalidations with 304 without calling the process block")
+        func validatorBlockSkipsProcessBlock() throws {
+            let server = DZWebServer()
+            let processLock = NSLock()
+            var processCalls = 0
+            server.addHandler(
+                match: { method, url, headers, path, query in
+                    DZWebServerRequest(method: method, url: url, headers: headers, path: path, query: query)
+                },
+                validatorBlock: { _ in
+                    let validators = DZWebServerResponse()
+                    validators.eTag = "\"v1\""
+                    return validators
+                },
+                asyncProcessBlock: { _, completionBlock in
+                    processLock.lock()
+                    processCalls += 1
+                    processLock.unlock()
+                    let response = DZWebServerDataResponse(text: "generated")
+                    response?.eTag = "\"v1\""
+                    completionBlock(response)
+                }
+            )
+
+            try server.start(options: localhostOptions)
+            defer { server.stop() }
+
+            let (_, notModified) = try awaitData(
+                for: request(for: server, path: "resource", headers: ["If-None-Match": "\"v1\""])
+            )
+            #expect((notModified as? HTTPURLResponse)?.statusCode == 304)
+            processLock.lock()
+            #expect(processCalls == 0)
+            processLock.unlock()
+
+            let (data, modified) = try awaitData(
+                for: request(for: server, path: "resource", headers: ["If-None-Match": "\"v0\""])
+            )
+            #expect((modified as? HTTPURLResponse)?.statusCode == 200)
+            #expect(String(data: data, encoding: .utf8) == "generated")
+            processLock.lock()
+            #expect(processCalls == 1)
+            processLock.unlock()
+        }
     }
 
     // MARK: - HTTP Methods
@@ -506,6 +551,325 @@ struct DZWebServerTests {
             #expect(String(data: data, encoding: .utf8) == "received:payload")
         }
 
+        @Test("Request body larger than the maximum size is rejected with 413")
+        func oversizedRequestBodyRejected() throws {
+            let server = DZWebServer()
+            let processLock = NSLock()
+            var processCalls = 0
+            server.addHandler(
+                forMethod: "POST",
+                path: "/limited",
+                request: DZWebServerDataRequest.self,
+                processBlock: { _ in
+                    processLock.lock()
+                    processCalls += 1
+                    processLock.unlock()
+                    return DZWebServerResponse(statusCode: 204)
+                }
+            )
+
+            var options = localhostOptions
+            options[DZWebServerOption_MaxRequestBodySize] = 4
+            try server.start(options: options)
+            defer { server.stop() }
+
+            let (_, response) = try awaitData(
+                for: request(for: server, method: "POST", path: "limited", body: Data("too-large".utf8))
+            )
+            #expect((response as? HTTPURLResponse)?.statusCode == 413)
+            processLock.lock()
+            #expect(processCalls == 0)
+            processLock.unlock()
+        }
+
+        @Test("Body acceptance block rejects a body before it is received")
+        func bodyAcceptanceBlockRejectsBody() throws {
+            let server = DZWebServer()
+            let processLock = NSLock()
+            var processCalls = 0
+            server.addHandler(
+                match: { method, url, headers, path, query in
+                    DZWebServerDataRequest(method: method, url: url, headers: headers, path: path, query: query)
+                },
+                bodyAcceptanceBlock: { request in
+                    request.contentType == "application/json" ? nil : DZWebServerErrorResponse(clientError: .httpStatusCode_UnsupportedMediaType, message: "JSON only")
+                },
+                validatorBlock: nil,
+                asyncProcessBlock: { _, completionBlock in
+                    processLock.lock()
+                    processCalls += 1
+                    processLock.unlock()
+                    completionBlock(DZWebServerResponse(statusCode: 204))
+                }
+            )
+
+            try server.start(options: localhostOptions)
+            defer { server.stop() }
+
+            let (_, rejected) = try awaitData(
+                for: request(for: server, method: "POST", path: "upload", body: Data("text".utf8), headers: ["Content-Type": "text/plain"])
+            )
+            #expect((rejected as? HTTPURLResponse)?.statusCode == 415)
+            processLock.lock()
+            #expect(processCalls == 0)
+            processLock.unlock()
+
+            let (_, accepted) = try awaitData(
+                for: request(for: server, method: "POST", path: "upload", body: Data("{}".utf8), headers: ["Content-Type": "application/json"])
+            )
+            #expect((accepted as? HTTPURLResponse)?.statusCode == 204)
+            processLock.lock()
+            #expect(processCalls == 1)
+            processLock.unlock()
+        }
+
+        @Test("Body acceptance block rejection reaches the client while the body is still being sent")
+        func bodyAcceptanceRejectionOfLargeBodyIsDelivered() throws {
+            let server = DZWebServer()
+            server.addHandler(
+                match: { method, url, headers, path, query in
+                    DZWebServerDataRequest(method: method, url: url, headers: headers, path: path, query: query)
+                },
+                bodyAcceptanceBlock: { _ in
+                    DZWebServerErrorResponse(clientError: .httpStatusCode_Forbidden, message: "Uploads disabled")
+                },
+                validatorBlock: nil,
+                asyncProcessBlock: { _, completionBlock in
+                    completionBlock(DZWebServerResponse(statusCode: 204))
+                }
+            )
+
+            try server.start(options: localhostOptions)
+            defer { server.stop() }
+
+            let body = Data(repeating: 0x61, count: 512 * 1024)  // Larger than socket buffers, so part of it is unread when the response is sent
+            let (_, response) = try awaitData(
+                for: request(for: server, method: "POST", path: "upload", body: body, headers: ["Content-Type": "text/plain"])
+            )
+            #expect((response as? HTTPURLResponse)?.statusCode == 403)
+        }
+
+        @Test("Per-request body size limit set by the match block overrides the server limit")
+        func perRequestBodySizeLimit() throws {
+            let server = DZWebServer()
+            server.addHandler(
+                match: { method, url, headers, path, query in
+                    let request = DZWebServerDataRequest(method: method, url: url, headers: headers, path: path, query: query)
+                    request.maximumBodySize = path == "/small" ? 4 : 0
+                    return request
+                },
+                processBlock: { _ in
+                    DZWebServerResponse(statusCode: 204)
+                }
+            )
+
+            var options = localhostOptions
+            options[DZWebServerOption_MaxRequestBodySize] = 64
+            try server.start(options: options)
+            defer { server.stop() }
+
+            let (_, small) = try awaitData(
+                for: request(for: server, method: "POST", path: "small", body: Data("too-large".utf8))
+            )
+            #expect((small as? HTTPURLResponse)?.statusCode == 413)
+
+            let (_, large) = try awaitData(
+                for: request(for: server, method: "POST", path: "large", body: Data("too-large".utf8))
+            )
+            #expect((large as? HTTPURLResponse)?.statusCode == 204)
+        }
+
+        @Test("Request bodies exceeding the buffered body budget are rejected with 503")
+        func bufferedRequestBodyBudget() throws {
+            let server = DZWebServer()
+            server.addHandler(
+                forMethod: "POST",
+                path: "/upload",
+                request: DZWebServerDataRequest.self,
+                processBlock: { _ in
+                    DZWebServerResponse(statusCode: 204)
+                }
+            )
+
+            var options = localhostOptions
+            options[DZWebServerOption_MaxBufferedRequestBodySize] = 8
+            try server.start(options: options)
+            defer { server.stop() }
+
+            let (_, rejected) = try awaitData(
+                for: request(for: server, method: "POST", path: "upload", body: Data(repeating: 0x61, count: 16))
+            )
+            #expect((rejected as? HTTPURLResponse)?.statusCode == 503)
+
+            let (_, accepted) = try awaitData(
+                for: request(for: server, method: "POST", path: "upload", body: Data("small".utf8))
+            )
+            #expect((accepted as? HTTPURLResponse)?.statusCode == 204)
+        }
+
+        @Test("Buffered body budget counts decoded bytes")
+        func bufferedRequestBodyBudgetCountsDecodedBytes() throws {
+            let server = DZWebServer()
+            server.addHandler(
+                forMethod: "POST",
+                path: "/upload",
+                request: DZWebServerDataRequest.self,
+                processBlock: { _ in
+                    DZWebServerResponse(statusCode: 204)
+                }
+            )
+
+            var options = localhostOptions
+            options[DZWebServerOption_MaxBufferedRequestBodySize] = 16 * 1024
+            try server.start(options: options)
+            defer { server.stop() }
+
+            let body = try gzipData(Data(count: 1024 * 1024))
+            #expect(body.count < 16 * 1024)
+            var urlRequest = try URLRequest(url: #require(server.serverURL?.appendingPathComponent("upload")))
+            urlRequest.httpMethod = "POST"
+            urlRequest.httpBody = body
+            urlRequest.setValue("application/octet-stream", forHTTPHeaderField: "Content-Type")
+            urlRequest.setValue("gzip", forHTTPHeaderField: "Content-Encoding")
+
+            let (_, response) = try awaitData(for: urlRequest)
+            #expect((response as? HTTPURLResponse)?.statusCode == 503)
+        }
+
+        @Test("gzip-encoded request bodies are decoded across reused streams")
+        func gzipEncodedRequestBody() throws {
+            let server = DZWebServer()
+            server.addHandler(
+                forMethod: "POST",
+                path: "/upload",
+                request: DZWebServerDataRequest.self,
+                processBlock: { request in
+                    let dataRequest = request as! DZWebServerDataRequest
+                    return DZWebServerDataResponse(data: dataRequest.data, contentType: "application/octet-stream")
+                }
+            )
+
+            try server.start(options: localhostOptions)
+            defer { server.stop() }
+
+            for index in 0 ..< 3 {
+                let payload = Data(String(repeating: "payload \(index) ", count: 5000).utf8)
+                var urlRequest = try URLRequest(url: #require(server.serverURL?.appendingPathComponent("upload")))
+                urlRequest.httpMethod = "POST"
+                urlRequest.httpBody = try gzipData(payload)
+                urlRequest.setValue("application/octet-stream", forHTTPHeaderField: "Content-Type")
+                urlRequest.setValue("gzip", forHTTPHeaderField: "Content-Encoding")
+
+                let (data, response) = try awaitData(for: urlRequest)
+                let httpResponse = try #require(response as? HTTPURLResponse)
+                #expect(httpResponse.statusCode == 200)
+                #expect(data == payload)
+            }
+        }
+
+        @Test("Stacked content codings are decoded in reverse order")
+        func stackedEncodedRequestBody() throws {
+            let server = DZWebServer()
+            server.addHandler(
+                forMethod: "POST",
+                path: "/upload",
+                request: DZWebServerDataRequest.self,
+                processBlock: { request in
+                    let dataRequest = request as! DZWebServerDataRequest
+                    return DZWebServerDataResponse(data: dataRequest.data, contentType: "application/octet-stream")
+                }
+            )
+
+            try server.start(options: localhostOptions)
+            defer { server.stop() }
+
+            let payload = Data(String(repeating: "telemetry ", count: 2000).utf8)
+            let rawDeflate = try (payload as NSData).compressed(using: .zlib) as Data
+            for (encoding, body) in [("deflate", rawDeflate), ("deflate, gzip", try gzipData(rawDeflate))] {
+                var urlRequest = try URLRequest(url: #require(server.serverURL?.appendingPathComponent("upload")))
+                urlRequest.httpMethod = "POST"
+                urlRequest.httpBody = body
+                urlRequest.setValue("application/octet-stream", forHTTPHeaderField: "Content-Type")
+                urlRequest.setValue(encoding, forHTTPHeaderField: "Content-Encoding")
+
+                let (data, response) = try awaitData(for: urlRequest)
+                let httpResponse = try #require(response as? HTTPURLResponse)
+                #expect(httpResponse.statusCode == 200)
+                #expect(data == payload)
+            }
+        }
+
+        @Test("Oversized decoded bodies are rejected")
+        func rejectedEncodedRequestBody() throws {
+            let server = DZWebServer()
+            server.addHandler(
+                forMethod: "POST",
+                path: "/upload",
+                request: DZWebServerDataRequest.self,
+                processBlock: { _ in
+                    DZWebServerResponse(statusCode: 204)
+                }
+            )
+
+            var options = localhostOptions
+            options[DZWebServerOption_MaxDecodedBodySize] = 64 * 1024
+            try server.start(options: options)
+            defer { server.stop() }
+
+            var urlRequest = try URLRequest(url: #require(server.serverURL?.appendingPathComponent("upload")))
+            urlRequest.httpMethod = "POST"
+            urlRequest.httpBody = try gzipData(Data(count: 4 * 1024 * 1024))
+            urlRequest.setValue("application/octet-stream", forHTTPHeaderField: "Content-Type")
+            urlRequest.setValue("gzip", forHTTPHeaderField: "Content-Encoding")
+
+            let (_, response) = try awaitData(for: urlRequest)
+            let httpResponse = try #require(response as? HTTPURLResponse)
+            #expect(httpResponse.statusCode == 413)
+        }
+
+        @Test(
+            "zstd bodies pass through undecoded until a decoder is registered",
+            .enabled(if: !DZWebServerRequest.registeredContentEncodings().contains("zstd"))
+        )
+        func unregisteredContentEncodingPassesThrough() throws {
+            let server = DZWebServer()
+            server.addHandler(
+                forMethod: "POST",
+                path: "/telemetry",
+                request: DZWebServerDataRequest.self,
+                processBlock: { request in
+                    let dataRequest = request as! DZWebServerDataRequest
+                    let response = DZWebServerDataResponse(data: dataRequest.data, contentType: "application/octet-stream")
+                    response.setValue(request.headers["Content-Encoding"], forAdditionalHeader: "X-Received-Encoding")
+                    return response
+                }
+            )
+
+            try server.start(options: localhostOptions)
+            defer { server.stop() }
+
+            let payload = Data("telemetry sample".utf8)
+            let frame = Data([0x28, 0xB5, 0x2F, 0xFD]) + payload
+            var urlRequest = try URLRequest(url: #require(server.serverURL?.appendingPathComponent("telemetry")))
+            urlRequest.httpMethod = "POST"
+            urlRequest.httpBody = frame
+            urlRequest.setValue("application/octet-stream", forHTTPHeaderField: "Content-Type")
+            urlRequest.setValue("zstd", forHTTPHeaderField: "Content-Encoding")
+
+            let (rawData, rawResponse) = try awaitData(for: urlRequest)
+            let rawHTTPResponse = try #require(rawResponse as? HTTPURLResponse)
+            #expect(rawHTTPResponse.statusCode == 200)
+            #expect(rawHTTPResponse.value(forHTTPHeaderField: "X-Received-Encoding") == "zstd")
+            #expect(rawData == frame)
+
+            DZWebServerRequest.registerContentEncoding("zstd") { writer in
+                FrameHeaderStrippingDecoder(writer: writer)
+            }
+            let (decodedData, decodedResponse) = try awaitData(for: urlRequest)
+            #expect((decodedResponse as? HTTPURLResponse)?.statusCode == 200)
+            #expect(decodedData == payload)
+        }
+
         @Test("PUT request is handled correctly")
         func putRequestHandled() throws {
             let server = DZWebServer()
@@ -581,6 +945,55 @@ struct DZWebServerTests {
             #expect(httpResponse.statusCode == 200)
             #expect(data.isEmpty)
         }
+
+        @Test("HEAD-aware handler answers with a metadata-only response")
+        func headAwareHandlerReturnsMetadataOnlyResponse() throws {
+            let server = DZWebServer()
+            server.addHandler(
+                forMethod: "GET",
+                path: "/report",
+                request: DZWebServerRequest.self,
+                processBlock: { request in
+                    if request.isHeadRequest {
+                        return DZWebServerResponse(contentType: "text/plain", contentLength: 12)
+                    }
+                    return DZWebServerDataResponse(text: "body-content")
+                }
+            )
+
+            try server.start(options: localhostOptions)
+            defer { server.stop() }
+
+            let (headData, headResponse) = try awaitData(for: request(for: server, method: "HEAD", path: "report"))
+            let headHTTPResponse = try #require(headResponse as? HTTPURLResponse)
+            #expect(headHTTPResponse.statusCode == 200)
+            #expect(headHTTPResponse.value(forHTTPHeaderField: "Content-Length") == "12")
+            #expect(headHTTPResponse.value(forHTTPHeaderField: "Content-Type")?.hasPrefix("text/plain") == true)
+            #expect(headData.isEmpty)
+
+            let (getData, getResponse) = try awaitData(for: request(for: server, path: "report"))
+            #expect((getResponse as? HTTPURLResponse)?.statusCode == 200)
+            #expect(String(data: getData, encoding: .utf8) == "body-content")
+        }
+
+        @Test("Metadata-only response returned for GET produces 500")
+        func metadataOnlyResponseForGETProduces500() throws {
+            let server = DZWebServer()
+            server.addHandler(
+                forMethod: "GET",
+                path: "/broken",
+                request: DZWebServerRequest.self,
+                processBlock: { _ in
+                    DZWebServerResponse(contentType: "text/plain", contentLength: 12)
+                }
+            )
+
+            try server.start(options: localhostOptions)
+            defer { server.stop() }
+
+            let (_, response) = try awaitData(for: request(for: server, path: "broken"))
+            #expect((response as? HTTPURLResponse)?.statusCode == 500)
+        }
     }
 
     // MARK: - GET Handlers
@@ -634,50 +1047,260 @@ struct DZWebServerTests {
             try server.start(options: localhostOptions)
             defer { server.stop() }
 
-            let (data, response) = try awaitData(
-                from: #require(server.serverURL?.appendingPathComponent("file"))
-            )
-            let httpResponse = try #require(response as? HTTPURLResponse)
+            let (data, response) = try awaitData(
+                from: #require(server.serverURL?.appendingPathComponent("file"))
+            )
+            let httpResponse = try #require(response as? HTTPURLResponse)
+
+            #expect(httpResponse.statusCode == 200)
+            #expect(String(data: data, encoding: .utf8) == fileContent)
+        }
+
+        @Test("File path handler with attachment sets Content-Disposition header")
+        func filePathHandlerAttachmentSetsContentDisposition() throws {
+            let server = DZWebServer()
+            let tempDir = NSTemporaryDirectory()
+            let filePath = (tempDir as NSString).appendingPathComponent("dz_attachment.txt")
+
+            try "attachment-content".write(toFile: filePath, atomically: true, encoding: .utf8)
+            defer { try? FileManager.default.removeItem(atPath: filePath) }
+
+            server.addGETHandler(
+                forPath: "/download",
+                filePath: filePath,
+                isAttachment: true,
+                cacheAge: 0,
+                allowRangeRequests: false
+            )
+
+            try server.start(options: localhostOptions)
+            defer { server.stop() }
+
+            let (_, response) = try awaitData(
+                from: #require(server.serverURL?.appendingPathComponent("download"))
+            )
+            let httpResponse = try #require(response as? HTTPURLResponse)
+
+            #expect(httpResponse.statusCode == 200)
+            let disposition = httpResponse.value(forHTTPHeaderField: "Content-Disposition")
+            #expect(disposition?.contains("attachment") == true)
+        }
+
+        @Test("File path handler honors If-Range, If-Match and If-None-Match lists")
+        func filePathHandlerConditionalRequests() throws {
+            let server = DZWebServer()
+            let filePath = (NSTemporaryDirectory() as NSString).appendingPathComponent("dz_conditional.txt")
+            let fileContent = String(repeating: "0123456789", count: 10)
+
+            try fileContent.write(toFile: filePath, atomically: true, encoding: .utf8)
+            defer { try? FileManager.default.removeItem(atPath: filePath) }
+
+            server.addGETHandler(
+                forPath: "/resume",
+                filePath: filePath,
+                isAttachment: false,
+                cacheAge: 0,
+                allowRangeRequests: true
+            )
+
+            try server.start(options: localhostOptions)
+            defer { server.stop() }
+
+            let (_, firstResponse) = try awaitData(for: request(for: server, path: "resume"))
+            let eTag = try #require((firstResponse as? HTTPURLResponse)?.value(forHTTPHeaderField: "ETag"))
+
+            let (resumedData, resumedResponse) = try awaitData(
+                for: request(for: server, path: "resume", headers: ["Range": "bytes=90-", "If-Range": eTag])
+            )
+            #expect((resumedResponse as? HTTPURLResponse)?.statusCode == 206)
+            #expect(String(data: resumedData, encoding: .utf8) == "0123456789")
+
+            let (staleData, staleResponse) = try awaitData(
+                for: request(for: server, path: "resume", headers: ["Range": "bytes=90-", "If-Range": "\"stale\""])
+            )
+            #expect((staleResponse as? HTTPURLResponse)?.statusCode == 200)
+            #expect(String(data: staleData, encoding: .utf8) == fileContent)
+
+            let (_, failedResponse) = try awaitData(
+                for: request(for: server, path: "resume", headers: ["If-Match": "\"other\""])
+            )
+            #expect((failedResponse as? HTTPURLResponse)?.statusCode == 412)
+
+            let (_, notModifiedResponse) = try awaitData(
+                for: request(for: server, path: "resume", headers: ["If-None-Match": "\"other\", \(eTag)"])
+            )
+            #expect((notModifiedResponse as? HTTPURLResponse)?.statusCode == 304)
+        }
+
+        @Test("Directory handler serves files from directory")
+        func directoryHandlerServesFiles() throws {
+            let server = DZWebServer()
+            let tempDir = (NSTemporaryDirectory() as NSString)
+                .appendingPathComponent("dz_dir_test")
+
+            try FileManager.default.createDirectory(
+                atPath: tempDir,
+                withIntermediateDirectories: true,
+                attributes: nil
+            )
+            defer { try? FileManager.default.removeItem(atPath: tempDir) }
+
+            let innerFilePath = (tempDir as NSString).appendingPathComponent("hello.txt")
+            try "dir-file-content".write(toFile: innerFilePath, atomically: true, encoding: .utf8)
+
+            server.addGETHandler(
+                forBasePath: "/files/",
+                directoryPath: tempDir,
+                indexFilename: nil,
+                cacheAge: 0,
+                allowRangeRequests: false
+            )
+
+            try server.start(options: localhostOptions)
+            defer { server.stop() }
+
+            let (data, response) = try awaitData(
+                from: #require(server.serverURL?.appendingPathComponent("files/hello.txt"))
+            )
+            let httpResponse = try #require(response as? HTTPURLResponse)
+
+            #expect(httpResponse.statusCode == 200)
+            #expect(String(data: data, encoding: .utf8) == "dir-file-content")
+        }
+
+        @Test("Directory handler serves index file when configured")
+        func directoryHandlerServesIndexFile() throws {
+            let server = DZWebServer()
+            let tempDir = (NSTemporaryDirectory() as NSString)
+                .appendingPathComponent("dz_index_test")
+
+            try FileManager.default.createDirectory(
+                atPath: tempDir,
+                withIntermediateDirectories: true,
+                attributes: nil
+            )
+            defer { try? FileManager.default.removeItem(atPath: tempDir) }
+
+            let indexPath = (tempDir as NSString).appendingPathComponent("index.html")
+            try "<html>Index</html>".write(toFile: indexPath, atomically: true, encoding: .utf8)
+
+            server.addGETHandler(
+                forBasePath: "/site/",
+                directoryPath: tempDir,
+                indexFilename: "index.html",
+                cacheAge: 0,
+                allowRangeRequests: false
+            )
+
+            try server.start(options: localhostOptions)
+            defer { server.stop() }
+
+            let (data, response) = try awaitData(
+                from: #require(server.serverURL?.appendingPathComponent("site/"))
+            )
+            let httpResponse = try #require(response as? HTTPURLResponse)
+
+            #expect(httpResponse.statusCode == 200)
+            #expect(String(data: data, encoding: .utf8) == "<html>Index</html>")
+        }
+
+        @Test("Directory handler answers HEAD on a listing with the same Content-Length as GET")
+        func directoryHandlerHeadListingMatchesGet() throws {
+            let server = DZWebServer()
+            let tempDir = (NSTemporaryDirectory() as NSString)
+                .appendingPathComponent("dz_head_listing_test")
+
+            try FileManager.default.createDirectory(
+                atPath: tempDir,
+                withIntermediateDirectories: true,
+                attributes: nil
+            )
+            defer { try? FileManager.default.removeItem(atPath: tempDir) }
+
+            try "content".write(
+                toFile: (tempDir as NSString).appendingPathComponent("file.txt"),
+                atomically: true,
+                encoding: .utf8
+            )
+
+            server.addGETHandler(
+                forBasePath: "/site/",
+                directoryPath: tempDir,
+                indexFilename: nil,
+                cacheAge: 0,
+                allowRangeRequests: false
+            )
+
+            try server.start(options: localhostOptions)
+            defer { server.stop() }
+
+            let (getData, getResponse) = try awaitData(for: request(for: server, path: "site/"))
+            let getHTTPResponse = try #require(getResponse as? HTTPURLResponse)
+            let (headData, headResponse) = try awaitData(for: request(for: server, method: "HEAD", path: "site/"))
+            let headHTTPResponse = try #require(headResponse as? HTTPURLResponse)
 
-            #expect(httpResponse.statusCode == 200)
-            #expect(String(data: data, encoding: .utf8) == fileContent)
+            #expect(headHTTPResponse.statusCode == 200)
+            #expect(headHTTPResponse.value(forHTTPHeaderField: "Transfer-Encoding") == nil)
+            #expect(headHTTPResponse.value(forHTTPHeaderField: "Content-Length") == "\(getData.count)")
+            #expect(getHTTPResponse.value(forHTTPHeaderField: "Content-Length") == "\(getData.count)")
+            #expect(headData.isEmpty)
         }
 
-        @Test("File path handler with attachment sets Content-Disposition header")
-        func filePathHandlerAttachmentSetsContentDisposition() throws {
+        @Test("Directory handler with file cache serves cached contents and picks up modifications")
+        func directoryHandlerFileCacheRevalidates() throws {
             let server = DZWebServer()
-            let tempDir = NSTemporaryDirectory()
-            let filePath = (tempDir as NSString).appendingPathComponent("dz_attachment.txt")
+            let tempDir = (NSTemporaryDirectory() as NSString)
+                .appendingPathComponent("dz_file_cache_test")
 
-            try "attachment-content".write(toFile: filePath, atomically: true, encoding: .utf8)
-            defer { try? FileManager.default.removeItem(atPath: filePath) }
+            try FileManager.default.createDirectory(
+                atPath: tempDir,
+                withIntermediateDirectories: true,
+                attributes: nil
+            )
+            defer { try? FileManager.default.removeItem(atPath: tempDir) }
+
+            let innerFilePath = (tempDir as NSString).appendingPathComponent("cached.txt")
+            try "first".write(toFile: innerFilePath, atomically: true, encoding: .utf8)
 
             server.addGETHandler(
-                forPath: "/download",
-                filePath: filePath,
-                isAttachment: true,
+                forBasePath: "/files/",
+                directoryPath: tempDir,
+                indexFilename: nil,
                 cacheAge: 0,
-                allowRangeRequests: false
+                allowRangeRequests: true
             )
 
-            try server.start(options: localhostOptions)
+            var options = localhostOptions
+            options[DZWebServerOption_MaxFileCacheSize] = 1024 * 1024
+            try server.start(options: options)
             defer { server.stop() }
 
-            let (_, response) = try awaitData(
-                from: #require(server.serverURL?.appendingPathComponent("download"))
+            let url = try #require(server.serverURL?.appendingPathComponent("files/cached.txt"))
+
+            let (data1, response1) = try awaitData(from: url)
+            let (data2, response2) = try awaitData(from: url)
+            let httpResponse1 = try #require(response1 as? HTTPURLResponse)
+            let httpResponse2 = try #require(response2 as? HTTPURLResponse)
+
+            #expect(String(data: data1, encoding: .utf8) == "first")
+            #expect(String(data: data2, encoding: .utf8) == "first")
+            #expect(httpResponse2.value(forHTTPHeaderField: "ETag") != nil)
+            #expect(
+                httpResponse1.value(forHTTPHeaderField: "ETag") == httpResponse2.value(forHTTPHeaderField: "ETag")
             )
-            let httpResponse = try #require(response as? HTTPURLResponse)
+            #expect(httpResponse2.value(forHTTPHeaderField: "Accept-Ranges") == "bytes")
 
-            #expect(httpResponse.statusCode == 200)
-            let disposition = httpResponse.value(forHTTPHeaderField: "Content-Disposition")
-            #expect(disposition?.contains("attachment") == true)
+            try "second-version".write(toFile: innerFilePath, atomically: true, encoding: .utf8)
+
+            let (data3, _) = try awaitData(from: url)
+            #expect(String(data: data3, encoding: .utf8) == "second-version")
         }
 
-        @Test("Directory handler serves files from directory")
-        func directoryHandlerServesFiles() throws {
+        @Test("Directory handler serves a file created after a previous 404 for the same path")
+        func directoryHandlerNegativeLookupIsInvalidated() throws {
             let server = DZWebServer()
             let tempDir = (NSTemporaryDirectory() as NSString)
-                .appendingPathComponent("dz_dir_test")
+                .appendingPathComponent("dz_negative_lookup_test")
 
             try FileManager.default.createDirectory(
                 atPath: tempDir,
@@ -686,9 +1309,6 @@ struct DZWebServerTests {
             )
             defer { try? FileManager.default.removeItem(atPath: tempDir) }
 
-            let innerFilePath = (tempDir as NSString).appendingPathComponent("hello.txt")
-            try "dir-file-content".write(toFile: innerFilePath, atomically: true, encoding: .utf8)
-
             server.addGETHandler(
                 forBasePath: "/files/",
                 directoryPath: tempDir,
@@ -700,35 +1320,51 @@ struct DZWebServerTests {
             try server.start(options: localhostOptions)
             defer { server.stop() }
 
-            let (data, response) = try awaitData(
-                from: #require(server.serverURL?.appendingPathComponent("files/hello.txt"))
+            let url = try #require(server.serverURL?.appendingPathComponent("files/sub/late.txt"))
+
+            for _ in 0..<2 {
+                let (_, response) = try awaitData(from: url)
+                let httpResponse = try #require(response as? HTTPURLResponse)
+                #expect(httpResponse.statusCode == 404)
+            }
+
+            let subDir = (tempDir as NSString).appendingPathComponent("sub")
+            try FileManager.default.createDirectory(atPath: subDir, withIntermediateDirectories: true, attributes: nil)
+            try "late-content".write(
+                toFile: (subDir as NSString).appendingPathComponent("late.txt"),
+                atomically: true,
+                encoding: .utf8
             )
-            let httpResponse = try #require(response as? HTTPURLResponse)
 
+            let (data, response) = try awaitData(from: url)
+            let httpResponse = try #require(response as? HTTPURLResponse)
             #expect(httpResponse.statusCode == 200)
-            #expect(String(data: data, encoding: .utf8) == "dir-file-content")
+            #expect(String(data: data, encoding: .utf8) == "late-content")
         }
 
-        @Test("Directory handler serves index file when configured")
-        func directoryHandlerServesIndexFile() throws {
+        @Test("Directory handler serves a file created behind a symlinked directory after a 404")
+        func directoryHandlerNegativeLookupFollowsSymlinks() throws {
             let server = DZWebServer()
             let tempDir = (NSTemporaryDirectory() as NSString)
-                .appendingPathComponent("dz_index_test")
-
-            try FileManager.default.createDirectory(
-                atPath: tempDir,
-                withIntermediateDirectories: true,
-                attributes: nil
+                .appendingPathComponent("dz_negative_lookup_symlink_test")
+            let targetDir = (NSTemporaryDirectory() as NSString)
+                .appendingPathComponent("dz_negative_lookup_symlink_target")
+
+            try FileManager.default.createDirectory(atPath: tempDir, withIntermediateDirectories: true, attributes: nil)
+            try FileManager.default.createDirectory(atPath: targetDir, withIntermediateDirectories: true, attributes: nil)
+            defer {
+                try? FileManager.default.removeItem(atPath: tempDir)
+                try? FileManager.default.removeItem(atPath: targetDir)
+            }
+            try FileManager.default.createSymbolicLink(
+                atPath: (tempDir as NSString).appendingPathComponent("link"),
+                withDestinationPath: targetDir
             )
-            defer { try? FileManager.default.removeItem(atPath: tempDir) }
-
-            let indexPath = (tempDir as NSString).appendingPathComponent("index.html")
-            try "<html>Index</html>".write(toFile: indexPath, atomically: true, encoding: .utf8)
 
             server.addGETHandler(
-                forBasePath: "/site/",
+                forBasePath: "/files/",
                 directoryPath: tempDir,
-                indexFilename: "index.html",
+                indexFilename: nil,
                 cacheAge: 0,
                 allowRangeRequests: false
             )
@@ -736,13 +1372,22 @@ struct DZWebServerTests {
             try server.start(options: localhostOptions)
             defer { server.stop() }
 
-            let (data, response) = try awaitData(
-                from: #require(server.serverURL?.appendingPathComponent("site/"))
+            let url = try #require(server.serverURL?.appendingPathComponent("files/link/late.txt"))
+
+            for _ in 0..<2 {
+                let (_, response) = try awaitData(from: url)
+                #expect((response as? HTTPURLResponse)?.statusCode == 404)
+            }
+
+            try "late-content".write(
+                toFile: (targetDir as NSString).appendingPathComponent("late.txt"),
+                atomically: true,
+                encoding: .utf8
             )
-            let httpResponse = try #require(response as? HTTPURLResponse)
 
-            #expect(httpResponse.statusCode == 200)
-            #expect(String(data: data, encoding: .utf8) == "<html>Index</html>")
+            let (data, response) = try awaitData(from: url)
+            #expect((response as? HTTPURLResponse)?.statusCode == 200)
+            #expect(String(data: data, encoding: .utf8) == "late-content")
         }
 
         @Test("Static data handler with cacheAge sets Cache-Control header")
@@ -768,6 +1413,139 @@ struct DZWebServerTests {
             let cacheControl = httpResponse.value(forHTTPHeaderField: "Cache-Control")
             #expect(cacheControl?.contains("max-age=3600") == true)
         }
+
+        @Test("Static data handler sends prebuilt headers with an ETag")
+        func staticDataHandlerPrebuiltHeaders() throws {
+            let server = DZWebServer()
+            server.addGETHandler(
+                forPath: "/prebuilt",
+                staticData: "abc".data(using: .utf8)!,
+                contentType: "text/plain",
+                cacheAge: 60
+            )
+
+            try server.start(options: localhostOptions)
+            defer { server.stop() }
+
+            let (data, response) = try awaitData(for: request(for: server, path: "prebuilt"))
+            let httpResponse = try #require(response as? HTTPURLResponse)
+            #expect(httpResponse.statusCode == 200)
+            #expect(String(data: data, encoding: .utf8) == "abc")
+            #expect(httpResponse.value(forHTTPHeaderField: "Content-Length") == "3")
+            #expect(httpResponse.value(forHTTPHeaderField: "ETag") == "\"44bc2cf5ad770999\"")
+            #expect(httpResponse.value(forHTTPHeaderField: "Cache-Control")?.contains("max-age=60") == true)
+            #expect(httpResponse.value(forHTTPHeaderField: "Server") != nil)
+            #expect(httpResponse.value(forHTTPHeaderField: "Date") != nil)
+
+            let (headData, headResponse) = try awaitData(for: request(for: server, method: "HEAD", path: "prebuilt"))
+            #expect((headResponse as? HTTPURLResponse)?.statusCode == 200)
+            #expect((headResponse as? HTTPURLResponse)?.value(forHTTPHeaderField: "Content-Length") == "3")
+            #expect(headData.isEmpty)
+
+            let (_, notModified) = try awaitData(
+                for: request(for: server, path: "prebuilt", headers: ["If-None-Match": "\"44bc2cf5ad770999\""])
+            )
+            #expect((notModified as? HTTPURLResponse)?.statusCode == 304)
+        }
+
+        @Test("Handler can send early hints before the final response")
+        func handlerSendsEarlyHints() throws {
+            let server = DZWebServer()
+            let resultLock = NSLock()
+            var results: [Bool] = []
+            server.addHandler(
+                forMethod: "GET",
+                path: "/hinted",
+                request: DZWebServerRequest.self,
+                processBlock: { request in
+                    let sent = request.sendEarlyHints(withLinks: ["</style.css>; rel=preload; as=style"])
+                    let rejected = request.sendInformationalResponse(withStatusCode: 101, headers: nil)
+                    resultLock.lock()
+                    results = [sent, rejected]
+                    resultLock.unlock()
+                    return DZWebServerDataResponse(text: "final")
+                }
+            )
+
+            try server.start(options: localhostOptions)
+            defer { server.stop() }
+
+            let (data, response) = try awaitData(for: request(for: server, path: "hinted"))
+            #expect((response as? HTTPURLResponse)?.statusCode == 200)
+            #expect(String(data: data, encoding: .utf8) == "final")
+            resultLock.lock()
+            #expect(results == [true, false])
+            resultLock.unlock()
+        }
+
+        @Test("Async handler cannot send early hints once the completion block was called")
+        func earlyHintsRefusedAfterCompletion() throws {
+            let server = DZWebServer()
+            let resultLock = NSLock()
+            var results: [Bool] = []
+            let handlerDone = DispatchSemaphore(value: 0)
+            server.addHandler(
+                forMethod: "GET",
+                path: "/late-hints",
+                request: DZWebServerRequest.self,
+                asyncProcessBlock: { request, completionBlock in
+                    let sent = request.sendEarlyHints(withLinks: ["</style.css>; rel=preload; as=style"])
+                    completionBlock(DZWebServerDataResponse(text: "final"))
+                    let late = request.sendEarlyHints(withLinks: ["</script.js>; rel=preload; as=script"])
+                    resultLock.lock()
+                    results = [sent, late]
+                    resultLock.unlock()
+                    handlerDone.signal()
+                }
+            )
+
+            try server.start(options: localhostOptions)
+            defer { server.stop() }
+
+            let (data, response) = try awaitData(for: request(for: server, path: "late-hints"))
+            #expect((response as? HTTPURLResponse)?.statusCode == 200)
+            #expect(String(data: data, encoding: .utf8) == "final")
+            #expect(handlerDone.wait(timeout: .now() + 5) == .success)
+            resultLock.lock()
+            #expect(results == [true, false])
+            resultLock.unlock()
+        }
+
+        @Test("Chunked response declares trailers and Server-Timing")
+        func chunkedResponseDeclaresTrailers() throws {
+            let server = DZWebServer()
+            server.addHandler(
+                forMethod: "GET",
+                path: "/stream",
+                request: DZWebServerRequest.self,
+                processBlock: { _ in
+                    var chunks = ["hello ", "world"]
+                    let response = DZWebServerStreamedResponse(contentType: "text/plain", streamBlock: { _ in
+                        chunks.isEmpty ? Data() : Data(chunks.removeFirst().utf8)
+                    })
+                    response.declareTrailer("X-Chunk-Count")
+                    response.setValue("2", forTrailer: "X-Chunk-Count")
+                    response.declareTrailer("Content-Length")  // Not allowed in trailers
+                    response.setValue("chunked", forTrailer: "transfer-encoding")
+                    response.isContentDigestTrailerEnabled = true
+                    return response
+                }
+            )
+
+            var options = localhostOptions
+            options[DZWebServerOption_AutomaticallySendServerTiming] = true
+            try server.start(options: options)
+            defer { server.stop() }
+
+            let (data, response) = try awaitData(for: request(for: server, path: "stream"))
+            let httpResponse = try #require(response as? HTTPURLResponse)
+            #expect(httpResponse.statusCode == 200)
+            #expect(String(data: data, encoding: .utf8) == "hello world")
+            #expect(httpResponse.value(forHTTPHeaderField: "Trailer") == "X-Chunk-Count, Digest, Server-Timing")
+            let serverTiming = try #require(httpResponse.value(forHTTPHeaderField: "Server-Timing"))
+            #expect(serverTiming.hasPrefix("parse;dur="))
+            #expect(serverTiming.contains("handler;dur="))
+        }
     }
 
     // MARK: - Server Options
@@ -921,6 +1699,7 @@ struct DZWebServerTests {
             let httpResponse = try #require(response as? HTTPURLResponse)
 
             #expect(httpResponse.statusCode == 401)
+            #expect(httpResponse.value(forHTTPHeaderField: "WWW-Authenticate") == "Basic realm=\"DZWebServer\"")
         }
 
         @Test("Digest auth with correct credentials returns 200")
@@ -1198,6 +1977,33 @@ struct DZWebServerTests {
             #expect(httpResponse.value(forHTTPHeaderField: "X-Custom-Header") == "custom-value")
         }
 
+        @Test("Automatic ETags hash data response bodies and enable 304 revalidation")
+        func automaticETags() throws {
+            let server = DZWebServer()
+            server.addHandler(
+                forMethod: "GET",
+                path: "/api",
+                request: DZWebServerRequest.self,
+                processBlock: { _ in
+                    DZWebServerDataResponse(data: Data("abc".utf8), contentType: "application/json")
+                }
+            )
+
+            var options = localhostOptions
+            options[DZWebServerOption_AutomaticallyComputeETags] = true
+            try server.start(options: options)
+            defer { server.stop() }
+
+            let (_, response) = try awaitData(for: request(for: server, path: "api"))
+            let eTag = (response as? HTTPURLResponse)?.value(forHTTPHeaderField: "ETag")
+            #expect(eTag == "\"44bc2cf5ad770999\"", "ETag should be the quoted XXH64 hash of the body")
+
+            let (_, revalidation) = try awaitData(
+                for: request(for: server, path: "api", headers: ["If-None-Match": "\"44bc2cf5ad770999\""])
+            )
+            #expect((revalidation as? HTTPURLResponse)?.statusCode == 304)
+        }
+
         @Test("Response with custom status code sends that status")
         func customStatusCode() throws {
             let server = DZWebServer()
@@ -1223,6 +2029,186 @@ struct DZWebServerTests {
             #expect(httpResponse.statusCode == 201)
         }
 
+        @Test("Automatic content encoding follows the request Accept-Encoding header")
+        func automaticContentEncoding() throws {
+            let text = String(repeating: "compressible text ", count: 200)
+            let server = DZWebServer()
+            server.addHandler(
+                forMethod: "GET",
+                path: "/auto",
+                request: DZWebServerRequest.self,
+                processBlock: { _ in
+                    let response = DZWebServerDataResponse(text: text)!
+                    response.isAutomaticContentEncodingEnabled = true
+                    return response
+                }
+            )
+
+            var options = localhostOptions
+            options[DZWebServerOption_ContentEncodings] = ["gzip"]
+            try server.start(options: options)
+            defer { server.stop() }
+
+            let url = try #require(server.serverURL?.appendingPathComponent("auto"))
+
+            var gzipRequest = URLRequest(url: url)
+            gzipRequest.setValue("gzip;q=0.8, identity;q=0.5", forHTTPHeaderField: "Accept-Encoding")
+            let (gzipData, gzipResponse) = try awaitData(for: gzipRequest)
+            let gzipHTTPResponse = try #require(gzipResponse as? HTTPURLResponse)
+            #expect(gzipHTTPResponse.value(forHTTPHeaderField: "Content-Encoding") == "gzip")
+            #expect(gzipHTTPResponse.value(forHTTPHeaderField: "Vary") == "Accept-Encoding")
+            #expect(String(data: gzipData, encoding: .utf8) == text)
+
+            var identityRequest = URLRequest(url: url)
+            identityRequest.setValue("identity", forHTTPHeaderField: "Accept-Encoding")
+            let (identityData, identityResponse) = try awaitData(for: identityRequest)
+            let identityHTTPResponse = try #require(identityResponse as? HTTPURLResponse)
+            #expect(identityHTTPResponse.value(forHTTPHeaderField: "Content-Encoding") == nil)
+            #expect(identityHTTPResponse.value(forHTTPHeaderField: "Content-Length") == "\(text.utf8.count)")
+            #expect(String(data: identityData, encoding: .utf8) == text)
+        }
+
+        @Test("Encoded bodies with an ETag are cached and sent with a Content-Length")
+        func encodedContentCache() throws {
+            let text = String(repeating: "cacheable text ", count: 200)
+            let server = DZWebServer()
+            server.addHandler(
+                forMethod: "GET",
+                path: "/cached",
+                request: DZWebServerRequest.self,
+                processBlock: { _ in
+                    let response = DZWebServerDataResponse(text: text)!
+                    response.eTag = "\"cached\""
+                    response.isAutomaticContentEncodingEnabled = true
+                    return response
+                }
+            )
+
+            var options = localhostOptions
+            options[DZWebServerOption_ContentEncodings] = ["gzip"]
+            options[DZWebServerOption_MaxEncodedContentCacheSize] = 1024 * 1024
+            try server.start(options: options)
+            defer { server.stop() }
+
+            var request = try URLRequest(url: #require(server.serverURL?.appendingPathComponent("cached")))
+            request.setValue("gzip", forHTTPHeaderField: "Accept-Encoding")
+            for _ in 0 ..< 2 {
+                let (data, response) = try awaitData(for: request)
+                let httpResponse = try #require(response as? HTTPURLResponse)
+                #expect(httpResponse.value(forHTTPHeaderField: "Content-Encoding") == "gzip")
+                #expect(httpResponse.value(forHTTPHeaderField: "Content-Length") != nil)
+                #expect(httpResponse.value(forHTTPHeaderField: "Transfer-Encoding") == nil)
+                #expect(String(data: data, encoding: .utf8) == text)
+            }
+            #expect(server.compressedResponseCount == 2)
+        }
+
+        @Test("Cached encoded bodies are keyed by resource and query, not only by ETag")
+        func encodedContentCacheKeyedByPath() throws {
+            let server = DZWebServer()
+            server.addHandler(
+                forMethod: "GET",
+                pathRegex: "^/[ab]$",
+                request: DZWebServerRequest.self,
+                processBlock: { request in
+                    let id = request.query?["id"] ?? ""
+                    let response = DZWebServerDataResponse(text: String(repeating: "body of \(request.path)\(id) ", count: 200))!
+                    response.eTag = "\"shared\""
+                    response.isAutomaticContentEncodingEnabled = true
+                    return response
+                }
+            )
+
+            var options = localhostOptions
+            options[DZWebServerOption_ContentEncodings] = ["gzip"]
+            options[DZWebServerOption_MaxEncodedContentCacheSize] = 1024 * 1024
+            try server.start(options: options)
+            defer { server.stop() }
+
+            for (path, id) in [("a", "1"), ("a", "2"), ("b", "")] {
+                let query = id.isEmpty ? "" : "?id=\(id)"
+                var request = try URLRequest(url: #require(URL(string: "\(path)\(query)", relativeTo: server.serverURL)))
+                request.setValue("gzip", forHTTPHeaderField: "Accept-Encoding")
+                let (data, _) = try awaitData(for: request)
+                #expect(String(data: data, encoding: .utf8) == String(repeating: "body of /\(path)\(id) ", count: 200))
+            }
+        }
+
+        @Test("Large bodies are gzipped in parallel blocks into a valid stream")
+        func parallelGZipEncoding() throws {
+            let text = (0 ..< 20000).map { "line \($0) of a generated export\n" }.joined()
+            let server = DZWebServer()
+            server.addHandler(
+                forMethod: "GET",
+                path: "/export",
+                request: DZWebServerRequest.self,
+                processBlock: { _ in
+                    let response = DZWebServerDataResponse(text: text)!
+                    response.isAutomaticContentEncodingEnabled = true
+                    return response
+                }
+            )
+
+            var options = localhostOptions
+            options[DZWebServerOption_ContentEncodings] = ["gzip"]
+            options[DZWebServerOption_ParallelGZipMinimumSize] = 64 * 1024
+            options[DZWebServerOption_ParallelGZipBlockSize] = 16 * 1024
+            options[DZWebServerOption_ParallelGZipMaxBlocksInFlight] = 3
+            try server.start(options: options)
+            defer { server.stop() }
+
+            var request = try URLRequest(url: #require(server.serverURL?.appendingPathComponent("export")))
+            request.setValue("gzip", forHTTPHeaderField: "Accept-Encoding")
+            let (data, response) = try awaitData(for: request)
+            let httpResponse = try #require(response as? HTTPURLResponse)
+            #expect(httpResponse.value(forHTTPHeaderField: "Content-Encoding") == "gzip")
+            #expect(String(data: data, encoding: .utf8) == text)
+        }
+
+        @Test("Automatic content encoding skips small bodies and incompressible types")
+        func automaticContentEncodingPolicy() throws {
+            let server = DZWebServer()
+            server.addHandler(
+                forMethod: "GET",
+                path: "/small",
+                request: DZWebServerRequest.self,
+                processBlock: { _ in
+                    let response = DZWebServerDataResponse(text: "tiny")!
+                    response.isAutomaticContentEncodingEnabled = true
+                    return response
+                }
+            )
+            server.addHandler(
+                forMethod: "GET",
+                path: "/image",
+                request: DZWebServerRequest.self,
+                processBlock: { _ in
+                    let response = DZWebServerDataResponse(data: Data(count: 4096), contentType: "image/png")
+                    response.isAutomaticContentEncodingEnabled = true
+                    return response
+                }
+            )
+
+            var options = localhostOptions
+            options[DZWebServerOption_ContentEncodings] = ["gzip"]
+            options[DZWebServerOption_CompressionMinimumSize] = 100
+            try server.start(options: options)
+            defer { server.stop() }
+
+            for path in ["small", "image"] {
+                var request = try URLRequest(url: #require(server.serverURL?.appendingPathComponent(path)))
+                request.setValue("gzip", forHTTPHeaderField: "Accept-Encoding")
+                let (_, response) = try awaitData(for: request)
+                let httpResponse = try #require(response as? HTTPURLResponse)
+                #expect(httpResponse.value(forHTTPHeaderField: "Content-Encoding") == nil)
+                #expect(httpResponse.value(forHTTPHeaderField: "Content-Length") != nil)
+            }
+
+            #expect(server.compressionSkippedForSizeCount == 1)
+            #expect(server.compressionSkippedForContentTypeCount == 1)
+            #expect(server.compressedResponseCount == 0)
+        }
+
         @Test("Empty response with no content type returns no body")
         func emptyResponseNoBody() throws {
             let server = DZWebServer()
@@ -1398,7 +2384,53 @@ private func awaitData(
 
 // MARK: - Test Helpers
 
+/// Wraps raw deflate output from Foundation into a gzip stream.
+private func gzipData(_ data: Data) throws -> Data {
+    var crc: UInt32 = 0xFFFF_FFFF
+    for byte in data {
+        crc ^= UInt32(byte)
+        for _ in 0 ..< 8 {
+            crc = (crc & 1) != 0 ? (crc >> 1) ^ 0xEDB8_8320 : crc >> 1
+        }
+    }
+    crc ^= 0xFFFF_FFFF
+    let size = UInt32(truncatingIfNeeded: data.count)
+
+    var result = Data([0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03])
+    try result.append((data as NSData).compressed(using: .zlib) as Data)
+    for value in [crc, size] {
+        result.append(contentsOf: (0 ..< 4).map { UInt8(truncatingIfNeeded: value >> ($0 * 8)) })
+    }
+    return result
+}
+
 /// Simple delegate for testing DZWebServerDelegate callbacks.
+/// Stands in for an application-provided decoder by dropping the 4-byte frame magic.
+private final class FrameHeaderStrippingDecoder: NSObject, DZWebServerBodyWriter {
+    private let writer: DZWebServerBodyWriter
+    private var skipped = 0
+
+    init(writer: DZWebServerBodyWriter) {
+        self.writer = writer
+    }
+
+    func open() throws {
+        try writer.open()
+    }
+
+    func write(_ data: Data) throws {
+        let skip = min(4 - skipped, data.count)
+        skipped += skip
+        if data.count > skip {
+            try writer.write(data.dropFirst(skip))
+        }
+    }
+
+    func close() throws {
+        try writer.close()
+    }
+}
+
 private final class TestServerDelegate: NSObject, DZWebServerDelegate {
     var didStartCalled = false
     var didStopCalled = false